@@ -48,7 +48,7 @@ bool CTheApp::OnCreate()
 void CTheApp::OnDestroy()
 {
 	// app is about to close, clear all resources
-	glDeleteProgram(m_uProgram);
+	GetOpenGLRenderer()->DeleteProgram(m_uProgram);
 	glDeleteShader(m_uFragmentShader);
 	glDeleteShader(m_uVertexShader);
 
@@ -69,7 +69,7 @@ void CTheApp::OnDraw(IRenderer* pRenderer)
 	pRenderer->Clear(0.2f, 0.2f, 0.2f, 1.0f);
 
 	// setup the rendering program
-	glUseProgram(m_uProgram);
+	GetOpenGLRenderer()->UseProgram(m_uProgram);
 }
 
 
@@ -22,38 +22,31 @@ CTankPiece::~CTankPiece()
 }
 
 
-void CTankPiece::Render(IRenderer* pRenderer, GLuint uProgram)
+void CTankPiece::Draw(IRenderer* pRenderer, GLuint uProgram)
 {
-	if (m_pGeometry)
-	{
-		const glm::mat4 world = GetWorldMatrix();
-
-		// set model matrix to shader uniform
-		GLint location = glGetUniformLocation(uProgram, "modelMatrix");
-		glUniformMatrix4fv(location, 1, GL_FALSE, &world[0][0]);
-
-		// set model-view-projection matrix to shader uniform
-		glm::mat4 modelViewProjectionMatrix(pRenderer->GetProjectionMatrix() * pRenderer->GetViewMatrix() * world);
-		location = glGetUniformLocation(uProgram, "modelViewProjectionMatrix");
-		glUniformMatrix4fv(location, 1, GL_FALSE, &modelViewProjectionMatrix[0][0]);
-
-		// set the normal matrix
-		glm::mat3 normalMatrix(glm::transpose(glm::inverse(world)));
-		location = glGetUniformLocation(uProgram, "normalMatrix");
-		glUniformMatrix3fv(location, 1, GL_FALSE, &normalMatrix[0][0]);
-
-		m_pGeometry->SetAttribs(uProgram);
-		m_pGeometry->Draw(pRenderer);
-	}
-
-	int32_t i;
-	for (i=0; i<m_arrChildren.size(); i++)
-	{
-		m_arrChildren[i]->Render(pRenderer, uProgram);
-	}
+	static const UniformId modelMatrixId = COpenGLRenderer::GetUniformId("modelMatrix");
+	static const UniformId modelViewProjectionMatrixId = COpenGLRenderer::GetUniformId("modelViewProjectionMatrix");
+	static const UniformId normalMatrixId = COpenGLRenderer::GetUniformId("normalMatrix");
+	COpenGLRenderer* pOpenGLRenderer = static_cast<COpenGLRenderer*>(pRenderer);
 
+	const glm::mat4 world = GetWorldMatrix();
+
+	// set model matrix to shader uniform
+	pOpenGLRenderer->SetUniform(uProgram, modelMatrixId, world);
+
+	// set model-view-projection matrix to shader uniform
+	glm::mat4 modelViewProjectionMatrix(pRenderer->GetProjectionMatrix() * pRenderer->GetViewMatrix() * world);
+	pOpenGLRenderer->SetUniform(uProgram, modelViewProjectionMatrixId, modelViewProjectionMatrix);
+
+	// set the normal matrix
+	glm::mat3 normalMatrix(glm::transpose(glm::inverse(world)));
+	pOpenGLRenderer->SetUniform(uProgram, normalMatrixId, normalMatrix);
+
+	m_pGeometry->SetAttribs(uProgram);
+	m_pGeometry->Draw(pRenderer);
 }
 
+
 void CTankPiece::Update(float fFrametime)
 {
 	IGraphNode::Update(fFrametime);
@@ -25,11 +25,12 @@ public:
 	 * virtual drawing method of the game object
 	 * @param pRenderer pointer to renderer
 	 */
-	void Render(IRenderer* pRenderer, GLuint uProgram) override;
+	void Draw(IRenderer* pRenderer, GLuint uProgram) override;
+
 	void Update(float fFrametime) override;
 
 	inline void SetGeometry(Geometry* pGeometry) { m_pGeometry = pGeometry; }
-	inline Geometry* GetGeometry() { return m_pGeometry; }
+	inline Geometry* GetGeometry() const override { return m_pGeometry; }
 
 protected:
 	Geometry*		m_pGeometry;
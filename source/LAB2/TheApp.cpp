@@ -111,8 +111,8 @@ void CTheApp::OnDestroy()
 		m_pSceneRoot = nullptr;
 	}
 
-	glDeleteTextures(1, &m_uTexture);
-	glDeleteProgram(m_uProgram);
+	GetOpenGLRenderer()->DeleteTexture(m_uTexture);
+	GetOpenGLRenderer()->DeleteProgram(m_uProgram);
 	glDeleteShader(m_uFragmentShader);
 	glDeleteShader(m_uVertexShader);
 
@@ -214,6 +214,12 @@ void CTheApp::OnUpdate(float fFrametime)
 
 		cannon->SetMatrix(cannonDown);
 	}
+
+	// resolve the world matrices of the moved tank pieces once for drawing
+	if (m_pSceneRoot)
+	{
+		m_pSceneRoot->UpdateWorldMatrices();
+	}
 }
 
 //TODO: Add the whole code of void:CTheApp::CheckCubeCollusions() et. al., for reference check lesson03 code.
@@ -229,11 +235,10 @@ void CTheApp::OnDraw(IRenderer* pRenderer)
 	GetRenderer()->SetProjectionMatrix(m_mProjection);
 
 	// setup the rendering of our quad
-	glUseProgram(m_uProgram);
+	GetOpenGLRenderer()->UseProgram(m_uProgram);
 
 	// set the texture for the quad (slot 0)
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_uTexture);
+	GetOpenGLRenderer()->BindTexture(0, m_uTexture);
 
 	// the textures are bind as uniforms into the program
 	GLint location = glGetUniformLocation(m_uProgram, "texture01");
@@ -249,7 +254,7 @@ void CTheApp::OnDraw(IRenderer* pRenderer)
 	glUniform3f(location, campos.x, campos.y, campos.z);
 
 	// set material to program
-	m_Material.SetToProgram(m_uProgram);
+	m_Material.SetToProgram(GetOpenGLRenderer(), m_uProgram);
 
 	// set the geometry attributes for tank base
 	m_CubeBase.SetAttribs(m_uProgram);
@@ -55,7 +55,7 @@ bool CTheApp::OnCreate()
 void CTheApp::OnDestroy()
 {
 	// app is about to close, clear all resources
-	glDeleteProgram(m_uProgram);
+	GetOpenGLRenderer()->DeleteProgram(m_uProgram);
 	glDeleteShader(m_uFragmentShader);
 	glDeleteShader(m_uVertexShader);
 
@@ -91,7 +91,7 @@ void CTheApp::OnDraw(IRenderer* pRenderer)
 	pRenderer->Clear(0.2f, 0.2f, 0.2f, 1.0f);
 
 	// setup the rendering program
-	glUseProgram(m_uProgram);
+	GetOpenGLRenderer()->UseProgram(m_uProgram);
 
 	// get the vertex attribute locations
 	GLint position = glGetAttribLocation(m_uProgram, "position");
@@ -111,8 +111,7 @@ void CTheApp::OnDraw(IRenderer* pRenderer)
 	glEnableVertexAttribArray(uv);
 	glVertexAttribPointer(uv, 2, GL_FLOAT, GL_FALSE, TRIANGLEVERTEX::GetStride(), (float*)m_Triangle + 3);
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_uTexture);
+	GetOpenGLRenderer()->BindTexture(0, m_uTexture);
 	
 	GLint texture01 = glGetUniformLocation(m_uProgram, "texture01");
 	glUniform1i(texture01, 0);
@@ -38,8 +38,14 @@ bool CTheApp::OnCreate()
 	m_uVertexShader = GetOpenGLRenderer()->CreateVertexShaderFromFile("multitexturing.vs");
 	m_uFragmentShader = GetOpenGLRenderer()->CreateFragmentShaderFromFile("multitexturing.fs");
 	m_uProgram = GetOpenGLRenderer()->CreateProgram(m_uVertexShader, m_uFragmentShader);
-	m_uTexture[0] = GetOpenGLRenderer()->CreateTexture("box.png");
-	m_uTexture[1] = GetOpenGLRenderer()->CreateTexture("box_specular.png");
+
+	// box faces tile, mipmaps keep them from shimmering when small
+	TEXTUREPARAMS params;
+	params.eMipmaps = MIPMAPS_GPU;
+	params.eFilter = FILTER_TRILINEAR;
+	params.eWrap = GL_REPEAT;
+	m_uTexture[0] = GetOpenGLRenderer()->CreateTexture("box.png", params);
+	m_uTexture[1] = GetOpenGLRenderer()->CreateTexture("box_specular.png", params);
 	if (!m_uVertexShader || !m_uFragmentShader || !m_uProgram || !m_uTexture[0] || !m_uTexture[1])
 	{
 		return false;
@@ -85,11 +91,12 @@ void CTheApp::OnDestroy()
 		m_pSceneRoot = nullptr;
 	}
 
-	glDeleteProgram(m_uProgram);
+	GetOpenGLRenderer()->DeleteProgram(m_uProgram);
 	glDeleteShader(m_uFragmentShader);
 	glDeleteShader(m_uVertexShader);
 
-	glDeleteTextures(2, m_uTexture);
+	GetOpenGLRenderer()->DeleteTexture(m_uTexture[0]);
+	GetOpenGLRenderer()->DeleteTexture(m_uTexture[1]);
 
 	m_uVertexShader = 0;
 	m_uFragmentShader = 0;
@@ -103,6 +110,7 @@ void CTheApp::OnUpdate(float fFrametime)
 	if (m_pSceneRoot)
 	{
 		m_pSceneRoot->Update(fFrametime);
+		m_pSceneRoot->UpdateWorldMatrices();
 	}
 }
 
@@ -117,22 +125,16 @@ void CTheApp::OnDraw(IRenderer* pRenderer)
 	GetRenderer()->SetProjectionMatrix(m_mProjection);
 
 	// setup the rendering program
-	glUseProgram(m_uProgram);
+	GetOpenGLRenderer()->UseProgram(m_uProgram);
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_uTexture[0]);
+	GetOpenGLRenderer()->BindTexture(0, m_uTexture[0]);
 	GLint location = glGetUniformLocation(m_uProgram, "texture01");
 	glUniform1i(location, 0);
 
-	SetTexturingParams();
-
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D, m_uTexture[1]);
+	GetOpenGLRenderer()->BindTexture(1, m_uTexture[1]);
 	location = glGetUniformLocation(m_uProgram, "texture02");
 	glUniform1i(location, 1);
 
-	SetTexturingParams();
-
 	// setup the light position (to camera position)
 	const glm::vec3 campos(-pRenderer->GetViewMatrix()[3]);
 	location = glGetUniformLocation(m_uProgram, "lightPosition");
@@ -149,15 +151,6 @@ void CTheApp::OnDraw(IRenderer* pRenderer)
 	}
 }
 
-void CTheApp::SetTexturingParams()
-{
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-}
-
-
 void CTheApp::OnScreenSizeChanged(uint32_t uWidthPixels, uint32_t uHeightPixels)
 {
 	m_mProjection = glm::perspective(0.7f, GetAspect(), 0.1f, 500.0f);
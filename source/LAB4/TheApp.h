@@ -103,8 +103,6 @@ private:
 	COpenGLRenderer* GetOpenGLRenderer() { return static_cast<COpenGLRenderer*>(GetRenderer()); }
 
 private:
-	void SetTexturingParams();
-
 	// app data
 	GLuint			m_uVertexShader;
 	GLuint			m_uFragmentShader;
@@ -15,6 +15,7 @@ CTerrain::CTerrain()
 {
 	m_pGeometry = nullptr;
 	m_uTexture = 0;
+	m_pMaterial = nullptr;
 }
 
 
@@ -23,56 +24,64 @@ CTerrain::~CTerrain()
 }
 
 
-void CTerrain::Render(IRenderer* pRenderer, GLuint uProgram)
+void CTerrain::Draw(IRenderer* pRenderer, GLuint uProgram)
 {
-	if (m_pGeometry)
+	static const UniformId modelMatrixId = COpenGLRenderer::GetUniformId("modelMatrix");
+	static const UniformId modelViewProjectionMatrixId = COpenGLRenderer::GetUniformId("modelViewProjectionMatrix");
+	static const UniformId normalMatrixId = COpenGLRenderer::GetUniformId("normalMatrix");
+	COpenGLRenderer* pOpenGLRenderer = static_cast<COpenGLRenderer*>(pRenderer);
+
+	// disable the alpha blending
+	pOpenGLRenderer->SetBlend(false);
+
+	const glm::mat4 world = GetWorldMatrix();
+
+	// set model matrix to shader uniform
+	pOpenGLRenderer->SetUniform(uProgram, modelMatrixId, world);
+
+	// set model-view-projection matrix to shader uniform
+	glm::mat4 modelViewProjectionMatrix(pRenderer->GetProjectionMatrix() * pRenderer->GetViewMatrix() * world);
+	pOpenGLRenderer->SetUniform(uProgram, modelViewProjectionMatrixId, modelViewProjectionMatrix);
+
+	// set the normal matrix
+	glm::mat3 normalMatrix(glm::transpose(glm::inverse(world)));
+	pOpenGLRenderer->SetUniform(uProgram, normalMatrixId, normalMatrix);
+
+	if (m_uTexture)
+	{
+		// set the texture for the program (slot 0)
+		pOpenGLRenderer->BindTexture(0, m_uTexture);
+
+		// the textures are bind as uniforms into the program
+		static const UniformId texture01Id = COpenGLRenderer::GetUniformId("texture01");
+		pOpenGLRenderer->SetUniform(uProgram, texture01Id, 0);
+	}
+
+	if (m_pMaterial)
 	{
-		// disable the alpha blending
-		glDisable(GL_BLEND);
-
-		const glm::mat4 world = GetWorldMatrix();
-
-		// set model matrix to shader uniform
-		GLint location = glGetUniformLocation(uProgram, "modelMatrix");
-		glUniformMatrix4fv(location, 1, GL_FALSE, &world[0][0]);
-
-		// set model-view-projection matrix to shader uniform
-		glm::mat4 modelViewProjectionMatrix(pRenderer->GetProjectionMatrix() * pRenderer->GetViewMatrix() * world);
-		location = glGetUniformLocation(uProgram, "modelViewProjectionMatrix");
-		glUniformMatrix4fv(location, 1, GL_FALSE, &modelViewProjectionMatrix[0][0]);
-
-		// set the normal matrix
-		glm::mat3 normalMatrix(glm::transpose(glm::inverse(world)));
-		location = glGetUniformLocation(uProgram, "normalMatrix");
-		glUniformMatrix3fv(location, 1, GL_FALSE, &normalMatrix[0][0]);
-
-		if (m_uTexture)
-		{
-			// set the texture for the program (slot 0)
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, m_uTexture);
-
-			// the textures are bind as uniforms into the program
-			GLint location = glGetUniformLocation(uProgram, "texture01");
-			glUniform1i(location, 0);
-		}
-
-		if (m_pMaterial)
-		{
-			m_pMaterial->SetToProgram(uProgram);
-		}
-
-		m_pGeometry->SetAttribs(uProgram);
-		m_pGeometry->Draw(pRenderer);
+		m_pMaterial->SetToProgram(pOpenGLRenderer, uProgram);
 	}
 
-	int32_t i;
-	for (i=0; i<m_arrChildren.size(); i++)
+	m_pGeometry->SetAttribs(uProgram);
+	m_pGeometry->Draw(pRenderer);
+}
+
+void CTerrain::Enqueue(RenderQueue& queue, GLuint uProgram)
+{
+	if (!IsSubtreeVisible())
 	{
-		m_arrChildren[i]->Render(pRenderer, uProgram);
+		return;
 	}
+
+	if (m_pGeometry && IsVisible())
+	{
+		queue.Add(uProgram, &m_Textures, m_pMaterial, m_pGeometry, GetWorldMatrix());
+	}
+
+	IGraphNode::Enqueue(queue, uProgram);
 }
 
+
 void CTerrain::SetRotation(float angle, glm::vec3 axis) {
 		SetMatrix(glm::rotate(GetMatrix(), glm::radians(angle), glm::normalize(axis)));
 	}
@@ -13,6 +13,7 @@
 #include "../core/include/IGraphNode.h"
 #include "../core/include/Geometry.h"
 #include "../core/include/Material.h"
+#include "../core/include/RenderQueue.h"
 
 class CTerrain : public IGraphNode
 {
@@ -25,13 +26,27 @@ public:
 	 * virtual drawing method of the game object
 	 * @param pRenderer pointer to renderer
 	 */
-	void Render(IRenderer* pRenderer, GLuint uProgram) override;
+	void Draw(IRenderer* pRenderer, GLuint uProgram) override;
+
+	/**
+	 * Enqueue
+	 * add the terrain piece into the render queue
+	 * @param queue queue to add the draw packet into
+	 * @param uProgram handle to shader program
+	 */
+	void Enqueue(RenderQueue& queue, GLuint uProgram) override;
+
 	void SetRotation(float angle, glm::vec3 axis);
 
 	inline void SetGeometry(Geometry* pGeometry) { m_pGeometry = pGeometry; }
-	inline Geometry* GetGeometry() { return m_pGeometry; }
-
-	inline void SetTexture(GLuint uTexture) { m_uTexture = uTexture; }
+	inline Geometry* GetGeometry() const override { return m_pGeometry; }
+
+	inline void SetTexture(GLuint uTexture)
+	{
+		m_uTexture = uTexture;
+		m_Textures.arrTextures[0] = uTexture;
+		m_Textures.uCount = uTexture ? 1 : 0;
+	}
 	inline GLuint GetTexture() const { return m_uTexture; }
 
 	Material* GetMaterial() { return m_pMaterial; }
@@ -40,6 +55,7 @@ public:
 protected:
 	Geometry*		m_pGeometry;
 	GLuint			m_uTexture;
+	TEXTURESET		m_Textures;
 	Material*		m_pMaterial;
 };
 
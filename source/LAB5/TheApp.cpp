@@ -21,6 +21,7 @@ CTheApp::CTheApp()
 	m_uTexture[1] = 0;
 
 	m_pSceneRoot = nullptr;
+	m_fStatsTime = 0.0f;
 
 	// seed the random number generator
 	RandSeed();
@@ -38,8 +39,19 @@ bool CTheApp::OnCreate()
 	m_uVertexShader = GetOpenGLRenderer()->CreateVertexShaderFromFile("phongshader.vs");
 	m_uFragmentShader = GetOpenGLRenderer()->CreateFragmentShaderFromFile("phongshader.fs");
 	m_uProgram = GetOpenGLRenderer()->CreateProgram(m_uVertexShader, m_uFragmentShader);
-	m_uTexture[0] = GetOpenGLRenderer()->CreateTexture("terrain.jpg");
-	m_uTexture[1] = GetOpenGLRenderer()->CreateTexture("grass.png");
+
+	// terrain is seen at grazing angles, filter it anisotropically
+	TEXTUREPARAMS terrainParams;
+	terrainParams.eMipmaps = MIPMAPS_KAISER;
+	terrainParams.eFilter = FILTER_TRILINEAR;
+	terrainParams.fAnisotropy = 8.0f;
+	terrainParams.eWrap = GL_REPEAT;
+	m_uTexture[0] = GetOpenGLRenderer()->CreateTexture("terrain.jpg", terrainParams);
+
+	TEXTUREPARAMS grassParams;
+	grassParams.eMipmaps = MIPMAPS_BOX;
+	grassParams.eFilter = FILTER_TRILINEAR;
+	m_uTexture[1] = GetOpenGLRenderer()->CreateTexture("grass.png", grassParams);
 
 	if (!m_uVertexShader || !m_uFragmentShader || !m_uProgram)
 	{
@@ -110,7 +122,7 @@ void CTheApp::OnDestroy()
 		m_pSceneRoot = nullptr;
 	}
 
-	glDeleteProgram(m_uProgram);
+	GetOpenGLRenderer()->DeleteProgram(m_uProgram);
 	glDeleteShader(m_uFragmentShader);
 	glDeleteShader(m_uVertexShader);
 
@@ -126,6 +138,7 @@ void CTheApp::OnUpdate(float fFrametime)
 	if (m_pSceneRoot)
 	{
 		m_pSceneRoot->Update(fFrametime);
+		m_pSceneRoot->UpdateWorldMatrices();
 	}
 }
 
@@ -140,16 +153,14 @@ void CTheApp::OnDraw(IRenderer* pRenderer)
 	GetRenderer()->SetProjectionMatrix(m_mProjection);
 
 	// setup the rendering program
-	glUseProgram(m_uProgram);
+	GetOpenGLRenderer()->UseProgram(m_uProgram);
 
 	// TODO: set material uniforms to program
 
 	/*glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, m_uTexture);
 	GLint location = glGetUniformLocation(m_uProgram, "texture01");
-	glUniform1i(location, 0);
-
-	SetTexturingParams();*/
+	glUniform1i(location, 0);*/
 
 	// setup the light position (above scene)
 	const glm::vec3 campos(-pRenderer->GetViewMatrix()[3]);
@@ -161,22 +172,28 @@ void CTheApp::OnDraw(IRenderer* pRenderer)
 	location = glGetUniformLocation(m_uProgram, "cameraPosition");
 	glUniform3f(location, campos.x, campos.y, campos.z);
 
-	// draw the scenegraph
+	// terrain is opaque
+	GetOpenGLRenderer()->SetBlend(false);
+
+	// draw the scenegraph sorted by state
 	if (m_pSceneRoot)
 	{
-		m_pSceneRoot->Render(pRenderer, m_uProgram);
+		m_RenderQueue.Clear();
+		m_pSceneRoot->Enqueue(m_RenderQueue, m_uProgram);
+		m_RenderQueue.Sort();
+		m_RenderQueue.Submit(GetOpenGLRenderer());
 	}
-}
 
-void CTheApp::SetTexturingParams()
-{
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// report the state changes once per second
+	m_fStatsTime += GetFrameTime();
+	if (m_fStatsTime > 1.0f)
+	{
+		m_fStatsTime = 0.0f;
+		IApplication::Debug("State changes unsorted: " + std::to_string(m_RenderQueue.GetUnsortedStateChanges()) +
+			", sorted: " + std::to_string(m_RenderQueue.GetSortedStateChanges()) + "\n");
+	}
 }
 
-
 void CTheApp::OnScreenSizeChanged(uint32_t uWidthPixels, uint32_t uHeightPixels)
 {
 	m_mProjection = glm::perspective(0.7f, GetAspect(), 0.1f, 500.0f);
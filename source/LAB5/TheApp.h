@@ -104,8 +104,6 @@ private:
 	COpenGLRenderer* GetOpenGLRenderer() { return static_cast<COpenGLRenderer*>(GetRenderer()); }
 
 private:
-	void SetTexturingParams();
-
 	// app data
 	GLuint			m_uVertexShader;
 	GLuint			m_uFragmentShader;
@@ -129,5 +127,9 @@ private:
 
 	// SceneGraph
 	IGraphNode*		m_pSceneRoot;
+
+	// draw packets of the scenegraph, sorted by state
+	RenderQueue		m_RenderQueue;
+	float			m_fStatsTime;
 };
 
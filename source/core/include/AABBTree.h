@@ -0,0 +1,174 @@
+/**
+ * ============================================================================
+ *  Name        : AABBTree.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : dynamic bounding volume hierarchy of fat AABBs
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/Bounds.h"
+#include <vector>
+
+class AABBTree
+{
+public:
+	static const int32_t NULL_NODE = -1;
+
+	struct PAIR
+	{
+		int32_t		iFirst;
+		int32_t		iSecond;
+	};
+
+	AABBTree();
+	~AABBTree();
+
+	/**
+	 * SetMargin
+	 * boxes are stored enlarged by the margin, so objects can move that much
+	 * before their proxy is moved in the tree
+	 * @param fMargin margin in world units
+	 */
+	inline void SetMargin(float fMargin) { m_fMargin = fMargin; }
+	inline float GetMargin() const { return m_fMargin; }
+
+	/**
+	 * Clear
+	 * remove all proxies
+	 */
+	void Clear();
+
+	/**
+	 * CreateProxy
+	 * insert a box into the tree
+	 * @param box tight bounds of the object
+	 * @param pUserData pointer returned by GetUserData
+	 * @return proxy id, stays valid until DestroyProxy
+	 */
+	int32_t CreateProxy(const AABB& box, void* pUserData);
+
+	/**
+	 * DestroyProxy
+	 * remove a box from the tree
+	 * @param iProxy id from CreateProxy
+	 */
+	void DestroyProxy(int32_t iProxy);
+
+	/**
+	 * MoveProxy
+	 * update the bounds of a proxy. Nothing is done while the box stays
+	 * inside its fat box, otherwise the proxy is reinserted.
+	 * @param iProxy id from CreateProxy
+	 * @param box new tight bounds of the object
+	 * @return true if the proxy was reinserted
+	 */
+	bool MoveProxy(int32_t iProxy, const AABB& box);
+
+	inline void* GetUserData(int32_t iProxy) const { return m_arrNodes[iProxy].pUserData; }
+	inline const AABB& GetFatBox(int32_t iProxy) const { return m_arrNodes[iProxy].box; }
+	inline uint32_t GetProxyCount() const { return m_uProxyCount; }
+
+	/**
+	 * GetHeight
+	 * @return height of the tree, 0 for a single proxy
+	 */
+	inline int32_t GetHeight() const { return (m_iRoot == NULL_NODE) ? 0 : m_arrNodes[m_iRoot].iHeight; }
+
+	/**
+	 * QueryFrustum
+	 * find the proxies whose fat boxes are inside or intersect the frustum.
+	 * Subtrees completely inside are added without testing their boxes.
+	 * @param frustum frustum to test
+	 * @param arrProxies receives the proxy ids, cleared first
+	 */
+	void QueryFrustum(const FRUSTUM& frustum, std::vector<int32_t>& arrProxies) const;
+
+	/**
+	 * QueryBox
+	 * find the proxies whose fat boxes overlap a box
+	 * @param box box to test
+	 * @param arrProxies receives the proxy ids, cleared first
+	 */
+	void QueryBox(const AABB& box, std::vector<int32_t>& arrProxies) const;
+
+	/**
+	 * QuerySphere
+	 * find the proxies whose fat boxes overlap a sphere
+	 * @param vCenter center of the sphere
+	 * @param fRadius radius of the sphere
+	 * @param arrProxies receives the proxy ids, cleared first
+	 */
+	void QuerySphere(const glm::vec3& vCenter, float fRadius, std::vector<int32_t>& arrProxies) const;
+
+	/**
+	 * QueryRay
+	 * find the proxies whose fat boxes are hit by a ray segment. The boxes
+	 * are only candidates, test the actual shapes of the objects.
+	 * @param vOrigin start of the ray
+	 * @param vDirection direction of the ray, does not need to be normalized
+	 * @param fMaxDistance length of the segment in units of vDirection
+	 * @param arrProxies receives the proxy ids, cleared first
+	 */
+	void QueryRay(const glm::vec3& vOrigin, const glm::vec3& vDirection, float fMaxDistance, std::vector<int32_t>& arrProxies) const;
+
+	/**
+	 * QueryPairs
+	 * find all pairs of proxies with overlapping fat boxes
+	 * @param arrPairs receives the pairs, iFirst is always smaller than iSecond
+	 */
+	void QueryPairs(std::vector<PAIR>& arrPairs) const;
+
+private:
+	struct NODE
+	{
+		inline bool IsLeaf() const { return iChild1 == NULL_NODE; }
+
+		AABB		box;
+		void*		pUserData;
+
+		// next node in the free list when the node is not in use
+		int32_t		iParent;
+		int32_t		iChild1;
+		int32_t		iChild2;
+
+		// leaves are at 0, free nodes at -1
+		int32_t		iHeight;
+	};
+
+	int32_t AllocateNode();
+	void FreeNode(int32_t iNode);
+
+	void InsertLeaf(int32_t iLeaf);
+	void RemoveLeaf(int32_t iLeaf);
+
+	/**
+	 * Balance
+	 * rotate the taller child of a node up if the children heights differ
+	 * by more than one
+	 * @param iA node to balance
+	 * @return node now at the place of iA
+	 */
+	int32_t Balance(int32_t iA);
+
+	/**
+	 * Refit
+	 * balance and recompute bounds and heights from a node up to the root
+	 */
+	void Refit(int32_t iNode);
+
+	/**
+	 * AddLeaves
+	 * add all leaves of a subtree to the array
+	 */
+	void AddLeaves(int32_t iNode, std::vector<int32_t>& arrProxies, std::vector<int32_t>& arrStack) const;
+
+	std::vector<NODE>			m_arrNodes;
+	int32_t						m_iRoot;
+	int32_t						m_iFreeList;
+	uint32_t					m_uProxyCount;
+	float						m_fMargin;
+};
@@ -0,0 +1,247 @@
+/**
+ * ============================================================================
+ *  Name        : Bounds.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : bounding volumes and view frustum tests
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/IRenderer.h"
+
+// result of testing a volume against a frustum
+enum CULLRESULT
+{
+	CULL_OUTSIDE,
+	CULL_INTERSECT,
+	CULL_INSIDE
+};
+
+struct AABB
+{
+	AABB()
+	{
+		vMin = glm::vec3(0.0f);
+		vMax = glm::vec3(0.0f);
+	}
+	AABB(const glm::vec3& _vMin, const glm::vec3& _vMax)
+	{
+		vMin = _vMin;
+		vMax = _vMax;
+	}
+
+	inline glm::vec3 GetCenter() const { return (vMin + vMax) * 0.5f; }
+
+	/**
+	 * GetExtents
+	 * @return half size of the box
+	 */
+	inline glm::vec3 GetExtents() const { return (vMax - vMin) * 0.5f; }
+
+	/**
+	 * GetSurfaceArea
+	 * @return surface area of the box, the cost of a box in the AABB tree
+	 */
+	inline float GetSurfaceArea() const
+	{
+		const glm::vec3 d(vMax - vMin);
+		return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+
+	/**
+	 * Contains
+	 * @return true if box is completely inside this box
+	 */
+	inline bool Contains(const AABB& box) const
+	{
+		return vMin.x <= box.vMin.x && vMin.y <= box.vMin.y && vMin.z <= box.vMin.z &&
+			box.vMax.x <= vMax.x && box.vMax.y <= vMax.y && box.vMax.z <= vMax.z;
+	}
+
+	/**
+	 * Overlaps
+	 * @return true if the boxes touch or overlap
+	 */
+	inline bool Overlaps(const AABB& box) const
+	{
+		return vMin.x <= box.vMax.x && box.vMin.x <= vMax.x &&
+			vMin.y <= box.vMax.y && box.vMin.y <= vMax.y &&
+			vMin.z <= box.vMax.z && box.vMin.z <= vMax.z;
+	}
+
+	/**
+	 * Merge
+	 * @return the smallest box containing both boxes
+	 */
+	static inline AABB Merge(const AABB& a, const AABB& b)
+	{
+		return AABB(glm::min(a.vMin, b.vMin), glm::max(a.vMax, b.vMax));
+	}
+
+	/**
+	 * Transform
+	 * @param m matrix to transform the box with
+	 * @return axis aligned box containing the transformed box
+	 */
+	inline AABB Transform(const glm::mat4& m) const
+	{
+		// extents along each world axis are the absolute sums of the rotated extents
+		const glm::vec3 vCenter(m * glm::vec4(GetCenter(), 1.0f));
+		const glm::vec3 vExtents(GetExtents());
+		const glm::vec3 vWorldExtents(
+			glm::abs(glm::vec3(m[0])) * vExtents.x +
+			glm::abs(glm::vec3(m[1])) * vExtents.y +
+			glm::abs(glm::vec3(m[2])) * vExtents.z);
+		return AABB(vCenter - vWorldExtents, vCenter + vWorldExtents);
+	}
+
+	glm::vec3	vMin;
+	glm::vec3	vMax;
+};
+
+
+struct SPHERE
+{
+	SPHERE()
+	{
+		vCenter = glm::vec3(0.0f);
+		fRadius = 0.0f;
+	}
+	SPHERE(const glm::vec3& _vCenter, float _fRadius)
+	{
+		vCenter = _vCenter;
+		fRadius = _fRadius;
+	}
+
+	/**
+	 * Merge
+	 * @return the smallest sphere containing both spheres
+	 */
+	static inline SPHERE Merge(const SPHERE& a, const SPHERE& b)
+	{
+		const glm::vec3 d(b.vCenter - a.vCenter);
+		const float fDistance = glm::length(d);
+		if (fDistance + b.fRadius <= a.fRadius)
+		{
+			return a;
+		}
+		if (fDistance + a.fRadius <= b.fRadius)
+		{
+			return b;
+		}
+
+		const float fRadius = (fDistance + a.fRadius + b.fRadius) * 0.5f;
+		return SPHERE(a.vCenter + d * ((fRadius - a.fRadius) / fDistance), fRadius);
+	}
+
+	/**
+	 * Transform
+	 * @param m matrix to transform the sphere with
+	 * @return sphere containing the transformed sphere, radius is scaled by
+	 * the largest scale of the matrix
+	 */
+	inline SPHERE Transform(const glm::mat4& m) const
+	{
+		const float fScaleSq = glm::max(glm::max(
+			glm::dot(glm::vec3(m[0]), glm::vec3(m[0])),
+			glm::dot(glm::vec3(m[1]), glm::vec3(m[1]))),
+			glm::dot(glm::vec3(m[2]), glm::vec3(m[2])));
+		return SPHERE(glm::vec3(m * glm::vec4(vCenter, 1.0f)), fRadius * sqrtf(fScaleSq));
+	}
+
+	glm::vec3	vCenter;
+	float		fRadius;
+};
+
+
+struct FRUSTUM
+{
+	FRUSTUM()
+	{
+	}
+	explicit FRUSTUM(const glm::mat4& mViewProjection)
+	{
+		Extract(mViewProjection);
+	}
+
+	/**
+	 * Extract
+	 * build the six planes from a view projection matrix. Planes face inwards
+	 * and are normalized, so plane distances are in world units.
+	 * @param mViewProjection projection * view matrix
+	 */
+	inline void Extract(const glm::mat4& mViewProjection)
+	{
+		const glm::mat4 m(glm::transpose(mViewProjection));
+		arrPlanes[0] = m[3] + m[0];		// left
+		arrPlanes[1] = m[3] - m[0];		// right
+		arrPlanes[2] = m[3] + m[1];		// bottom
+		arrPlanes[3] = m[3] - m[1];		// top
+		arrPlanes[4] = m[3] + m[2];		// near
+		arrPlanes[5] = m[3] - m[2];		// far
+		for (uint32_t i=0; i<6; i++)
+		{
+			arrPlanes[i] /= glm::length(glm::vec3(arrPlanes[i]));
+		}
+	}
+
+	/**
+	 * Classify
+	 * @param box box to test
+	 * @return CULL_INSIDE if the box is completely inside, CULL_OUTSIDE if it
+	 * is completely outside of one plane, CULL_INTERSECT otherwise
+	 */
+	inline CULLRESULT Classify(const AABB& box) const
+	{
+		const glm::vec3 vCenter(box.GetCenter());
+		const glm::vec3 vExtents(box.GetExtents());
+
+		CULLRESULT eResult = CULL_INSIDE;
+		for (uint32_t i=0; i<6; i++)
+		{
+			const glm::vec3 vNormal(arrPlanes[i]);
+			const float fDistance = glm::dot(vNormal, vCenter) + arrPlanes[i].w;
+			const float fRadius = glm::dot(glm::abs(vNormal), vExtents);
+			if (fDistance < -fRadius)
+			{
+				return CULL_OUTSIDE;
+			}
+			if (fDistance < fRadius)
+			{
+				eResult = CULL_INTERSECT;
+			}
+		}
+		return eResult;
+	}
+
+	/**
+	 * Classify
+	 * @param sphere sphere to test
+	 * @return CULL_INSIDE, CULL_OUTSIDE or CULL_INTERSECT as for boxes
+	 */
+	inline CULLRESULT Classify(const SPHERE& sphere) const
+	{
+		CULLRESULT eResult = CULL_INSIDE;
+		for (uint32_t i=0; i<6; i++)
+		{
+			const float fDistance = glm::dot(glm::vec3(arrPlanes[i]), sphere.vCenter) + arrPlanes[i].w;
+			if (fDistance < -sphere.fRadius)
+			{
+				return CULL_OUTSIDE;
+			}
+			if (fDistance < sphere.fRadius)
+			{
+				eResult = CULL_INTERSECT;
+			}
+		}
+		return eResult;
+	}
+
+	inline bool Intersects(const AABB& box) const { return Classify(box) != CULL_OUTSIDE; }
+	inline bool Intersects(const SPHERE& sphere) const { return Classify(sphere) != CULL_OUTSIDE; }
+
+	glm::vec4	arrPlanes[6];
+};
@@ -11,7 +11,11 @@
 #pragma once
 
 #include <vector>
+#include <map>
 #include "../include/OpenGLRenderer.h"
+#include "../include/Bounds.h"
+#include "../include/MeshFile.h"
+#include "../include/VertexFormat.h"
 
 struct VERTEX
 {
@@ -58,7 +62,8 @@ public:
 
 	/**
 	 * GenSphere
-	 * generate sphere. Sphere is single triangle strip, no indexing
+	 * generate sphere. Sphere is an indexed triangle list with shared vertices,
+	 * triangles are ordered for the post transform vertex cache
 	 * @param vRadius radius
 	 * @param vOffset offset
 	 * @param uRings number of rings in geometry
@@ -82,25 +87,196 @@ public:
 	 */
 	void GenQuad(const glm::vec2& vSize, const glm::vec3& vOffset);
 
+	/**
+	 * Create
+	 * create the geometry from an indexed triangle list, for example one
+	 * processed with MeshOptimizer::Optimize
+	 * @param arrVertices vertices
+	 * @param arrIndices triangle list indices
+	 */
+	void Create(const std::vector<VERTEX>& arrVertices, const std::vector<uint32_t>& arrIndices);
+
+	/**
+	 * Load
+	 * load a binary mesh file written by meshconv. The file is memory mapped
+	 * and its vertex and index blobs are handed to the driver as they are,
+	 * without parsing or copying. No cpu side copy is kept, GetData returns nullptr.
+	 * @param strFilename mesh file
+	 * @return true if successful
+	 */
+	bool Load(const std::string& strFilename);
+
+	/**
+	 * Quantize
+	 * re-upload the vertex buffer in a compact layout, 16 bytes per vertex
+	 * with the default VERTEXLAYOUT instead of 32. Needs the cpu side copy of
+	 * the vertices, call before ReleaseVertexData. Octahedral normals and
+	 * int16 positions have to be decoded by the shader, see VertexFormat.h.
+	 * @param layout vertex layout to use
+	 * @return false if the vertices are released or the driver lacks the
+	 * vertex types, geometry keeps its float vertices then
+	 */
+	bool Quantize(const VERTEXLAYOUT& layout);
+
+	/**
+	 * GetPositionTransform
+	 * @return matrix from the POSITION_INT16 -1..1 range to model space,
+	 * to be multiplied into the model matrix. Identity for other layouts.
+	 */
+	glm::mat4 GetPositionTransform() const;
+
+	/**
+	 * HasOctahedralNormal
+	 * @return true if the normals are NORMAL_OCTAHEDRAL and the shader has to decode them
+	 */
+	inline bool HasOctahedralNormal() const { return m_bOctahedralNormal; }
+
+	/**
+	 * ReleaseVertexData
+	 * free the cpu side copy of the vertices. Geometry keeps drawing from
+	 * its vertex buffer, but GetData returns nullptr after this call.
+	 */
+	void ReleaseVertexData();
+
+	/**
+	 * SetAttribs
+	 * bind the vertex array of this geometry for the program. Vertex array is
+	 * built the first time the geometry is used with the program.
+	 * @param uProgram program to render with
+	 */
 	void SetAttribs(GLuint uProgram) const;
+
+	/**
+	 * DisableAttribs
+	 * unbind the vertex array
+	 * @param uProgram program used with SetAttribs
+	 */
 	void DisableAttribs(GLuint uProgram) const;
 
 	void Draw(IRenderer* pRenderer) const;
 
-	static void GenSphere(const glm::vec3& vRadius, const glm::vec3& vOffset, uint32_t uRings, uint32_t uSegments, std::vector<VERTEX>& arrVertices);
+	/**
+	 * SetLod
+	 * select the level of detail drawn by Draw and DrawInstanced
+	 * @param uLod lod index, clamped to GetLodCount
+	 */
+	void SetLod(uint32_t uLod);
+
+	/**
+	 * GetLodForDistance
+	 * @param fDistance distance from the camera to the geometry
+	 * @return first lod whose maximum distance covers fDistance
+	 */
+	uint32_t GetLodForDistance(float fDistance) const;
+
+	/**
+	 * GetLodCount
+	 * @return number of lods loaded from a mesh file, 1 for generated geometry
+	 */
+	inline uint32_t GetLodCount() const { return m_arrLods.empty() ? 1 : (uint32_t)m_arrLods.size(); }
+	inline uint32_t GetLod() const { return m_uLod; }
+
+	/**
+	 * DrawInstanced
+	 * draw the geometry once per model matrix with a single draw call. Matrices
+	 * are streamed into the instance buffer and read by the program through
+	 * 'instanceMatrix' mat4 attribute. Call SetAttribs before drawing.
+	 * @param pRenderer renderer to use
+	 * @param pModels array of model matrices
+	 * @param count number of matrices in pModels
+	 */
+	void DrawInstanced(IRenderer* pRenderer, const glm::mat4* pModels, size_t count) const;
+
+	static void GenSphere(const glm::vec3& vRadius, const glm::vec3& vOffset, uint32_t uRings, uint32_t uSegments, std::vector<VERTEX>& arrVertices, std::vector<uint32_t>& arrIndices);
 	static void GenCube(const glm::vec3& vSize, const glm::vec3& vOffset, std::vector<VERTEX>& arrVertices, GLuint& uIndexbuffer, size_t& uIndexCount);
 	static void GenQuad(const glm::vec2& vSize, const glm::vec3& vOffset, std::vector<VERTEX>& arrVertices);
 
 	inline VERTEX* GetData() { return m_arrVertices.data(); }
 	inline const VERTEX* GetData() const { return m_arrVertices.data(); }
-	inline size_t GetVertexCount() const { return m_arrVertices.size(); }
+	inline size_t GetVertexCount() const { return m_uVertexCount; }
+	inline GLuint GetVertexBuffer() const { return m_VertexBuffer; }
 	inline GLuint GetIndexBuffer() const { return m_IndexBuffer; }
 	inline size_t GetIndexCount() const { return m_uIndexCount; }
 
+	/**
+	 * GetBounds
+	 * @return bounding box of the vertices, kept after ReleaseVertexData
+	 */
+	inline const AABB& GetBounds() const { return m_Bounds; }
+
+	/**
+	 * GetBoundingSphere
+	 * @return sphere around the geometry, set by the generators from their
+	 * size and offset, or read from the mesh file
+	 */
+	inline const SPHERE& GetBoundingSphere() const { return m_BoundingSphere; }
+
+	/**
+	 * GetCallsSaved
+	 * @return number of driver calls saved by the vertex array cache since last ResetCallsSaved
+	 */
+	static uint32_t GetCallsSaved() { return s_uCallsSaved; }
+	static void ResetCallsSaved() { s_uCallsSaved = 0; }
+
 private:
+	struct VERTEXARRAY
+	{
+		GLuint		uVertexArray = 0;
+		uint32_t	uSetupCalls = 0;
+		uint32_t	uDisableCalls = 0;
+	};
+
+	// vertex attribute in the vertex buffer
+	struct ATTRIBUTE
+	{
+		std::string	strName;
+		GLint		iComponents = 0;
+		GLenum		eType = GL_FLOAT;
+		GLboolean	bNormalized = GL_FALSE;
+		uint32_t	uOffset = 0;
+	};
+
+	/**
+	 * GetRenderer
+	 * @return renderer of the app, geometry binds its buffers through the renderer state cache
+	 */
+	static COpenGLRenderer* GetRenderer();
+	static void ReleaseBuffer(GLuint& uBuffer);
+
+	void SetDefaultLayout();
+	void SetLayout(const MESHATTRIBUTE* pAttributes, uint32_t uAttributeCount, uint32_t uStride);
+	void CreateVertexBuffer();
+	void CreateIndexBuffer(const std::vector<uint32_t>& arrIndices);
+	void GetIndexRange(size_t& uFirst, size_t& uCount) const;
+	const VERTEXARRAY& GetVertexArray(GLuint uProgram) const;
+	void ReleaseVertexArrays();
+
 	std::vector<VERTEX>			m_arrVertices;
 	GLenum						m_eDrawMode;
+	GLuint						m_VertexBuffer;
+	size_t						m_uVertexCount;
 	GLuint						m_IndexBuffer;
 	size_t						m_uIndexCount;
+	GLenum						m_eIndexType;
+	AABB						m_Bounds;
+	SPHERE						m_BoundingSphere;
+
+	// layout of the vertex buffer, VERTEX unless loaded from a mesh file
+	std::vector<ATTRIBUTE>		m_arrAttributes;
+	GLsizei						m_iStride;
+	bool						m_bNormalizedPosition;
+	bool						m_bOctahedralNormal;
+
+	// index ranges of a loaded mesh, empty for generated geometry
+	std::vector<MESHLOD>		m_arrLods;
+	uint32_t					m_uLod;
+
+	// per instance model matrices, created when a program uses instanceMatrix
+	mutable GLuint				m_InstanceBuffer;
+
+	// vertex array per program handle
+	mutable std::map<GLuint, VERTEXARRAY>	m_mapVertexArrays;
+
+	static uint32_t				s_uCallsSaved;
 };
 
@@ -49,7 +49,7 @@
 #define KEY_RIGHT	XK_Right
 #define KEY_UP		XK_Up
 #define KEY_DOWN	XK_Down
-#define KEY_SPACE	XK_Space
+#define KEY_SPACE	XK_space
 
 #endif
 
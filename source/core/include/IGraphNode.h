@@ -11,10 +11,31 @@
 #pragma once
 
 #include "../include/OpenGLRenderer.h"
+#include "../include/TransformPool.h"
+#include "../include/Bounds.h"
+
+class AABBTree;
+class Geometry;
+class InstanceBatch;
+class JobSystem;
+class RenderQueue;
 
 class IGraphNode
 {
 public:
+	// per frame culling statistics
+	struct CULLSTATS
+	{
+		// nodes tested against the frustum
+		uint32_t	uVisited;
+
+		// nodes skipped, including the nodes below a culled node
+		uint32_t	uCulled;
+
+		// nodes with geometry that were drawn
+		uint32_t	uDrawn;
+	};
+
 	IGraphNode();
 	~IGraphNode();
 
@@ -27,11 +48,84 @@ public:
 
 	/**
 	 * Render
-	 * a pure virtual function to render a node
+	 * render a node and its children. Default implementation skips the subtree
+	 * when it is out of view and calls Draw for a node with geometry in view.
+	 * @param pRenderer renderer to use
+	 * @param uProgram handle to shader program
+	 */
+	virtual void Render(IRenderer* pRenderer, GLuint uProgram);
+
+	/**
+	 * Draw
+	 * draw the geometry of this node alone, called by Render
 	 * @param pRenderer renderer to use
 	 * @param uProgram handle to shader program
 	 */
-	virtual void Render(IRenderer* pRenderer, GLuint uProgram) = 0;
+	virtual void Draw(IRenderer* pRenderer, GLuint uProgram);
+
+	/**
+	 * GetGeometry
+	 * @return geometry drawn by this node, nullptr if the node has none
+	 */
+	virtual const Geometry* GetGeometry() const;
+
+	/**
+	 * GatherInstances
+	 * collect this node and its children into instance batches instead of
+	 * rendering them one by one. Default implementation only visits the children,
+	 * nodes with geometry add themselves to the batch.
+	 * @param batch batch to collect the instances into
+	 */
+	virtual void GatherInstances(InstanceBatch& batch);
+
+	/**
+	 * Enqueue
+	 * add draw packets of this node and its children into a render queue
+	 * instead of rendering them immediately. Default implementation only visits
+	 * the children, nodes with geometry add their own packets.
+	 * @param queue queue to add the packets into
+	 * @param uProgram handle to shader program
+	 */
+	virtual void Enqueue(RenderQueue& queue, GLuint uProgram);
+
+	/**
+	 * GetLocalBounds
+	 * bounding box of the node in its own space. Default implementation
+	 * returns the bounds of GetGeometry, a node without geometry has no bounds.
+	 * @param box receives the bounds
+	 * @return true if the node has bounds
+	 */
+	virtual bool GetLocalBounds(AABB& box) const;
+
+	/**
+	 * GetLocalSphere
+	 * bounding sphere of the node in its own space. Default implementation
+	 * returns the sphere of GetGeometry, a node without geometry has no
+	 * sphere and is never culled.
+	 * @param sphere receives the sphere
+	 * @return true if the node has a bounding sphere
+	 */
+	virtual bool GetLocalSphere(SPHERE& sphere) const;
+
+	/**
+	 * BeginCulling
+	 * cull the render traversal against a view frustum until EndCulling.
+	 * Resets the statistics. Bounding spheres are updated by UpdateWorldMatrices.
+	 * @param mViewProjection projection * view matrix to cull with
+	 */
+	static void BeginCulling(const glm::mat4& mViewProjection);
+
+	/**
+	 * EndCulling
+	 * stop culling, the render traversal draws everything again
+	 */
+	static void EndCulling();
+
+	/**
+	 * GetCullStats
+	 * @return statistics since the last BeginCulling
+	 */
+	static const CULLSTATS& GetCullStats() { return s_CullStats; }
 
 	/**
 	 * AddChild
@@ -58,73 +152,219 @@ public:
 	 */
 	inline void SetPos(const glm::vec3& vPos)
 	{
-		m_mModel[3][0] = vPos.x;
-		m_mModel[3][1] = vPos.y;
-		m_mModel[3][2] = vPos.z;
+		if (m_pTransforms)
+		{
+			m_pTransforms->SetPos(m_hTransform, vPos);
+		}
+		else
+		{
+			m_mModel[3][0] = vPos.x;
+			m_mModel[3][1] = vPos.y;
+			m_mModel[3][2] = vPos.z;
+		}
+		SetDirty();
 	}
 
 	/**
 	 * SetPos
 	 * set position into the local model matrix of this node
 	 */
-	inline void SetPos(float x, float y, float z)
-	{
-		m_mModel[3][0] = x;
-		m_mModel[3][1] = y;
-		m_mModel[3][2] = z;
-	}
+	inline void SetPos(float x, float y, float z) { SetPos(glm::vec3(x, y, z)); }
 
 	/**
 	 * GetPos
 	 * @return position of the node
 	 */
-	inline glm::vec3 GetPos() const { return glm::vec3(m_mModel[3][0], m_mModel[3][1], m_mModel[3][2]); }
+	inline glm::vec3 GetPos() const
+	{
+		if (m_pTransforms)
+		{
+			return m_pTransforms->GetPos(m_hTransform);
+		}
+		return glm::vec3(m_mModel[3][0], m_mModel[3][1], m_mModel[3][2]);
+	}
 
 	/**
 	 * GetMatrix
-	 * @return a reference to node local model matrix
+	 * @return a reference to node local model matrix. Node is assumed to be
+	 * modified through the reference and its world matrix is invalidated.
 	 */
-	inline glm::mat4& GetMatrix() { return m_mModel; }
+	inline glm::mat4& GetMatrix() { SetDirty(); return (m_pTransforms) ? m_pTransforms->GetLocalMatrix(m_hTransform) : m_mModel; }
+	inline const glm::mat4& GetMatrix() const { return (m_pTransforms) ? m_pTransforms->GetLocalMatrix(m_hTransform) : m_mModel; }
 
 	/**
 	 * SetMatrix
 	 * @param m matrix to set to node
 	 */
-	inline void SetMatrix(const glm::mat4& m) { m_mModel = m; }
+	inline void SetMatrix(const glm::mat4& m)
+	{
+		if (m_pTransforms)
+		{
+			m_pTransforms->SetLocalMatrix(m_hTransform, m);
+		}
+		else
+		{
+			m_mModel = m;
+		}
+		SetDirty();
+	}
+
+	/**
+	 * GetWorldMatrix
+	 * @return a matrix combined with parent. Matrix is cached and only
+	 * recomputed after the node or one of its parents has moved. For nodes
+	 * attached to a transform pool the matrix is computed by the pool.
+	 */
+	const glm::mat4& GetWorldMatrix();
+
+	/**
+	 * UpdateWorldMatrices
+	 * recompute the world matrices of this node and its children that have
+	 * moved, in one top-down pass, and their bounding spheres on the way back
+	 * up. Call after Update, before rendering.
+	 */
+	void UpdateWorldMatrices();
 
 	/**
-	 * @return a matrix combined with parent
+	 * SetDirty
+	 * invalidate the cached world matrix of this node and its children.
+	 * Call after writing m_mModel directly.
 	 */
-	inline glm::mat4 GetWorldMatrix() { return (m_pParent) ? m_pParent->GetWorldMatrix() * m_mModel : m_mModel; }
+	void SetDirty();
+
+	/**
+	 * AttachTransform
+	 * move transform of this node and its children into a transform pool.
+	 * The node keeps working through the same accessors, but its Update no
+	 * longer integrates the transform: call TransformPool::Integrate and
+	 * TransformPool::UpdateWorldMatrices instead, they sweep all nodes of the
+	 * pool linearly. Attach the parent first if it should be part of the
+	 * world matrix of the node.
+	 * @param pool pool to store the transforms in
+	 */
+	void AttachTransform(TransformPool& pool);
+
+	/**
+	 * GetTransform
+	 * @return handle of the node in its transform pool, or INVALID_HANDLE
+	 */
+	inline TransformHandle GetTransform() const { return m_hTransform; }
+
+	/**
+	 * RegisterBounds
+	 * insert this node and its children that have bounds into an AABB tree,
+	 * the user data of each proxy is the node. Call after the world matrices
+	 * are up to date.
+	 * @param tree tree to insert into
+	 */
+	void RegisterBounds(AABBTree& tree);
+
+	/**
+	 * UnregisterBounds
+	 * remove this node and its children from their AABB tree
+	 */
+	void UnregisterBounds();
+
+	/**
+	 * UpdateBounds
+	 * move the proxies of this node and its children to their current world
+	 * bounds. Call after UpdateWorldMatrices, the tree only changes for the
+	 * nodes that moved out of their fat boxes.
+	 */
+	void UpdateBounds();
+
+	/**
+	 * GetProxy
+	 * @return proxy id of the node in its AABB tree, or AABBTree::NULL_NODE
+	 */
+	inline int32_t GetProxy() const { return m_iProxy; }
+
+	/**
+	 * SetJobSystem
+	 * update the children of this node in parallel. Each child subtree is
+	 * updated on one thread, so subtrees must not touch each other in Update.
+	 * Children of the children are still updated serially.
+	 * @param pJobs job system to use, or nullptr to update serially
+	 */
+	inline void SetJobSystem(JobSystem* pJobs) { m_pJobs = pJobs; }
 
 	/**
 	 * GetVelocity
 	 * @return reference to node velocity vector
 	 */
-	inline glm::vec3& GetVelocity() { return m_vVelocity; }
+	inline glm::vec3& GetVelocity() { return (m_pTransforms) ? m_pTransforms->GetVelocity(m_hTransform) : m_vVelocity; }
 
 	/**
 	 * SetVelocity
 	 * set node velocity vector
 	 * @param vVelocity new velocity
 	 */
-	inline void SetVelocity(const glm::vec3& vVelocity) { m_vVelocity = vVelocity; }
+	inline void SetVelocity(const glm::vec3& vVelocity) { GetVelocity() = vVelocity; }
 
-	inline glm::vec3& GetRotationAxis() { return m_vRotationAxis; }
-	inline void SetRotationAxis(const glm::vec3& vAxis) { m_vRotationAxis = vAxis; }
+	inline glm::vec3& GetRotationAxis() { return (m_pTransforms) ? m_pTransforms->GetRotationAxis(m_hTransform) : m_vRotationAxis; }
+	inline void SetRotationAxis(const glm::vec3& vAxis) { GetRotationAxis() = vAxis; }
 
-	inline void SetRotationSpeed(float fSpeed) { m_fRotationSpeed = fSpeed; }
-	inline float GetRotationSpeed() const { return m_fRotationSpeed; }
+	inline void SetRotationSpeed(float fSpeed) { GetRotationSpeedRef() = fSpeed; }
+	inline float GetRotationSpeed() const { return (m_pTransforms) ? m_pTransforms->GetRotationSpeed(m_hTransform) : m_fRotationSpeed; }
 
-	inline void SetRotationAngle(float fAngle) { m_fRotationAngle = fAngle; }
-	inline float GetRotationAngle() const { return m_fRotationAngle; }
+	inline void SetRotationAngle(float fAngle) { GetRotationAngleRef() = fAngle; }
+	inline float GetRotationAngle() const { return (m_pTransforms) ? m_pTransforms->GetRotationAngle(m_hTransform) : m_fRotationAngle; }
 
-	inline float GetRadius() const { return m_fRadius; }
-	inline void SetRadius(float fRadius) { m_fRadius = fRadius; }
+	inline float GetRadius() const { return (m_pTransforms) ? m_pTransforms->GetRadius(m_hTransform) : m_fRadius; }
+	inline void SetRadius(float fRadius) { GetRadiusRef() = fRadius; }
+
+private:
+	// references to the storage in use, pool or members
+	inline float& GetRotationSpeedRef() { return (m_pTransforms) ? m_pTransforms->GetRotationSpeed(m_hTransform) : m_fRotationSpeed; }
+	inline float& GetRotationAngleRef() { return (m_pTransforms) ? m_pTransforms->GetRotationAngle(m_hTransform) : m_fRotationAngle; }
+	inline float& GetRadiusRef() { return (m_pTransforms) ? m_pTransforms->GetRadius(m_hTransform) : m_fRadius; }
 
 protected:
+	/**
+	 * UpdateChildren
+	 * update all children, in parallel if a job system is set
+	 * @param fFrametime frame delta time
+	 */
+	void UpdateChildren(float fFrametime);
+
+	uint32_t GetChildGrainSize() const;
+
+	/**
+	 * IsSubtreeVisible
+	 * test the sphere around this node and its children against the culling
+	 * frustum. Render traversals call this first and return when it fails.
+	 * @return false if the node and its children are all out of view
+	 */
+	bool IsSubtreeVisible();
+
+	/**
+	 * IsVisible
+	 * test the sphere of this node alone, call after IsSubtreeVisible
+	 * before drawing the geometry of the node
+	 * @return false if the node is out of view
+	 */
+	bool IsVisible();
+
+	/**
+	 * UpdateSpheres
+	 * recompute the world sphere of this node and the sphere around its
+	 * children, children must be up to date
+	 */
+	void UpdateSpheres();
+
+	/**
+	 * GetWorldBounds
+	 * @param box receives the local bounds transformed by the world matrix
+	 * @return true if the node has bounds
+	 */
+	bool GetWorldBounds(AABB& box);
+
 	glm::mat4					m_mModel;
 	IGraphNode*					m_pParent;
+
+	// cached parent * model, valid when not dirty
+	glm::mat4					m_mWorld;
+	bool						m_bWorldDirty;
 	std::vector<IGraphNode*>	m_arrChildren;
 
 	// velocity and rotations
@@ -136,5 +376,32 @@ protected:
 
 	// size
 	float						m_fRadius;
+
+	// transform pool storage, used instead of the members above when set
+	TransformPool*				m_pTransforms;
+	TransformHandle				m_hTransform;
+
+	// splits the children across worker threads when set
+	JobSystem*					m_pJobs;
+
+	// spatial index the node is registered into
+	AABBTree*					m_pBoundsTree;
+	int32_t						m_iProxy;
+
+	// world space spheres of this node and of the whole subtree
+	SPHERE						m_WorldSphere;
+	SPHERE						m_SubtreeSphere;
+	bool						m_bHasSphere;
+	bool						m_bHasSubtreeSphere;
+	uint32_t					m_uSubtreeCount;
+
+	// result of the last frustum test, valid when the frame matches
+	CULLRESULT					m_eCullResult;
+	uint32_t					m_uCullFrame;
+
+	static FRUSTUM				s_CullFrustum;
+	static bool					s_bCulling;
+	static uint32_t				s_uCullFrame;
+	static CULLSTATS			s_CullStats;
 };
 
@@ -0,0 +1,72 @@
+/**
+ * ============================================================================
+ *  Name        : InstanceBatch.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : collects model matrices of objects sharing geometry and
+ *                material into instanced draw calls
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/Geometry.h"
+#include "../include/Material.h"
+
+class InstanceBatch
+{
+public:
+	InstanceBatch();
+	~InstanceBatch();
+
+	/**
+	 * Add
+	 * add one instance into the batch of its geometry and material
+	 * @param pGeometry geometry to draw
+	 * @param pMaterial material to draw with, may be nullptr
+	 * @param mWorld world matrix of the instance
+	 */
+	void Add(const Geometry* pGeometry, Material* pMaterial, const glm::mat4& mWorld);
+
+	/**
+	 * Draw
+	 * draw all batches, one instanced draw call per geometry and material pair
+	 * @param pRenderer renderer to use
+	 * @param uProgram program with 'instanceMatrix' attribute
+	 */
+	void Draw(COpenGLRenderer* pRenderer, GLuint uProgram);
+
+	/**
+	 * Clear
+	 * remove all instances. Batches keep their memory for the next frame.
+	 */
+	void Clear();
+
+	/**
+	 * GetDrawCallCount
+	 * @return number of draw calls made by the last Draw
+	 */
+	inline uint32_t GetDrawCallCount() const { return m_uDrawCalls; }
+
+	/**
+	 * GetInstanceCount
+	 * @return number of instances drawn by the last Draw
+	 */
+	inline uint32_t GetInstanceCount() const { return m_uInstances; }
+
+private:
+	struct BATCH
+	{
+		const Geometry*			pGeometry = nullptr;
+		Material*				pMaterial = nullptr;
+		std::vector<glm::mat4>	arrModels;
+	};
+
+	// scenes use only a handful of geometry and material pairs
+	std::vector<BATCH>			m_arrBatches;
+
+	uint32_t					m_uDrawCalls;
+	uint32_t					m_uInstances;
+};
+
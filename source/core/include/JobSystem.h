@@ -0,0 +1,110 @@
+/**
+ * ============================================================================
+ *  Name        : JobSystem.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : fixed pool of worker threads with work stealing job queues
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem
+{
+public:
+	JobSystem();
+	~JobSystem();
+
+	/**
+	 * Create
+	 * start the worker threads. Jobs must not make GL calls, the GL context
+	 * is only current on the render thread.
+	 * @param uWorkerCount number of worker threads, 0 to use one less than
+	 * the number of hardware threads as the calling thread works as well
+	 * @return true if successful
+	 */
+	bool Create(uint32_t uWorkerCount = 0);
+
+	/**
+	 * Destroy
+	 * wait for the queued jobs and stop the worker threads
+	 */
+	void Destroy();
+
+	/**
+	 * GetWorkerCount
+	 * @return number of worker threads, not counting the calling thread
+	 */
+	inline uint32_t GetWorkerCount() const { return (uint32_t)m_arrThreads.size(); }
+
+	/**
+	 * Run
+	 * queue a job. Jobs queued from a job go to the queue of that worker.
+	 * @param fnJob job to run
+	 * @param pCounter incremented now and decremented when the job is done
+	 */
+	void Run(std::function<void()> fnJob, std::atomic<uint32_t>* pCounter);
+
+	/**
+	 * Wait
+	 * run queued jobs on the calling thread until the counter reaches zero
+	 * @param pCounter counter passed to Run
+	 */
+	void Wait(std::atomic<uint32_t>* pCounter);
+
+	/**
+	 * ParallelFor
+	 * split [0, uCount) into ranges of uGrainSize and process them on all
+	 * threads. Returns when all ranges are done.
+	 * @param uCount number of items
+	 * @param uGrainSize number of items per job, at least 1
+	 * @param fnRange function called with [uBegin, uEnd) ranges
+	 */
+	void ParallelFor(uint32_t uCount, uint32_t uGrainSize, const std::function<void(uint32_t uBegin, uint32_t uEnd)>& fnRange);
+
+private:
+	struct JOB
+	{
+		std::function<void()>		fnJob;
+		std::atomic<uint32_t>*		pCounter = nullptr;
+	};
+
+	struct JOBQUEUE
+	{
+		std::mutex					mutex;
+		std::deque<JOB>				arrJobs;
+	};
+
+	/**
+	 * RunOneJob
+	 * pop a job from own queue, or steal one from the other queues, and run it
+	 * @param uQueue index of the queue of the calling thread
+	 * @return true if a job was run
+	 */
+	bool RunOneJob(uint32_t uQueue);
+
+	void WorkerThread(uint32_t uQueue);
+
+	uint32_t GetQueueIndex() const;
+
+	std::vector<std::thread>				m_arrThreads;
+
+	// queue 0 belongs to the threads that are not workers
+	std::vector<std::unique_ptr<JOBQUEUE>>	m_arrQueues;
+
+	std::mutex								m_WakeMutex;
+	std::condition_variable					m_WakeCondition;
+	std::atomic<uint32_t>					m_uQueuedJobs;
+	std::atomic<bool>						m_bQuit;
+};
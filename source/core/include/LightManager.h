@@ -0,0 +1,183 @@
+/**
+ * ============================================================================
+ *  Name        : LightManager.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : shadowed spot lights sharing one shadow map atlas
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/Bounds.h"
+#include <vector>
+
+class LightManager
+{
+public:
+	static const uint32_t NO_TILE = 0xffffffff;
+
+	struct LIGHT
+	{
+		LIGHT()
+		{
+			vPosition = glm::vec3(0.0f);
+			vDirection = glm::vec3(0.0f, -1.0f, 0.0f);
+			vColor = glm::vec3(1.0f);
+			fConeAngle = 1.0f;
+			fRange = 10.0f;
+			fPriority = 1.0f;
+		}
+
+		glm::vec3	vPosition;
+		glm::vec3	vDirection;
+		glm::vec3	vColor;
+
+		// full opening angle of the cone in radians
+		float		fConeAngle;
+		float		fRange;
+
+		// weight of the light when choosing which shadows to update
+		float		fPriority;
+	};
+
+	LightManager();
+	~LightManager();
+
+	/**
+	 * SetAtlas
+	 * set the layout of the shadow map atlas, the atlas is a grid of equal
+	 * tiles and each light gets one tile. Lights beyond the tile count have
+	 * no shadow. Changing the layout renders all shadows again.
+	 * @param uAtlasSize width and height of the atlas texture in texels
+	 * @param uTileSize width and height of one tile in texels
+	 */
+	void SetAtlas(uint32_t uAtlasSize, uint32_t uTileSize);
+	inline uint32_t GetAtlasSize() const { return m_uAtlasSize; }
+	inline uint32_t GetTileSize() const { return m_uTileSize; }
+
+	/**
+	 * SetUpdateBudget
+	 * @param uLights maximum number of shadow tiles rendered per frame
+	 */
+	inline void SetUpdateBudget(uint32_t uLights) { m_uUpdateBudget = uLights; }
+	inline uint32_t GetUpdateBudget() const { return m_uUpdateBudget; }
+
+	/**
+	 * Clear
+	 * remove all lights
+	 */
+	void Clear();
+
+	/**
+	 * AddLight
+	 * @param light light to add
+	 * @return index of the light
+	 */
+	uint32_t AddLight(const LIGHT& light);
+
+	/**
+	 * SetLight
+	 * change a light, its shadow is updated when the budget allows
+	 * @param uLight index of the light
+	 * @param light new light parameters
+	 */
+	inline void SetLight(uint32_t uLight, const LIGHT& light) { m_arrLights[uLight] = light; }
+	inline const LIGHT& GetLight(uint32_t uLight) const { return m_arrLights[uLight]; }
+	inline uint32_t GetLightCount() const { return (uint32_t)m_arrLights.size(); }
+
+	/**
+	 * InvalidateSphere
+	 * mark the shadows of the lights that can see a sphere as out of date,
+	 * call when a shadow caster inside the sphere moves
+	 * @param sphere world space bounds of the change
+	 */
+	void InvalidateSphere(const SPHERE& sphere);
+
+	/**
+	 * Invalidate
+	 * mark all shadows as out of date, e.g. when the atlas contents are lost
+	 */
+	void Invalidate();
+
+	/**
+	 * Update
+	 * choose the shadows to render this frame. Out of date shadows are
+	 * ranked by light priority, closeness to the camera and the number of
+	 * frames they have waited, and at most the update budget of them are
+	 * rendered. The rest keep sampling their previous tile with the matrix
+	 * the tile was rendered with.
+	 * @param vCameraPosition position of the camera in world space
+	 * @return indices of the lights to render into their tiles, valid until next Update
+	 */
+	const std::vector<uint32_t>& Update(const glm::vec3& vCameraPosition);
+
+	/**
+	 * GetDeferredCount
+	 * @return number of out of date shadows left for later frames by the last Update
+	 */
+	inline uint32_t GetDeferredCount() const { return m_uDeferredCount; }
+
+	/**
+	 * HasShadow
+	 * @return true if the light has a tile with a rendered shadow in it
+	 */
+	inline bool HasShadow(uint32_t uLight) const { return m_arrStates[uLight].bRendered; }
+
+	/**
+	 * GetTileViewport
+	 * @param uLight index of the light
+	 * @return x, y of the tile of the light in the atlas, width and height are GetTileSize
+	 */
+	glm::ivec2 GetTileViewport(uint32_t uLight) const;
+
+	/**
+	 * GetTileRect
+	 * shadow lookups of the light are limited to this rect. The shadow matrix
+	 * of a deferred light is older than the light and can map fragments outside
+	 * the tile, those have to be left unshadowed instead of reading a neighbour.
+	 * @param uLight index of a light with a shadow, see HasShadow
+	 * @return min u, min v, max u, max v of the tile in atlas texture coordinates,
+	 * half a texel in from the edges
+	 */
+	glm::vec4 GetTileRect(uint32_t uLight) const;
+
+	/**
+	 * GetViewProjection
+	 * @return view projection matrix the shadow of the light is rendered with
+	 */
+	inline const glm::mat4& GetViewProjection(uint32_t uLight) const { return m_arrStates[uLight].mRenderedViewProjection; }
+
+	/**
+	 * GetShadowMatrix
+	 * @return matrix from world space to the atlas texture coordinates and depth of the light
+	 */
+	inline const glm::mat4& GetShadowMatrix(uint32_t uLight) const { return m_arrStates[uLight].mShadowMatrix; }
+
+private:
+	struct STATE
+	{
+		uint32_t	uTile;
+		glm::mat4	mViewProjection;
+		glm::mat4	mRenderedViewProjection;
+		glm::mat4	mShadowMatrix;
+		uint32_t	uFramesWaited;
+		float		fScore;
+		bool		bRendered;
+		bool		bInvalid;
+	};
+
+	static glm::mat4 GetLightViewProjection(const LIGHT& light);
+	void AssignTiles();
+
+	std::vector<LIGHT>			m_arrLights;
+	std::vector<STATE>			m_arrStates;
+	std::vector<uint32_t>		m_arrCandidates;
+	std::vector<uint32_t>		m_arrUpdates;
+
+	uint32_t					m_uAtlasSize;
+	uint32_t					m_uTileSize;
+	uint32_t					m_uUpdateBudget;
+	uint32_t					m_uDeferredCount;
+};
@@ -0,0 +1,52 @@
+/**
+ * ============================================================================
+ *  Name        : MappedFile.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : read only memory mapped file
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	/**
+	 * Open
+	 * map a whole file into memory. Pages are read on first access and
+	 * shared with the other processes that map the same file.
+	 * @param strFilename file to map
+	 * @return true if successful
+	 */
+	bool Open(const std::string& strFilename);
+
+	/**
+	 * Close
+	 * unmap the file, pointers returned by GetData become invalid
+	 */
+	void Close();
+
+	inline const unsigned char* GetData() const { return m_pData; }
+	inline size_t GetSize() const { return m_uSize; }
+
+private:
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const unsigned char*	m_pData;
+	size_t					m_uSize;
+
+#if defined (_WINDOWS)
+	void*					m_hFile;
+	void*					m_hMapping;
+#endif
+};
@@ -12,6 +12,7 @@
 
 #include "../include/OpenGLRenderer.h"
 
+class MaterialBuffer;
 
 class Material
 {
@@ -19,7 +20,22 @@ public:
 	Material();
 	~Material();
 
-	void SetToProgram(GLuint uProgram);
+	/**
+	 * SetToProgram
+	 * set material uniforms into the current program. Materials in a
+	 * MaterialBuffer bind their uniform block instead for attached programs.
+	 * @param pRenderer renderer owning the program
+	 * @param uProgram program handle
+	 */
+	void SetToProgram(COpenGLRenderer* pRenderer, GLuint uProgram);
+
+	/**
+	 * SetDirty
+	 * call after changing the colors or specular power, the block of the
+	 * material in its MaterialBuffer is uploaded again when next bound
+	 */
+	inline void SetDirty() { m_bDirty = true; }
+	inline bool IsDirty() const { return m_bDirty; }
 
 	glm::vec4		m_cAmbient;
 	glm::vec4		m_cDiffuse;
@@ -27,5 +43,12 @@ public:
 	glm::vec4		m_cEmissive;
 
 	float			m_fSpecularPower;
+
+private:
+	friend class MaterialBuffer;
+
+	MaterialBuffer*	m_pBuffer;
+	uint32_t		m_uBufferSlot;
+	bool			m_bDirty;
 };
 
@@ -0,0 +1,98 @@
+/**
+ * ============================================================================
+ *  Name        : MaterialBuffer.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : materials packed into one uniform buffer object
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/Material.h"
+#include <vector>
+
+class MaterialBuffer
+{
+public:
+	// uniform buffer binding point of the MaterialBlock uniform block
+	static const uint32_t BINDING = 0;
+
+	MaterialBuffer();
+	~MaterialBuffer();
+
+	/**
+	 * Create
+	 * create the uniform buffer for a number of materials
+	 * @param pRenderer renderer to create the buffer with
+	 * @param uCapacity maximum number of materials
+	 * @return true if successful, false if the driver has no uniform buffers
+	 */
+	bool Create(COpenGLRenderer* pRenderer, uint32_t uCapacity);
+
+	/**
+	 * Release
+	 * delete the buffer and detach all materials, they fall back to uniforms
+	 * @param pRenderer renderer the buffer was created with
+	 */
+	void Release(COpenGLRenderer* pRenderer);
+
+	inline bool IsValid() const { return m_uBuffer != 0; }
+
+	/**
+	 * AddMaterial
+	 * give a material a block in the buffer. Material::SetToProgram binds the
+	 * block for programs attached to this buffer.
+	 * @param pMaterial material to add, must outlive the buffer
+	 * @return true if the material was added, false if the buffer is full
+	 */
+	bool AddMaterial(Material* pMaterial);
+
+	/**
+	 * AttachProgram
+	 * bind the MaterialBlock uniform block of a program to the buffer
+	 * @param uProgram linked program handle
+	 * @return true if the program has the uniform block
+	 */
+	bool AttachProgram(GLuint uProgram);
+
+	/**
+	 * HasProgram
+	 * @return true if the program was attached to this buffer
+	 */
+	bool HasProgram(GLuint uProgram) const;
+
+	/**
+	 * Bind
+	 * upload the block of the material if it was edited, and bind it
+	 * @param pRenderer renderer owning the binding state
+	 * @param pMaterial material added to this buffer
+	 */
+	void Bind(COpenGLRenderer* pRenderer, Material* pMaterial);
+
+	/**
+	 * GetUploadCount
+	 * @return number of material blocks uploaded since Create
+	 */
+	inline uint32_t GetUploadCount() const { return m_uUploadCount; }
+
+private:
+	// std140 layout of the MaterialBlock uniform block
+	struct MATERIALBLOCK
+	{
+		glm::vec4	cAmbient;
+		glm::vec4	cDiffuse;
+		glm::vec4	cSpecular;
+		glm::vec4	cEmissive;
+		float		fSpecularPower;
+		float		arrPadding[3];
+	};
+
+	GLuint						m_uBuffer;
+	uint32_t					m_uCapacity;
+	uint32_t					m_uStride;
+	uint32_t					m_uUploadCount;
+	std::vector<Material*>		m_arrMaterials;
+	std::vector<GLuint>			m_arrPrograms;
+};
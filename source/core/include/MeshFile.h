@@ -0,0 +1,135 @@
+/**
+ * ============================================================================
+ *  Name        : MeshFile.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : memory mapped binary mesh container
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "MappedFile.h"
+#include <vector>
+
+/*
+ * File layout, all sections start at 16 byte aligned offsets:
+ *   MESHHEADER
+ *   MESHATTRIBUTE[uAttributeCount]	vertex layout
+ *   MESHLOD[uLodCount]				index ranges, most detailed first
+ *   vertices						uVertexCount * uVertexStride bytes
+ *   indices						uIndexCount * uIndexSize bytes
+ * Vertex and index blobs are stored exactly as the buffer objects want
+ * them, so they are handed to the driver straight from the mapping.
+ */
+
+static const uint32_t MESHFILE_MAGIC = 0x4853454d;	// 'MESH'
+static const uint32_t MESHFILE_VERSION = 1;
+
+// vertex attribute component types
+enum MESHTYPE
+{
+	MESHTYPE_FLOAT,
+	MESHTYPE_HALF,
+	MESHTYPE_INT16,
+	MESHTYPE_INT_2_10_10_10		// 4 components packed into 32 bits
+};
+
+struct MESHHEADER
+{
+	uint32_t	uMagic;
+	uint32_t	uVersion;
+	uint32_t	uVertexCount;
+	uint32_t	uVertexStride;
+	uint32_t	uIndexCount;			// all lods
+	uint32_t	uIndexSize;				// 2 or 4 bytes
+	uint32_t	uAttributeCount;
+	uint32_t	uLodCount;
+	float		arrBoundsMin[3];
+	float		arrBoundsMax[3];
+	float		arrSphere[4];			// center and radius
+	uint32_t	uAttributesOffset;
+	uint32_t	uLodsOffset;
+	uint32_t	uVerticesOffset;
+	uint32_t	uIndicesOffset;
+};
+
+struct MESHATTRIBUTE
+{
+	char		szName[16];				// shader attribute name
+	uint32_t	uType;					// MESHTYPE
+	uint32_t	uComponents;			// 1 to 4
+	uint32_t	uNormalized;
+	uint32_t	uOffset;				// offset in the vertex
+};
+
+struct MESHLOD
+{
+	uint32_t	uFirstIndex;
+	uint32_t	uIndexCount;
+	float		fMaxDistance;			// lod is used up to this distance
+	uint32_t	uReserved;
+};
+
+class MeshFile
+{
+public:
+	/**
+	 * Open
+	 * map a mesh file and validate its header and section ranges.
+	 * Nothing is read or copied, the pointers point into the mapping.
+	 * @param strFilename file to open
+	 * @return true if successful
+	 */
+	bool Open(const std::string& strFilename);
+	void Close();
+
+	inline const MESHHEADER& GetHeader() const { return *m_pHeader; }
+	inline const MESHATTRIBUTE* GetAttributes() const { return m_pAttributes; }
+	inline const MESHLOD* GetLods() const { return m_pLods; }
+	inline const void* GetVertices() const { return m_pVertices; }
+	inline const void* GetIndices() const { return m_pIndices; }
+	inline size_t GetVertexBytes() const { return (size_t)m_pHeader->uVertexCount * m_pHeader->uVertexStride; }
+	inline size_t GetIndexBytes() const { return (size_t)m_pHeader->uIndexCount * m_pHeader->uIndexSize; }
+
+	/**
+	 * GetAttributeSize
+	 * @param attribute vertex attribute
+	 * @return size of the attribute in bytes, 0 if the type is invalid
+	 */
+	static uint32_t GetAttributeSize(const MESHATTRIBUTE& attribute);
+
+	/**
+	 * Save
+	 * write a mesh file. Bounds are computed from the 'position' attribute
+	 * and indices are stored as 16 bits when the vertex count allows.
+	 * MESHTYPE_INT16 positions are normalized to the bounds, which have
+	 * to be given.
+	 * @param strFilename file to write
+	 * @param arrAttributes vertex layout
+	 * @param uVertexStride size of one vertex in bytes
+	 * @param pVertices vertex data
+	 * @param uVertexCount number of vertices
+	 * @param arrIndices triangle list indices of all lods
+	 * @param arrLods index ranges, empty for a single lod of all indices
+	 * @param pBounds minimum and maximum of int16 positions, 6 floats
+	 * @return true if successful
+	 */
+	static bool Save(const std::string& strFilename,
+		const std::vector<MESHATTRIBUTE>& arrAttributes,
+		uint32_t uVertexStride,
+		const void* pVertices,
+		uint32_t uVertexCount,
+		const std::vector<uint32_t>& arrIndices,
+		const std::vector<MESHLOD>& arrLods,
+		const float* pBounds = nullptr);
+
+private:
+	MappedFile				m_File;
+	const MESHHEADER*		m_pHeader = nullptr;
+	const MESHATTRIBUTE*	m_pAttributes = nullptr;
+	const MESHLOD*			m_pLods = nullptr;
+	const void*				m_pVertices = nullptr;
+	const void*				m_pIndices = nullptr;
+};
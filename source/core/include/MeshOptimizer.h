@@ -0,0 +1,156 @@
+/**
+ * ============================================================================
+ *  Name        : MeshOptimizer.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : indexed triangle list welding and reordering for the gpu
+ *                vertex caches, overdraw and vertex fetch
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// efficiency of an indexed triangle list
+struct MESHSTATS
+{
+	float	fACMR = 0.0f;			// vertex shader runs per triangle, 0.5 at best
+	float	fATVR = 0.0f;			// vertex shader runs per vertex, 1.0 at best
+	float	fOverdraw = 0.0f;		// pixels shaded per pixel covered, 1.0 at best
+};
+
+/*
+ * Stages work on triangle lists of any vertex made of floats, with the
+ * position in the first three. Run them in the order Optimize does:
+ * weld, vertex cache, overdraw and vertex fetch.
+ */
+class MeshOptimizer
+{
+public:
+	/**
+	 * Optimize
+	 * run all stages on a vertex array, for example std::vector<VERTEX>
+	 * @param arrVertices vertices, duplicates and unused vertices are removed
+	 * @param arrIndices triangle list indices
+	 * @param fWeldEpsilon see WeldVertices
+	 */
+	template <typename VERTEXTYPE>
+	static void Optimize(std::vector<VERTEXTYPE>& arrVertices, std::vector<uint32_t>& arrIndices, float fWeldEpsilon = 0.0f)
+	{
+		static_assert(sizeof(VERTEXTYPE) % sizeof(float) == 0, "vertex has to consist of floats");
+		const uint32_t uVertexSize = sizeof(VERTEXTYPE) / sizeof(float);
+		float* pVertices = (float*)arrVertices.data();
+
+		size_t uVertexCount = WeldVertices(pVertices, arrVertices.size(), uVertexSize, arrIndices.data(), arrIndices.size(), fWeldEpsilon);
+		OptimizeVertexCache(arrIndices.data(), arrIndices.size(), uVertexCount);
+		OptimizeOverdraw(arrIndices.data(), arrIndices.size(), pVertices, uVertexCount, uVertexSize);
+		uVertexCount = OptimizeVertexFetch(pVertices, uVertexCount, uVertexSize, arrIndices.data(), arrIndices.size());
+		arrVertices.resize(uVertexCount);
+	}
+
+	/**
+	 * WeldVertices
+	 * merge duplicate vertices and compact the vertex array in place, the
+	 * first of the duplicates is kept. Vertices are looked up from a hash
+	 * of their bits, or of their position cell when fEpsilon is set.
+	 * @param pVertices vertices
+	 * @param uVertexCount number of vertices
+	 * @param uVertexSize number of floats in a vertex
+	 * @param pIndices indices, remapped in place
+	 * @param uIndexCount number of indices
+	 * @param fEpsilon 0 merges identical vertices, otherwise vertices whose
+	 * every float is within fEpsilon of each other
+	 * @return number of vertices left
+	 */
+	static size_t WeldVertices(float* pVertices, size_t uVertexCount, uint32_t uVertexSize,
+		uint32_t* pIndices, size_t uIndexCount, float fEpsilon = 0.0f);
+
+	/**
+	 * OptimizeVertexCache
+	 * reorder triangles so that vertices shared by neighbouring triangles
+	 * are still in the post transform cache when reused (Tom Forsyth's
+	 * linear speed vertex cache optimisation). Triangles keep their winding.
+	 * @param pIndices triangle list indices, reordered in place
+	 * @param uIndexCount number of indices, multiple of 3
+	 * @param uVertexCount number of vertices referenced by the indices
+	 */
+	static void OptimizeVertexCache(uint32_t* pIndices, size_t uIndexCount, size_t uVertexCount);
+
+	/**
+	 * OptimizeOverdraw
+	 * split a cache optimized triangle list into clusters and draw the
+	 * outwards facing clusters first, so that they occlude the rest (Sander,
+	 * Nehab and Barczak, fast triangle reordering). Splits are made where
+	 * the cache efficiency stays within fThreshold of the input.
+	 * @param pIndices triangle list indices, reordered in place
+	 * @param uIndexCount number of indices
+	 * @param pVertices vertices
+	 * @param uVertexCount number of vertices
+	 * @param uVertexSize number of floats in a vertex
+	 * @param fThreshold largest allowed ACMR growth, 1.05 is 5%
+	 */
+	static void OptimizeOverdraw(uint32_t* pIndices, size_t uIndexCount,
+		const float* pVertices, size_t uVertexCount, uint32_t uVertexSize, float fThreshold = 1.05f);
+
+	/**
+	 * OptimizeVertexFetch
+	 * reorder vertices into the order the indices first use them, so that
+	 * the pre transform fetches walk the vertex buffer forward. Unused
+	 * vertices are removed.
+	 * @param pVertices vertices, reordered in place
+	 * @param uVertexCount number of vertices
+	 * @param uVertexSize number of floats in a vertex
+	 * @param pIndices indices, remapped in place
+	 * @param uIndexCount number of indices
+	 * @return number of vertices left
+	 */
+	static size_t OptimizeVertexFetch(float* pVertices, size_t uVertexCount, uint32_t uVertexSize,
+		uint32_t* pIndices, size_t uIndexCount);
+
+	/**
+	 * GetACMR
+	 * simulate a FIFO post transform cache
+	 * @param pIndices triangle list indices
+	 * @param uIndexCount number of indices
+	 * @param uVertexCount number of vertices referenced by the indices
+	 * @param uCacheSize number of vertices in the cache
+	 * @return average cache miss ratio, vertex shader runs per triangle
+	 */
+	static float GetACMR(const uint32_t* pIndices, size_t uIndexCount, size_t uVertexCount, uint32_t uCacheSize = 16);
+
+	/**
+	 * GetATVR
+	 * @return vertex shader runs per used vertex with a FIFO cache, see GetACMR
+	 */
+	static float GetATVR(const uint32_t* pIndices, size_t uIndexCount, size_t uVertexCount, uint32_t uCacheSize = 16);
+
+	/**
+	 * GetOverdraw
+	 * rasterize the mesh in software from the six axis directions with
+	 * depth test and back face culling, in the order of the indices
+	 * @param pIndices triangle list indices
+	 * @param uIndexCount number of indices
+	 * @param pVertices vertices
+	 * @param uVertexCount number of vertices
+	 * @param uVertexSize number of floats in a vertex
+	 * @param uResolution size of the views in pixels
+	 * @return pixels shaded per pixel covered
+	 */
+	static float GetOverdraw(const uint32_t* pIndices, size_t uIndexCount,
+		const float* pVertices, size_t uVertexCount, uint32_t uVertexSize, uint32_t uResolution = 256);
+
+	/**
+	 * Analyze
+	 * @return all metrics of a triangle list, with the default parameters
+	 */
+	static MESHSTATS Analyze(const uint32_t* pIndices, size_t uIndexCount,
+		const float* pVertices, size_t uVertexCount, uint32_t uVertexSize);
+
+private:
+	static size_t GetCacheMisses(const uint32_t* pIndices, size_t uIndexCount, size_t uVertexCount,
+		uint32_t uCacheSize, size_t* pUsedVertices);
+};
@@ -20,6 +20,37 @@
 #endif
 #include "./GL/myGL.h"
 
+#include <map>
+
+
+// identifier of an uniform name, shared by all programs
+typedef uint32_t UniformId;
+
+// how the mip levels of a texture are made
+enum TEXTUREMIPMAPS
+{
+	MIPMAPS_NONE,
+	MIPMAPS_GPU,		// glGenerateMipmap after upload
+	MIPMAPS_BOX,		// 2x2 average on the cpu
+	MIPMAPS_KAISER		// kaiser windowed sinc on the cpu, sharper but slower
+};
+
+enum TEXTUREFILTER
+{
+	FILTER_NEAREST,
+	FILTER_BILINEAR,
+	FILTER_TRILINEAR	// blends between the two nearest mip levels
+};
+
+// creation and sampling options of a texture
+struct TEXTUREPARAMS
+{
+	TEXTUREMIPMAPS	eMipmaps = MIPMAPS_NONE;
+	TEXTUREFILTER	eFilter = FILTER_BILINEAR;
+	float			fAnisotropy = 1.0f;			// clamped to GetMaxAnisotropy
+	GLenum			eWrap = GL_CLAMP_TO_EDGE;
+};
+
 
 class COpenGLRenderer : public IRenderer
 {
@@ -54,11 +85,44 @@ public:
 
 	/**
 	 * CreateTexture
-	 * create opengl texture handle from image file
+	 * create opengl texture handle from image file. DDS files made with
+	 * texconv are uploaded as compressed blocks with their own mip levels.
 	 * @param strFilename file to load
+	 * @param params mipmaps, filtering and wrap mode
 	 * @return opengl texture handle, or 0 if failed
 	 */
-	GLuint CreateTexture(const std::string& strFilename);
+	GLuint CreateTexture(const std::string& strFilename, const TEXTUREPARAMS& params = TEXTUREPARAMS());
+
+	/**
+	 * UploadTexture
+	 * set the image and sampling parameters of a texture. With a pixel unpack
+	 * buffer bound, pPixels is nullptr and the levels start at the buffer offset 0.
+	 * @param uTexture texture handle
+	 * @param iWidth, iHeight size of level 0
+	 * @param pPixels premultiplied RGBA pixels. For MIPMAPS_BOX and MIPMAPS_KAISER
+	 * all levels one after another, as built by PixelKernels::BuildMipChain
+	 * @param params mipmaps, filtering and wrap mode
+	 */
+	void UploadTexture(GLuint uTexture, int32_t iWidth, int32_t iHeight, const unsigned char* pPixels, const TEXTUREPARAMS& params);
+
+	/**
+	 * GetMaxAnisotropy
+	 * @return largest anisotropy the driver supports, 1 if not supported
+	 */
+	inline float GetMaxAnisotropy() const { return m_fMaxAnisotropy; }
+
+	/**
+	 * HasCompressedTextures
+	 * @return true if BC1/BC3 textures can be uploaded without decoding
+	 */
+	inline bool HasCompressedTextures() const { return m_bS3TC; }
+
+	/**
+	 * HasHalfFloatVertices/HasPackedVertices
+	 * @return true if vertex attributes can be GL_HALF_FLOAT or GL_INT_2_10_10_10_REV
+	 */
+	inline bool HasHalfFloatVertices() const { return m_bHalfFloatVertex; }
+	inline bool HasPackedVertices() const { return m_bPackedVertex; }
 
 	/**
 	 * CreateVertexShader
@@ -72,9 +136,11 @@ public:
 	 * CreateVertexShaderFromFile
 	 * create opengl vertex shader from text file
 	 * @param strFilename text file to load
+	 * @param strDefines lines such as "#define NAME\n" inserted before the
+	 * source, after the #version line if there is one
 	 * @return opengl shader handle, or 0 if failed
 	 */
-	GLuint CreateVertexShaderFromFile(const std::string& strFilename);
+	GLuint CreateVertexShaderFromFile(const std::string& strFilename, const std::string& strDefines = std::string());
 
 	/**
 	 * CreateFragmentShader
@@ -88,9 +154,10 @@ public:
 	 * CreateFragmentShaderFromFile
 	 * create opengl fragment shader from text file
 	 * @param strFilename text file to load
+	 * @param strDefines lines inserted before the source, see CreateVertexShaderFromFile
 	 * @return opengl shader handle, or 0 if failed
 	 */
-	GLuint CreateFragmentShaderFromFile(const std::string& strFilename);
+	GLuint CreateFragmentShaderFromFile(const std::string& strFilename, const std::string& strDefines = std::string());
 
 	/**
 	 * CreateProgram
@@ -110,10 +177,216 @@ public:
 	void PrintShaderError(GLuint uShader);
 	void PrintProgramError(GLuint uProgram);
 
+	/**
+	 * GetUniformId
+	 * get the identifier of an uniform name. Resolve ids once and
+	 * store them, they are valid for all programs.
+	 * @param strName name of the uniform in shader source
+	 * @return uniform id
+	 */
+	static UniformId GetUniformId(const std::string& strName);
+
+	/**
+	 * GetUniformLocation
+	 * @param uProgram program handle
+	 * @param uId uniform id
+	 * @return location of the uniform in program, or -1 if program does not use it
+	 */
+	GLint GetUniformLocation(GLuint uProgram, UniformId uId) const;
+
+	/**
+	 * SetUniform
+	 * set uniform value to program. Upload is skipped if the program already has the same value.
+	 * Program must be current, as with glUniform* functions.
+	 * @param uProgram program handle
+	 * @param uId uniform id
+	 * @param value value to set
+	 */
+	void SetUniform(GLuint uProgram, UniformId uId, int32_t value);
+	void SetUniform(GLuint uProgram, UniformId uId, float value);
+	void SetUniform(GLuint uProgram, UniformId uId, const glm::vec2& value);
+	void SetUniform(GLuint uProgram, UniformId uId, const glm::vec3& value);
+	void SetUniform(GLuint uProgram, UniformId uId, const glm::vec4& value);
+	void SetUniform(GLuint uProgram, UniformId uId, const glm::mat3& value);
+	void SetUniform(GLuint uProgram, UniformId uId, const glm::mat4& value);
+
+	/**
+	 * Render state
+	 * the renderer shadows the GL state it sets and skips calls that would not
+	 * change it. All state changes must go through these methods, or the shadow
+	 * copy has to be reset with ResetState after calling GL directly.
+	 */
+	void UseProgram(GLuint uProgram);
+
+	/**
+	 * BindTexture
+	 * bind 2d texture into a texture unit. The unit is left active, so
+	 * glTexParameter* calls after this apply to the texture.
+	 * @param uUnit texture unit index, 0 for GL_TEXTURE0
+	 * @param uTexture texture handle
+	 */
+	void BindTexture(uint32_t uUnit, GLuint uTexture);
+
+	/**
+	 * BindBuffer
+	 * bind GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER or GL_UNIFORM_BUFFER. Element
+	 * array binding is vertex array state, it is shadowed only for the default vertex array.
+	 */
+	void BindBuffer(GLenum eTarget, GLuint uBuffer);
+	void BindVertexArray(GLuint uVertexArray);
+	void BindFramebuffer(GLuint uFrameBuffer);
+
+	/**
+	 * BindUniformBuffer
+	 * bind a range of a buffer to an indexed uniform buffer binding point. Also
+	 * sets the generic GL_UNIFORM_BUFFER binding, as glBindBufferRange does.
+	 * @param uIndex binding point, less than MAX_UNIFORM_BUFFERS
+	 * @param uBuffer buffer handle
+	 * @param iOffset start of the range in bytes, multiple of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	 * @param iSize size of the range in bytes
+	 */
+	void BindUniformBuffer(uint32_t uIndex, GLuint uBuffer, GLintptr iOffset, GLsizeiptr iSize);
+	static const uint32_t MAX_UNIFORM_BUFFERS = 4;
+
+	/**
+	 * HasUniformBuffers
+	 * @return true if the driver supports uniform buffer objects
+	 */
+	inline bool HasUniformBuffers() const { return glBindBufferRange && glGetUniformBlockIndex && glUniformBlockBinding && glBufferSubData; }
+
+	void SetBlend(bool bEnable);
+	void SetBlendFunc(GLenum eSrcFactor, GLenum eDstFactor);
+	void SetDepthTest(bool bEnable);
+	void SetDepthMask(bool bEnable);
+	void SetDepthFunc(GLenum eFunc);
+	void SetCulling(bool bEnable);
+	void SetCullFace(GLenum eFace);
+	void SetColorMask(bool bRed, bool bGreen, bool bBlue, bool bAlpha);
+
+	/**
+	 * DeleteTexture/DeleteBuffer/DeleteVertexArray/DeleteProgram
+	 * delete GL objects. Deleted objects are unbound by GL, the shadow copy is
+	 * updated so that a new object with a recycled handle gets bound.
+	 */
+	void DeleteTexture(GLuint uTexture);
+	void DeleteBuffer(GLuint uBuffer);
+	void DeleteVertexArray(GLuint uVertexArray);
+	void DeleteProgram(GLuint uProgram);
+
+	inline GLuint GetProgram() const { return m_State.uProgram; }
+	inline GLuint GetVertexArray() const { return m_State.uVertexArray; }
+	inline GLuint GetFramebuffer() const { return m_State.uFrameBuffer; }
+
+	/**
+	 * ResetState
+	 * set all shadowed state to GL, use after GL state was changed directly
+	 */
+	void ResetState();
+
+	/**
+	 * ValidateState
+	 * compare the shadow copy against the GL state, print the differences.
+	 * Called on every Flip in debug builds.
+	 * @return true if shadow copy matches
+	 */
+	bool ValidateState();
+
+	/**
+	 * GetStateCallsSaved
+	 * @return number of GL state calls skipped since last ResetStateCallsSaved
+	 */
+	inline uint32_t GetStateCallsSaved() const { return m_uStateCallsSaved; }
+	inline void ResetStateCallsSaved() { m_uStateCallsSaved = 0; }
+
 private:
 	bool InitFunctions();
 	bool SetDefaultSettings();
 
+	/**
+	 * CreateCompressedTexture
+	 * load a DDS file, decodes the blocks if the driver can not sample them
+	 */
+	GLuint CreateCompressedTexture(const std::string& strFilename, const TEXTUREPARAMS& params);
+
+	/**
+	 * SetTextureSampling
+	 * set filters, wrap mode and anisotropy of the texture bound to unit 0
+	 * @param iMaxLevel last mip level the texture has
+	 */
+	void SetTextureSampling(const TEXTUREPARAMS& params, int32_t iMaxLevel);
+
+	/**
+	 * ReflectProgram
+	 * store the locations of all active uniforms of a program
+	 * @param uProgram linked program handle
+	 */
+	void ReflectProgram(GLuint uProgram);
+
+	/**
+	 * GetChangedUniform
+	 * compare value against the value last set to the uniform and store it
+	 * @return location to upload the value to, or -1 if upload can be skipped
+	 */
+	GLint GetChangedUniform(GLuint uProgram, UniformId uId, const void* pValue, size_t uSize);
+
+	struct UNIFORM
+	{
+		GLint		iLocation = -1;
+		bool		bHasValue = false;
+		float		arrValue[16];
+	};
+
+	struct PROGRAM
+	{
+		// indexed by uniform id
+		std::vector<UNIFORM>	arrUniforms;
+	};
+
+	// reflection data, indexed by program handle
+	std::vector<PROGRAM>		m_arrPrograms;
+
+	static const uint32_t		MAX_TEXTURE_UNITS = 16;
+
+	struct UNIFORMBUFFER
+	{
+		GLuint		uBuffer = 0;
+		GLintptr	iOffset = 0;
+		GLsizeiptr	iSize = 0;
+	};
+
+	struct RENDERSTATE
+	{
+		GLuint		uProgram = 0;
+		uint32_t	uActiveTexture = 0;
+		GLuint		arrTextures[MAX_TEXTURE_UNITS] = {};
+		GLuint		uArrayBuffer = 0;
+		GLuint		uElementArrayBuffer = 0;
+		GLuint		uUniformBuffer = 0;
+		GLuint		uVertexArray = 0;
+		GLuint		uFrameBuffer = 0;
+		UNIFORMBUFFER	arrUniformBuffers[MAX_UNIFORM_BUFFERS];
+		bool		bBlend = false;
+		GLenum		eBlendSrc = GL_ONE;
+		GLenum		eBlendDst = GL_ZERO;
+		bool		bDepthTest = true;
+		bool		bDepthMask = true;
+		GLenum		eDepthFunc = GL_LEQUAL;
+		bool		bCulling = true;
+		GLenum		eCullFace = GL_BACK;
+		bool		arrColorMask[4] = { true, true, true, true };
+	};
+
+	// shadow copy of the GL state
+	RENDERSTATE					m_State;
+	uint32_t					m_uTextureUnits;
+	float						m_fMaxAnisotropy;
+	bool						m_bS3TC;
+	bool						m_bHalfFloatVertex;
+	bool						m_bPackedVertex;
+	uint32_t					m_uStateCallsSaved;
+
+	static std::map<std::string, UniformId>	s_mapUniformIds;
+
 #if defined (_WINDOWS)
 	HDC				m_Context;
 	HGLRC			m_hRC;
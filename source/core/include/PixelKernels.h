@@ -0,0 +1,79 @@
+/**
+ * ============================================================================
+ *  Name        : PixelKernels.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : image pixel conversion kernels, with SSE2 and AVX2 paths
+ *                selected at runtime
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/TransformKernels.h"
+#include <vector>
+
+class JobSystem;
+
+// filters for building mip levels on the cpu
+enum MIPFILTER
+{
+	MIPFILTER_BOX,
+	MIPFILTER_KAISER
+};
+
+class PixelKernels
+{
+public:
+	/**
+	 * GetLevel/SetLevel
+	 * instruction set the kernels use, defaults to TransformKernels::GetBestLevel.
+	 * Level is clamped to the best supported level.
+	 */
+	static SIMDLEVEL GetLevel();
+	static void SetLevel(SIMDLEVEL eLevel);
+
+	/**
+	 * GetLevelName
+	 * @return printable name of the instruction set the kernels use
+	 */
+	static const char* GetLevelName();
+
+	/**
+	 * PremultiplyAlpha
+	 * multiply the color of RGBA pixels with their alpha for faster blending,
+	 * color = color * alpha / 255 rounded down. All levels give the same result.
+	 * @param pPixels pixels to convert in place
+	 * @param uPixelCount number of pixels
+	 * @param pJobs if set, large images are split across the worker threads
+	 */
+	static void PremultiplyAlpha(unsigned char* pPixels, size_t uPixelCount, JobSystem* pJobs = nullptr);
+
+	/**
+	 * GetMipLevelCount
+	 * @param iWidth, iHeight size of the largest level
+	 * @return number of levels down to 1x1
+	 */
+	static uint32_t GetMipLevelCount(int32_t iWidth, int32_t iHeight);
+
+	/**
+	 * BuildMipChain
+	 * append the smaller mip levels of a premultiplied RGBA image, each level
+	 * half the size of the previous one rounded down, down to 1x1. Box filter
+	 * averages 2x2 blocks, the kaiser windowed sinc keeps more detail.
+	 * Edges are clamped.
+	 * @param arrPixels level 0 on input, all levels one after another on return
+	 * @param iWidth, iHeight size of level 0
+	 * @param eFilter filter to use
+	 */
+	static void BuildMipChain(std::vector<unsigned char>& arrPixels, int32_t iWidth, int32_t iHeight, MIPFILTER eFilter);
+
+private:
+	static void Downsample(const unsigned char* pSource, int32_t iWidth, int32_t iHeight,
+		unsigned char* pDest, int32_t iDestWidth, int32_t iDestHeight, MIPFILTER eFilter);
+
+	static void PremultiplyRange(unsigned char* pPixels, size_t uPixelCount);
+
+	static SIMDLEVEL	s_eLevel;
+};
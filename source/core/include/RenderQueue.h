@@ -0,0 +1,129 @@
+/**
+ * ============================================================================
+ *  Name        : RenderQueue.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : collects draw packets from the scenegraph and submits them
+ *                sorted by render state
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/Geometry.h"
+#include "../include/Material.h"
+#include <unordered_map>
+
+/**
+ * TEXTURESET
+ * textures bound to units 0..uCount-1, sampled through uniforms texture01, texture02...
+ */
+struct TEXTURESET
+{
+	static const uint32_t MAX_TEXTURES = 4;
+
+	GLuint		arrTextures[MAX_TEXTURES] = {};
+	uint32_t	uCount = 0;
+};
+
+
+class RenderQueue
+{
+public:
+	RenderQueue();
+	~RenderQueue();
+
+	/**
+	 * Add
+	 * add a draw packet into the queue
+	 * @param uProgram program to draw with
+	 * @param pTextures textures to bind, may be nullptr
+	 * @param pMaterial material to draw with, may be nullptr
+	 * @param pGeometry geometry to draw
+	 * @param mWorld world matrix of the object
+	 */
+	void Add(GLuint uProgram, const TEXTURESET* pTextures, Material* pMaterial, const Geometry* pGeometry, const glm::mat4& mWorld);
+
+	/**
+	 * Sort
+	 * sort the packets by their state key. Packets with equal keys keep their
+	 * traversal order.
+	 */
+	void Sort();
+
+	/**
+	 * Submit
+	 * draw the packets in sorted order, changing only the state that differs
+	 * from the previous packet. Sets modelMatrix, modelViewProjectionMatrix and
+	 * normalMatrix uniforms per packet.
+	 * @param pRenderer renderer to use
+	 */
+	void Submit(COpenGLRenderer* pRenderer);
+
+	/**
+	 * Clear
+	 * remove all packets, keeps the memory for the next frame
+	 */
+	void Clear();
+
+	inline size_t GetPacketCount() const { return m_arrPackets.size(); }
+
+	/**
+	 * GetUnsortedStateChanges
+	 * @return number of state changes the packets would need in traversal order
+	 */
+	inline uint32_t GetUnsortedStateChanges() const { return m_uUnsortedStateChanges; }
+
+	/**
+	 * GetSortedStateChanges
+	 * @return number of state changes made by the last Submit
+	 */
+	inline uint32_t GetSortedStateChanges() const { return m_uSortedStateChanges; }
+
+private:
+	struct DRAWPACKET
+	{
+		uint64_t			uSortKey;
+		GLuint				uProgram;
+		const TEXTURESET*	pTextures;
+		Material*			pMaterial;
+		const Geometry*		pGeometry;
+		glm::mat4			mWorld;
+	};
+
+	struct STATE
+	{
+		GLuint				uProgram = 0;
+		GLuint				arrTextures[TEXTURESET::MAX_TEXTURES] = {};
+		Material*			pMaterial = nullptr;
+		const Geometry*		pGeometry = nullptr;
+	};
+
+	/**
+	 * GetKeyIndex
+	 * @return 16 bit index of the state object in this frame, used as part of the sort key.
+	 * Objects past the 16 bit range share the last index.
+	 */
+	static uint64_t GetKeyIndex(std::unordered_map<uintptr_t, uint16_t>& mapIds, uintptr_t id);
+
+	/**
+	 * CountStateChanges
+	 * count the state changes from current state to the packet and update the state
+	 */
+	static uint32_t CountStateChanges(STATE& state, const DRAWPACKET& packet);
+
+	std::vector<DRAWPACKET>		m_arrPackets;
+	std::vector<uint32_t>		m_arrOrder;
+	std::vector<uint32_t>		m_arrTemp;
+
+	// key indices of programs, texture sets, materials and geometries, reset by Clear
+	std::unordered_map<uintptr_t, uint16_t>	m_mapProgramIds;
+	std::unordered_map<uintptr_t, uint16_t>	m_mapTextureSetIds;
+	std::unordered_map<uintptr_t, uint16_t>	m_mapMaterialIds;
+	std::unordered_map<uintptr_t, uint16_t>	m_mapGeometryIds;
+
+	uint32_t					m_uUnsortedStateChanges;
+	uint32_t					m_uSortedStateChanges;
+};
+
@@ -0,0 +1,108 @@
+/**
+ * ============================================================================
+ *  Name        : ShadowCascades.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : cascaded shadow map splits fitted to the camera frustum
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/IRenderer.h"
+
+class ShadowCascades
+{
+public:
+	static const uint32_t MAX_CASCADES = 4;
+
+	ShadowCascades();
+	~ShadowCascades();
+
+	/**
+	 * SetCascadeCount
+	 * @param uCount number of cascades, 1 to MAX_CASCADES
+	 */
+	void SetCascadeCount(uint32_t uCount);
+	inline uint32_t GetCascadeCount() const { return m_uCascadeCount; }
+
+	/**
+	 * SetMaxDistance
+	 * @param fDistance view distance the cascades cover, beyond it nothing is shadowed
+	 */
+	inline void SetMaxDistance(float fDistance) { m_fMaxDistance = fDistance; }
+
+	/**
+	 * SetSplitLambda
+	 * @param fLambda blend between uniform (0) and logarithmic (1) split distances
+	 */
+	inline void SetSplitLambda(float fLambda) { m_fSplitLambda = fLambda; }
+
+	/**
+	 * SetCasterDistance
+	 * @param fDistance how far towards the light from a cascade casters are still included
+	 */
+	inline void SetCasterDistance(float fDistance) { m_fCasterDistance = fDistance; }
+
+	/**
+	 * Update
+	 * fit the cascades to the camera frustum, once per frame before the
+	 * shadow pass. Each cascade is a sphere around its slice of the frustum,
+	 * so its size does not change as the camera turns, and its position is
+	 * snapped to whole texels so that the shadow edges do not swim.
+	 * @param mView camera view matrix
+	 * @param mProjection camera perspective projection matrix
+	 * @param vLightDirection direction the light travels towards
+	 * @param uTileSize size of one cascade in the atlas, in texels
+	 */
+	void Update(const glm::mat4& mView, const glm::mat4& mProjection, const glm::vec3& vLightDirection, uint32_t uTileSize);
+
+	/**
+	 * GetAtlasSize
+	 * cascades are packed into a 2x2 atlas
+	 * @param uTileSize size of one cascade in texels
+	 * @return width and height of the atlas texture in texels
+	 */
+	static inline uint32_t GetAtlasSize(uint32_t uTileSize) { return uTileSize * 2; }
+
+	/**
+	 * GetTileViewport
+	 * @param uCascade cascade index
+	 * @param uTileSize size of one cascade in texels
+	 * @return x, y of the viewport of the cascade in the atlas, width and height are uTileSize
+	 */
+	static inline glm::ivec2 GetTileViewport(uint32_t uCascade, uint32_t uTileSize)
+	{
+		return glm::ivec2((uCascade & 1) * uTileSize, (uCascade >> 1) * uTileSize);
+	}
+
+	/**
+	 * GetViewProjection
+	 * @return view projection matrix to render the casters of a cascade with
+	 */
+	inline const glm::mat4& GetViewProjection(uint32_t uCascade) const { return m_arrViewProjections[uCascade]; }
+
+	/**
+	 * GetShadowMatrix
+	 * @return matrix from world space to the atlas texture coordinates and depth of a cascade
+	 */
+	inline const glm::mat4& GetShadowMatrix(uint32_t uCascade) const { return m_arrShadowMatrices[uCascade]; }
+
+	/**
+	 * GetSplitDistances
+	 * @return far view distance of each cascade, for picking the cascade in
+	 * the shader. Unused cascades get zero.
+	 */
+	inline const glm::vec4& GetSplitDistances() const { return m_vSplitDistances; }
+
+private:
+	uint32_t		m_uCascadeCount;
+	float			m_fMaxDistance;
+	float			m_fSplitLambda;
+	float			m_fCasterDistance;
+
+	glm::mat4		m_arrViewProjections[MAX_CASCADES];
+	glm::mat4		m_arrShadowMatrices[MAX_CASCADES];
+	glm::vec4		m_vSplitDistances;
+};
@@ -0,0 +1,127 @@
+/**
+ * ============================================================================
+ *  Name        : SpatialHash.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : uniform spatial hash grid broadphase for bounding spheres
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/IRenderer.h"
+#include <algorithm>
+#include <vector>
+
+class IGraphNode;
+class JobSystem;
+
+class SpatialHash
+{
+public:
+	struct PAIR
+	{
+		uint32_t	uFirst;
+		uint32_t	uSecond;
+	};
+
+	SpatialHash();
+	~SpatialHash();
+
+	/**
+	 * SetJobSystem
+	 * split the pair search across worker threads
+	 * @param pJobs job system to use, or nullptr to search on the calling thread
+	 */
+	inline void SetJobSystem(JobSystem* pJobs) { m_pJobs = pJobs; }
+
+	/**
+	 * Build
+	 * rebuild the grid from bounding spheres and find the overlapping pairs.
+	 * Cell size is twice the largest diameter, so each sphere is tested
+	 * against the 2x2x2 cells around it.
+	 * @param pPositions sphere centers
+	 * @param pRadii sphere radii
+	 * @param uCount number of spheres
+	 */
+	void Build(const glm::vec3* pPositions, const float* pRadii, uint32_t uCount);
+
+	/**
+	 * Build
+	 * rebuild the grid from the positions and radii of scenegraph nodes,
+	 * pair indices refer to the array
+	 * @param arrNodes nodes to test
+	 */
+	void Build(const std::vector<IGraphNode*>& arrNodes);
+
+	/**
+	 * GetPairs
+	 * @return unique pairs of overlapping spheres found by the last Build,
+	 * uFirst is always smaller than uSecond
+	 */
+	inline const std::vector<PAIR>& GetPairs() const { return m_arrPairs; }
+
+private:
+	struct CELL
+	{
+		int32_t		x, y, z;
+		uint32_t	uBucket;
+	};
+
+	struct ENTRY
+	{
+		glm::vec3	vPos;
+		float		fRadius;
+		int32_t		x, y, z;
+		uint32_t	uIndex;
+	};
+
+	/**
+	 * QueryRange
+	 * find the pairs of sorted entries [uBegin, uEnd)
+	 */
+	void QueryRange(uint32_t uBegin, uint32_t uEnd, std::vector<PAIR>& arrPairs) const;
+
+	static inline void TestPair(const ENTRY& a, const ENTRY& b, std::vector<PAIR>& arrPairs)
+	{
+		const glm::vec3 d(b.vPos - a.vPos);
+		const float r = a.fRadius + b.fRadius;
+		if (glm::dot(d, d) < r * r)
+		{
+			PAIR pair;
+			pair.uFirst = std::min(a.uIndex, b.uIndex);
+			pair.uSecond = std::max(a.uIndex, b.uIndex);
+			arrPairs.push_back(pair);
+		}
+	}
+
+	// cells wrap around a grid of buckets, so neighbouring cells are also
+	// neighbours in memory and the neighbour lookups stay in cache
+	inline uint32_t GetBucket(int32_t x, int32_t y, int32_t z) const
+	{
+		return ((uint32_t)x & m_uMaskX) | (((uint32_t)y & m_uMaskY) << m_uShiftY) | (((uint32_t)z & m_uMaskZ) << m_uShiftZ);
+	}
+
+	JobSystem*					m_pJobs;
+
+	float						m_fInvCellSize;
+	float						m_fMaxRadius;
+	uint32_t					m_uMaskX;
+	uint32_t					m_uMaskY;
+	uint32_t					m_uMaskZ;
+	uint32_t					m_uShiftY;
+	uint32_t					m_uShiftZ;
+
+	// spheres sorted by bucket, m_arrBucketStart[b]..m_arrBucketStart[b+1]
+	std::vector<uint32_t>		m_arrBucketStart;
+	std::vector<ENTRY>			m_arrEntries;
+	std::vector<CELL>			m_arrCells;
+
+	std::vector<PAIR>			m_arrPairs;
+	std::vector<std::vector<PAIR>>	m_arrRangePairs;
+
+	// scratch copies for building from nodes
+	std::vector<glm::vec3>		m_arrNodePositions;
+	std::vector<float>			m_arrNodeRadii;
+};
@@ -0,0 +1,84 @@
+/**
+ * ============================================================================
+ *  Name        : TextureCompression.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : BC1/BC3 block compression and DDS files
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+// block compressed formats, 4x4 pixel blocks
+enum BLOCKFORMAT
+{
+	BLOCKFORMAT_BC1,		// DXT1, opaque RGB, 8 bytes per block
+	BLOCKFORMAT_BC3			// DXT5, RGBA, 16 bytes per block
+};
+
+class TextureCompression
+{
+public:
+	// compressed image with its mip levels
+	struct IMAGE
+	{
+		BLOCKFORMAT					eFormat = BLOCKFORMAT_BC1;
+		int32_t						iWidth = 0;
+		int32_t						iHeight = 0;
+		uint32_t					uLevels = 0;
+
+		// all levels one after another, largest first
+		std::vector<unsigned char>	arrData;
+	};
+
+	/**
+	 * GetLevelSize
+	 * @param eFormat block format
+	 * @param iWidth, iHeight level size in pixels
+	 * @return size of the level in bytes
+	 */
+	static size_t GetLevelSize(BLOCKFORMAT eFormat, int32_t iWidth, int32_t iHeight);
+
+	/**
+	 * Encode
+	 * compress RGBA pixels into blocks. Edge blocks of sizes that are not
+	 * a multiple of 4 repeat the last row and column.
+	 * @param pPixels RGBA pixels
+	 * @param iWidth, iHeight image size
+	 * @param eFormat block format
+	 * @param pBlocks GetLevelSize bytes of output
+	 * @param pJobs if set, block rows are split across the worker threads
+	 */
+	static void Encode(const unsigned char* pPixels, int32_t iWidth, int32_t iHeight, BLOCKFORMAT eFormat, unsigned char* pBlocks, JobSystem* pJobs = nullptr);
+
+	/**
+	 * Decode
+	 * decompress blocks into RGBA pixels, as the GPU samples them
+	 * @param pBlocks compressed blocks
+	 * @param iWidth, iHeight image size
+	 * @param eFormat block format
+	 * @param pPixels iWidth * iHeight RGBA pixels of output
+	 */
+	static void Decode(const unsigned char* pBlocks, int32_t iWidth, int32_t iHeight, BLOCKFORMAT eFormat, unsigned char* pPixels);
+
+	/**
+	 * SaveDDS/LoadDDS
+	 * write and read DXT1 and DXT5 DDS files
+	 * @param strFilename file name
+	 * @param image image to write, or read into
+	 * @return true if successful
+	 */
+	static bool SaveDDS(const std::string& strFilename, const IMAGE& image);
+	static bool LoadDDS(const std::string& strFilename, IMAGE& image);
+
+private:
+	static void EncodeRows(const unsigned char* pPixels, int32_t iWidth, int32_t iHeight, BLOCKFORMAT eFormat,
+		unsigned char* pBlocks, int32_t iFirstRow, int32_t iLastRow);
+};
@@ -0,0 +1,97 @@
+/**
+ * ============================================================================
+ *  Name        : TextureLoader.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : textures decoded on worker threads and uploaded within a budget
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/OpenGLRenderer.h"
+#include "../include/JobSystem.h"
+
+class TextureLoader
+{
+public:
+	TextureLoader();
+	~TextureLoader();
+
+	/**
+	 * Create
+	 * @param pRenderer renderer to create the textures with
+	 * @param pJobs job system to decode the images on
+	 * @return true if successful
+	 */
+	bool Create(COpenGLRenderer* pRenderer, JobSystem* pJobs);
+
+	/**
+	 * Release
+	 * wait for the decoding jobs and drop the loads that are not finished,
+	 * their textures keep the placeholder. Textures are not deleted.
+	 */
+	void Release();
+
+	/**
+	 * Load
+	 * start loading a texture. Returns at once with a texture that holds a
+	 * grey placeholder pixel until the image is decoded and uploaded.
+	 * Cpu mipmaps are built by the decoding job.
+	 * @param strFilename image file to load
+	 * @param params mipmaps, filtering and wrap mode, applied when the image arrives
+	 * @return opengl texture handle
+	 */
+	GLuint Load(const std::string& strFilename, const TEXTUREPARAMS& params = TEXTUREPARAMS());
+
+	/**
+	 * Update
+	 * stage decoded images and their mip levels into pixel buffers, at most
+	 * uByteBudget bytes per call but always at least one row, and hand
+	 * completed images to their textures. Call once per frame on the render thread.
+	 * @param uByteBudget bytes of pixel data to copy this frame
+	 */
+	void Update(uint32_t uByteBudget);
+
+	/**
+	 * GetPendingCount
+	 * @return number of textures still loading
+	 */
+	inline uint32_t GetPendingCount() const { return (uint32_t)m_arrRequests.size(); }
+
+	/**
+	 * IsLoaded
+	 * @param uTexture handle returned by Load
+	 * @return true if the image is in the texture, or loading has failed
+	 */
+	bool IsLoaded(GLuint uTexture) const;
+
+private:
+	struct REQUEST
+	{
+		GLuint					uTexture = 0;
+		std::string				strFilename;
+		TEXTUREPARAMS			params;
+		int32_t					iWidth = 0;
+		int32_t					iHeight = 0;
+
+		// all mip levels one after another, empty if decoding failed
+		std::vector<unsigned char>	arrPixels;
+		GLuint					uPixelBuffer = 0;
+		size_t					uBytesStaged = 0;
+
+		// set by the decoding job when arrPixels, iWidth and iHeight are written
+		std::atomic<bool>		bDecoded{ false };
+	};
+
+	static void Decode(REQUEST* pRequest, JobSystem* pJobs);
+	void FreeRequest(REQUEST* pRequest);
+
+	COpenGLRenderer*					m_pRenderer;
+	JobSystem*							m_pJobs;
+
+	// in the order of Load, owned by the loader
+	std::vector<REQUEST*>				m_arrRequests;
+	std::atomic<uint32_t>				m_uJobs;
+};
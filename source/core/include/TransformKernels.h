@@ -0,0 +1,85 @@
+/**
+ * ============================================================================
+ *  Name        : TransformKernels.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : batch kernels for integrating and combining transforms,
+ *                with SSE2 and AVX2 paths selected at runtime
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/IRenderer.h"
+
+enum SIMDLEVEL
+{
+	SIMD_SCALAR = 0,
+	SIMD_SSE2,
+	SIMD_AVX2
+};
+
+class TransformKernels
+{
+public:
+	/**
+	 * GetBestLevel
+	 * @return best instruction set supported by the compiler and the cpu
+	 */
+	static SIMDLEVEL GetBestLevel();
+
+	/**
+	 * GetLevel
+	 * @return instruction set the kernels currently use
+	 */
+	static SIMDLEVEL GetLevel();
+
+	/**
+	 * SetLevel
+	 * force kernels to use an instruction set, e.g. for benchmarking.
+	 * Level is clamped to GetBestLevel.
+	 * @param eLevel requested instruction set
+	 */
+	static void SetLevel(SIMDLEVEL eLevel);
+
+	/**
+	 * GetLevelName
+	 * @return printable name of an instruction set
+	 */
+	static const char* GetLevelName(SIMDLEVEL eLevel);
+
+	/**
+	 * IntegratePositions
+	 * pPositions[i] += pVelocities[i] * fFrametime for all i
+	 * @param pPositions positions to move
+	 * @param pVelocities velocities to move with
+	 * @param uCount number of positions
+	 * @param fFrametime frame delta time
+	 */
+	static void IntegratePositions(glm::vec3* pPositions, const glm::vec3* pVelocities, uint32_t uCount, float fFrametime);
+
+	/**
+	 * AdvanceAngles
+	 * pAngles[i] += pSpeeds[i] * fFrametime for all i, wrapped into [0, 2pi)
+	 * @param pAngles angles to advance, in radians
+	 * @param pSpeeds angular speeds in radians per second
+	 * @param uCount number of angles
+	 * @param fFrametime frame delta time
+	 */
+	static void AdvanceAngles(float* pAngles, const float* pSpeeds, uint32_t uCount, float fFrametime);
+
+	/**
+	 * CombineMatrices
+	 * pWorlds[i] = pWorlds[pParents[i]] * pLocals[i], or pLocals[i] when
+	 * parent is 0xffffffff. Parents must be stored before their children.
+	 * @param pParents parent index of each matrix
+	 * @param pLocals local matrices
+	 * @param pWorlds output world matrices
+	 * @param uCount number of matrices
+	 */
+	static void CombineMatrices(const uint32_t* pParents, const glm::mat4* pLocals, glm::mat4* pWorlds, uint32_t uCount);
+
+private:
+	static SIMDLEVEL	s_eLevel;
+};
@@ -0,0 +1,136 @@
+/**
+ * ============================================================================
+ *  Name        : TransformPool.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : structure-of-arrays storage for scenegraph node transforms
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/IRenderer.h"
+#include <vector>
+
+typedef uint32_t TransformHandle;
+
+class JobSystem;
+
+class TransformPool
+{
+public:
+	static const TransformHandle INVALID_HANDLE = 0xffffffff;
+
+	TransformPool();
+	~TransformPool();
+
+	/**
+	 * Reserve
+	 * preallocate room for transforms to avoid reallocations while building a scene
+	 * @param uCount number of transforms
+	 */
+	void Reserve(uint32_t uCount);
+
+	/**
+	 * Allocate
+	 * add a new identity transform into the pool. Transforms are appended, so
+	 * a parent always has a smaller handle than its children and the world
+	 * matrix pass can run as a single linear sweep.
+	 * @param hParent handle of the parent transform or INVALID_HANDLE
+	 * @return handle to the new transform
+	 */
+	TransformHandle Allocate(TransformHandle hParent);
+
+	/**
+	 * Clear
+	 * remove all transforms, all handles become invalid.
+	 * Transforms are not released one by one, the owner of the pool clears it
+	 * together with its scene.
+	 */
+	void Clear();
+
+	/**
+	 * GetCount
+	 * @return number of transforms in the pool
+	 */
+	inline uint32_t GetCount() const { return (uint32_t)m_arrParents.size(); }
+
+	/**
+	 * SetJobSystem
+	 * split Integrate across worker threads
+	 * @param pJobs job system to use, or nullptr to integrate on the calling thread
+	 */
+	inline void SetJobSystem(JobSystem* pJobs) { m_pJobs = pJobs; }
+
+	/**
+	 * Integrate
+	 * move all transforms by their velocity and rotate them by their rotation speed
+	 * @param fFrametime frame delta time
+	 */
+	void Integrate(float fFrametime);
+
+	/**
+	 * UpdateWorldMatrices
+	 * compute world matrices of all transforms in one parent-before-child sweep
+	 */
+	void UpdateWorldMatrices();
+
+	/**
+	 * SetPos
+	 * set position of a transform, also into its local matrix
+	 */
+	inline void SetPos(TransformHandle h, const glm::vec3& vPos)
+	{
+		m_arrPositions[h] = vPos;
+		m_arrLocalMatrices[h][3] = glm::vec4(vPos, 1.0f);
+	}
+
+	/**
+	 * SetLocalMatrix
+	 * set local matrix of a transform, position is taken from the matrix
+	 */
+	inline void SetLocalMatrix(TransformHandle h, const glm::mat4& m)
+	{
+		m_arrLocalMatrices[h] = m;
+		m_arrPositions[h] = glm::vec3(m[3]);
+	}
+
+	// per transform accessors. Position array owns the translation, Integrate
+	// writes it back into the local matrix.
+	inline TransformHandle GetParent(TransformHandle h) const { return m_arrParents[h]; }
+	inline const glm::vec3& GetPos(TransformHandle h) const { return m_arrPositions[h]; }
+	inline glm::vec3& GetVelocity(TransformHandle h) { return m_arrVelocities[h]; }
+	inline glm::vec3& GetRotationAxis(TransformHandle h) { return m_arrRotationAxes[h]; }
+	inline float& GetRotationAngle(TransformHandle h) { return m_arrRotationAngles[h]; }
+	inline float& GetRotationSpeed(TransformHandle h) { return m_arrRotationSpeeds[h]; }
+	inline float& GetRadius(TransformHandle h) { return m_arrRadii[h]; }
+	inline glm::mat4& GetLocalMatrix(TransformHandle h) { return m_arrLocalMatrices[h]; }
+	inline const glm::mat4& GetWorldMatrix(TransformHandle h) const { return m_arrWorldMatrices[h]; }
+
+	// whole arrays for systems sweeping over all transforms
+	inline glm::vec3* GetPositions() { return m_arrPositions.data(); }
+	inline glm::vec3* GetVelocities() { return m_arrVelocities.data(); }
+	inline float* GetRotationSpeeds() { return m_arrRotationSpeeds.data(); }
+	inline const float* GetRadii() const { return m_arrRadii.data(); }
+	inline const glm::mat4* GetWorldMatrices() const { return m_arrWorldMatrices.data(); }
+
+private:
+	void IntegrateRange(uint32_t uBegin, uint32_t uEnd, float fFrametime);
+
+	JobSystem*						m_pJobs;
+
+	std::vector<TransformHandle>	m_arrParents;
+
+	std::vector<glm::vec3>			m_arrPositions;
+	std::vector<glm::vec3>			m_arrVelocities;
+
+	std::vector<glm::vec3>			m_arrRotationAxes;
+	std::vector<float>				m_arrRotationAngles;
+	std::vector<float>				m_arrRotationSpeeds;
+
+	std::vector<float>				m_arrRadii;
+
+	std::vector<glm::mat4>			m_arrLocalMatrices;
+	std::vector<glm::mat4>			m_arrWorldMatrices;
+};
@@ -0,0 +1,93 @@
+/**
+ * ============================================================================
+ *  Name        : VertexFormat.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : compact quantized vertex layouts
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "MeshFile.h"
+
+// position encodings
+enum VERTEXPOSITION
+{
+	POSITION_FLOAT,				// 12 bytes
+	POSITION_HALF,				// 8 bytes, 3 half floats and padding
+	POSITION_INT16				// 8 bytes, normalized to the bounds, see Geometry::GetPositionTransform
+};
+
+// normal encodings
+enum VERTEXNORMAL
+{
+	NORMAL_FLOAT,				// 12 bytes
+	NORMAL_PACKED,				// 4 bytes, signed normalized 10:10:10:2
+	NORMAL_OCTAHEDRAL			// 4 bytes, 2 signed normalized shorts, decoded in the shader
+};
+
+// texture coordinate encodings
+enum VERTEXUV
+{
+	UV_FLOAT,					// 8 bytes
+	UV_HALF						// 4 bytes
+};
+
+/*
+ * Half positions, packed normals and half uvs need no shader changes. Int16
+ * positions are mapped back with Geometry::GetPositionTransform. Octahedral
+ * normals come in as a vec2 and are decoded by the shader, see DecodeNormal
+ * in lesson05/phongshader.vs.
+ */
+struct VERTEXLAYOUT
+{
+	VERTEXPOSITION	ePosition = POSITION_HALF;
+	VERTEXNORMAL	eNormal = NORMAL_PACKED;
+	VERTEXUV		eUv = UV_HALF;
+};
+
+class VertexFormat
+{
+public:
+	/**
+	 * GetStride
+	 * @param layout vertex layout
+	 * @return size of one vertex in bytes
+	 */
+	static uint32_t GetStride(const VERTEXLAYOUT& layout);
+
+	/**
+	 * GetAttributes
+	 * @param layout vertex layout
+	 * @param arrAttributes 'position', 'normal' and 'uv' attributes of the layout
+	 */
+	static void GetAttributes(const VERTEXLAYOUT& layout, std::vector<MESHATTRIBUTE>& arrAttributes);
+
+	/**
+	 * Encode
+	 * convert vertices in the VERTEX layout, 8 floats each
+	 * @param pVertices source vertices
+	 * @param uVertexCount number of vertices
+	 * @param layout layout to convert to
+	 * @param pBoundsMin, pBoundsMax bounding box of the positions, used by POSITION_INT16
+	 * @param pOutput uVertexCount * GetStride(layout) bytes
+	 */
+	static void Encode(const float* pVertices, size_t uVertexCount, const VERTEXLAYOUT& layout,
+		const float* pBoundsMin, const float* pBoundsMax, unsigned char* pOutput);
+
+	/**
+	 * FloatToHalf/HalfToFloat
+	 * IEEE half precision conversion, rounds to nearest even
+	 */
+	static uint16_t FloatToHalf(float fValue);
+	static float HalfToFloat(uint16_t uValue);
+
+	/**
+	 * GetInt16Scale
+	 * @param pBoundsMin, pBoundsMax bounding box of the positions
+	 * @param arrCenter, arrScale POSITION_INT16 maps back as center + value * scale
+	 */
+	static void GetInt16Scale(const float* pBoundsMin, const float* pBoundsMax, float* arrCenter, float* arrScale);
+};
@@ -0,0 +1,564 @@
+/**
+ * ============================================================================
+ *  Name        : AABBTree.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : dynamic bounding volume hierarchy of fat AABBs
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#include "../include/AABBTree.h"
+#include <algorithm>
+
+
+AABBTree::AABBTree()
+{
+	m_iRoot = NULL_NODE;
+	m_iFreeList = NULL_NODE;
+	m_uProxyCount = 0;
+	m_fMargin = 0.2f;
+}
+
+
+AABBTree::~AABBTree()
+{
+}
+
+
+void AABBTree::Clear()
+{
+	m_arrNodes.clear();
+	m_iRoot = NULL_NODE;
+	m_iFreeList = NULL_NODE;
+	m_uProxyCount = 0;
+}
+
+
+int32_t AABBTree::CreateProxy(const AABB& box, void* pUserData)
+{
+	const int32_t iProxy = AllocateNode();
+	NODE& node = m_arrNodes[iProxy];
+	node.box = AABB(box.vMin - m_fMargin, box.vMax + m_fMargin);
+	node.pUserData = pUserData;
+	node.iHeight = 0;
+
+	InsertLeaf(iProxy);
+	m_uProxyCount++;
+	return iProxy;
+}
+
+
+void AABBTree::DestroyProxy(int32_t iProxy)
+{
+	RemoveLeaf(iProxy);
+	FreeNode(iProxy);
+	m_uProxyCount--;
+}
+
+
+bool AABBTree::MoveProxy(int32_t iProxy, const AABB& box)
+{
+	// most frames objects stay inside their fat boxes and the tree is not touched
+	if (m_arrNodes[iProxy].box.Contains(box))
+	{
+		return false;
+	}
+
+	RemoveLeaf(iProxy);
+	m_arrNodes[iProxy].box = AABB(box.vMin - m_fMargin, box.vMax + m_fMargin);
+	InsertLeaf(iProxy);
+	return true;
+}
+
+
+void AABBTree::QueryFrustum(const FRUSTUM& frustum, std::vector<int32_t>& arrProxies) const
+{
+	arrProxies.clear();
+	if (m_iRoot == NULL_NODE)
+	{
+		return;
+	}
+
+	std::vector<int32_t> arrStack;
+	std::vector<int32_t> arrSubtree;
+	arrStack.push_back(m_iRoot);
+	while (!arrStack.empty())
+	{
+		const NODE& node = m_arrNodes[arrStack.back()];
+		const int32_t iNode = arrStack.back();
+		arrStack.pop_back();
+
+		const CULLRESULT eResult = frustum.Classify(node.box);
+		if (eResult == CULL_OUTSIDE)
+		{
+			continue;
+		}
+
+		if (node.IsLeaf())
+		{
+			arrProxies.push_back(iNode);
+		}
+		else if (eResult == CULL_INSIDE)
+		{
+			// everything below is inside as well
+			AddLeaves(iNode, arrProxies, arrSubtree);
+		}
+		else
+		{
+			arrStack.push_back(node.iChild1);
+			arrStack.push_back(node.iChild2);
+		}
+	}
+}
+
+
+void AABBTree::QueryBox(const AABB& box, std::vector<int32_t>& arrProxies) const
+{
+	arrProxies.clear();
+	if (m_iRoot == NULL_NODE)
+	{
+		return;
+	}
+
+	std::vector<int32_t> arrStack;
+	arrStack.push_back(m_iRoot);
+	while (!arrStack.empty())
+	{
+		const int32_t iNode = arrStack.back();
+		const NODE& node = m_arrNodes[iNode];
+		arrStack.pop_back();
+
+		if (!node.box.Overlaps(box))
+		{
+			continue;
+		}
+
+		if (node.IsLeaf())
+		{
+			arrProxies.push_back(iNode);
+		}
+		else
+		{
+			arrStack.push_back(node.iChild1);
+			arrStack.push_back(node.iChild2);
+		}
+	}
+}
+
+
+void AABBTree::QuerySphere(const glm::vec3& vCenter, float fRadius, std::vector<int32_t>& arrProxies) const
+{
+	arrProxies.clear();
+	if (m_iRoot == NULL_NODE)
+	{
+		return;
+	}
+
+	const float fRadiusSq = fRadius * fRadius;
+
+	std::vector<int32_t> arrStack;
+	arrStack.push_back(m_iRoot);
+	while (!arrStack.empty())
+	{
+		const int32_t iNode = arrStack.back();
+		const NODE& node = m_arrNodes[iNode];
+		arrStack.pop_back();
+
+		// distance from the center to the closest point of the box
+		const glm::vec3 d(vCenter - glm::clamp(vCenter, node.box.vMin, node.box.vMax));
+		if (glm::dot(d, d) > fRadiusSq)
+		{
+			continue;
+		}
+
+		if (node.IsLeaf())
+		{
+			arrProxies.push_back(iNode);
+		}
+		else
+		{
+			arrStack.push_back(node.iChild1);
+			arrStack.push_back(node.iChild2);
+		}
+	}
+}
+
+
+void AABBTree::QueryRay(const glm::vec3& vOrigin, const glm::vec3& vDirection, float fMaxDistance, std::vector<int32_t>& arrProxies) const
+{
+	arrProxies.clear();
+	if (m_iRoot == NULL_NODE)
+	{
+		return;
+	}
+
+	// zero direction components give infinities, which the slab test handles
+	const glm::vec3 vInvDirection(1.0f / vDirection.x, 1.0f / vDirection.y, 1.0f / vDirection.z);
+
+	std::vector<int32_t> arrStack;
+	arrStack.push_back(m_iRoot);
+	while (!arrStack.empty())
+	{
+		const int32_t iNode = arrStack.back();
+		const NODE& node = m_arrNodes[iNode];
+		arrStack.pop_back();
+
+		// entry and exit distances of the slabs of each axis
+		const glm::vec3 t1((node.box.vMin - vOrigin) * vInvDirection);
+		const glm::vec3 t2((node.box.vMax - vOrigin) * vInvDirection);
+		const glm::vec3 tNear(glm::min(t1, t2));
+		const glm::vec3 tFar(glm::max(t1, t2));
+		const float fEnter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+		const float fExit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, fMaxDistance));
+		if (fEnter > fExit)
+		{
+			continue;
+		}
+
+		if (node.IsLeaf())
+		{
+			arrProxies.push_back(iNode);
+		}
+		else
+		{
+			arrStack.push_back(node.iChild1);
+			arrStack.push_back(node.iChild2);
+		}
+	}
+}
+
+
+void AABBTree::QueryPairs(std::vector<PAIR>& arrPairs) const
+{
+	arrPairs.clear();
+
+	// query the tree with each leaf, the larger id of a pair reports it
+	std::vector<int32_t> arrStack;
+	for (int32_t i=0; i<(int32_t)m_arrNodes.size(); i++)
+	{
+		const NODE& leaf = m_arrNodes[i];
+		if (leaf.iHeight != 0)
+		{
+			continue;
+		}
+
+		arrStack.push_back(m_iRoot);
+		while (!arrStack.empty())
+		{
+			const int32_t iNode = arrStack.back();
+			const NODE& node = m_arrNodes[iNode];
+			arrStack.pop_back();
+
+			if (!node.box.Overlaps(leaf.box))
+			{
+				continue;
+			}
+
+			if (!node.IsLeaf())
+			{
+				arrStack.push_back(node.iChild1);
+				arrStack.push_back(node.iChild2);
+			}
+			else if (iNode < i)
+			{
+				PAIR pair;
+				pair.iFirst = iNode;
+				pair.iSecond = i;
+				arrPairs.push_back(pair);
+			}
+		}
+	}
+}
+
+
+void AABBTree::AddLeaves(int32_t iNode, std::vector<int32_t>& arrProxies, std::vector<int32_t>& arrStack) const
+{
+	arrStack.push_back(iNode);
+	while (!arrStack.empty())
+	{
+		const NODE& node = m_arrNodes[arrStack.back()];
+		const int32_t iCurrent = arrStack.back();
+		arrStack.pop_back();
+
+		if (node.IsLeaf())
+		{
+			arrProxies.push_back(iCurrent);
+		}
+		else
+		{
+			arrStack.push_back(node.iChild1);
+			arrStack.push_back(node.iChild2);
+		}
+	}
+}
+
+
+int32_t AABBTree::AllocateNode()
+{
+	int32_t iNode;
+	if (m_iFreeList != NULL_NODE)
+	{
+		iNode = m_iFreeList;
+		m_iFreeList = m_arrNodes[iNode].iParent;
+	}
+	else
+	{
+		iNode = (int32_t)m_arrNodes.size();
+		m_arrNodes.push_back(NODE());
+	}
+
+	NODE& node = m_arrNodes[iNode];
+	node.pUserData = nullptr;
+	node.iParent = NULL_NODE;
+	node.iChild1 = NULL_NODE;
+	node.iChild2 = NULL_NODE;
+	node.iHeight = 0;
+	return iNode;
+}
+
+
+void AABBTree::FreeNode(int32_t iNode)
+{
+	NODE& node = m_arrNodes[iNode];
+	node.iParent = m_iFreeList;
+	node.iHeight = -1;
+	m_iFreeList = iNode;
+}
+
+
+void AABBTree::InsertLeaf(int32_t iLeaf)
+{
+	if (m_iRoot == NULL_NODE)
+	{
+		m_iRoot = iLeaf;
+		m_arrNodes[iLeaf].iParent = NULL_NODE;
+		return;
+	}
+
+	// walk down to the sibling that grows the total surface area the least
+	const AABB leafBox = m_arrNodes[iLeaf].box;
+	int32_t iIndex = m_iRoot;
+	while (!m_arrNodes[iIndex].IsLeaf())
+	{
+		const NODE& node = m_arrNodes[iIndex];
+		const float fArea = node.box.GetSurfaceArea();
+		const float fCombinedArea = AABB::Merge(node.box, leafBox).GetSurfaceArea();
+
+		// cost of making a new parent for this node and the leaf
+		const float fCost = 2.0f * fCombinedArea;
+
+		// minimum cost of pushing the leaf further down
+		const float fInheritanceCost = 2.0f * (fCombinedArea - fArea);
+
+		float arrChildCost[2];
+		const int32_t arrChildren[2] = { node.iChild1, node.iChild2 };
+		for (uint32_t c=0; c<2; c++)
+		{
+			const NODE& child = m_arrNodes[arrChildren[c]];
+			const float fChildArea = AABB::Merge(child.box, leafBox).GetSurfaceArea();
+			arrChildCost[c] = child.IsLeaf() ? fChildArea + fInheritanceCost : fChildArea - child.box.GetSurfaceArea() + fInheritanceCost;
+		}
+
+		if (fCost < arrChildCost[0] && fCost < arrChildCost[1])
+		{
+			break;
+		}
+		iIndex = (arrChildCost[0] < arrChildCost[1]) ? node.iChild1 : node.iChild2;
+	}
+
+	// new parent for the sibling and the leaf, allocation may move the nodes
+	const int32_t iSibling = iIndex;
+	const int32_t iOldParent = m_arrNodes[iSibling].iParent;
+	const int32_t iNewParent = AllocateNode();
+
+	NODE& newParent = m_arrNodes[iNewParent];
+	newParent.iParent = iOldParent;
+	newParent.box = AABB::Merge(leafBox, m_arrNodes[iSibling].box);
+	newParent.iHeight = m_arrNodes[iSibling].iHeight + 1;
+	newParent.iChild1 = iSibling;
+	newParent.iChild2 = iLeaf;
+	m_arrNodes[iSibling].iParent = iNewParent;
+	m_arrNodes[iLeaf].iParent = iNewParent;
+
+	if (iOldParent == NULL_NODE)
+	{
+		m_iRoot = iNewParent;
+	}
+	else if (m_arrNodes[iOldParent].iChild1 == iSibling)
+	{
+		m_arrNodes[iOldParent].iChild1 = iNewParent;
+	}
+	else
+	{
+		m_arrNodes[iOldParent].iChild2 = iNewParent;
+	}
+
+	Refit(iOldParent);
+}
+
+
+void AABBTree::RemoveLeaf(int32_t iLeaf)
+{
+	if (iLeaf == m_iRoot)
+	{
+		m_iRoot = NULL_NODE;
+		return;
+	}
+
+	// sibling takes the place of the parent
+	const int32_t iParent = m_arrNodes[iLeaf].iParent;
+	const int32_t iGrandParent = m_arrNodes[iParent].iParent;
+	const int32_t iSibling = (m_arrNodes[iParent].iChild1 == iLeaf) ? m_arrNodes[iParent].iChild2 : m_arrNodes[iParent].iChild1;
+
+	m_arrNodes[iSibling].iParent = iGrandParent;
+	FreeNode(iParent);
+
+	if (iGrandParent == NULL_NODE)
+	{
+		m_iRoot = iSibling;
+		return;
+	}
+
+	if (m_arrNodes[iGrandParent].iChild1 == iParent)
+	{
+		m_arrNodes[iGrandParent].iChild1 = iSibling;
+	}
+	else
+	{
+		m_arrNodes[iGrandParent].iChild2 = iSibling;
+	}
+	Refit(iGrandParent);
+}
+
+
+void AABBTree::Refit(int32_t iNode)
+{
+	while (iNode != NULL_NODE)
+	{
+		iNode = Balance(iNode);
+
+		NODE& node = m_arrNodes[iNode];
+		const NODE& child1 = m_arrNodes[node.iChild1];
+		const NODE& child2 = m_arrNodes[node.iChild2];
+		node.iHeight = 1 + std::max(child1.iHeight, child2.iHeight);
+		node.box = AABB::Merge(child1.box, child2.box);
+
+		iNode = node.iParent;
+	}
+}
+
+
+int32_t AABBTree::Balance(int32_t iA)
+{
+	NODE& a = m_arrNodes[iA];
+	if (a.IsLeaf() || a.iHeight < 2)
+	{
+		return iA;
+	}
+
+	const int32_t iB = a.iChild1;
+	const int32_t iC = a.iChild2;
+	NODE& b = m_arrNodes[iB];
+	NODE& c = m_arrNodes[iC];
+	const int32_t iBalance = c.iHeight - b.iHeight;
+
+	if (iBalance > 1)
+	{
+		// rotate c up, a becomes its first child
+		const int32_t iF = c.iChild1;
+		const int32_t iG = c.iChild2;
+		NODE& f = m_arrNodes[iF];
+		NODE& g = m_arrNodes[iG];
+
+		c.iChild1 = iA;
+		c.iParent = a.iParent;
+		a.iParent = iC;
+
+		if (c.iParent == NULL_NODE)
+		{
+			m_iRoot = iC;
+		}
+		else if (m_arrNodes[c.iParent].iChild1 == iA)
+		{
+			m_arrNodes[c.iParent].iChild1 = iC;
+		}
+		else
+		{
+			m_arrNodes[c.iParent].iChild2 = iC;
+		}
+
+		// taller grandchild stays under c, the other one moves under a
+		if (f.iHeight > g.iHeight)
+		{
+			c.iChild2 = iF;
+			a.iChild2 = iG;
+			g.iParent = iA;
+			a.box = AABB::Merge(b.box, g.box);
+			c.box = AABB::Merge(a.box, f.box);
+			a.iHeight = 1 + std::max(b.iHeight, g.iHeight);
+			c.iHeight = 1 + std::max(a.iHeight, f.iHeight);
+		}
+		else
+		{
+			c.iChild2 = iG;
+			a.iChild2 = iF;
+			f.iParent = iA;
+			a.box = AABB::Merge(b.box, f.box);
+			c.box = AABB::Merge(a.box, g.box);
+			a.iHeight = 1 + std::max(b.iHeight, f.iHeight);
+			c.iHeight = 1 + std::max(a.iHeight, g.iHeight);
+		}
+		return iC;
+	}
+
+	if (iBalance < -1)
+	{
+		// rotate b up, a becomes its first child
+		const int32_t iD = b.iChild1;
+		const int32_t iE = b.iChild2;
+		NODE& d = m_arrNodes[iD];
+		NODE& e = m_arrNodes[iE];
+
+		b.iChild1 = iA;
+		b.iParent = a.iParent;
+		a.iParent = iB;
+
+		if (b.iParent == NULL_NODE)
+		{
+			m_iRoot = iB;
+		}
+		else if (m_arrNodes[b.iParent].iChild1 == iA)
+		{
+			m_arrNodes[b.iParent].iChild1 = iB;
+		}
+		else
+		{
+			m_arrNodes[b.iParent].iChild2 = iB;
+		}
+
+		if (d.iHeight > e.iHeight)
+		{
+			b.iChild2 = iD;
+			a.iChild1 = iE;
+			e.iParent = iA;
+			a.box = AABB::Merge(c.box, e.box);
+			b.box = AABB::Merge(a.box, d.box);
+			a.iHeight = 1 + std::max(c.iHeight, e.iHeight);
+			b.iHeight = 1 + std::max(a.iHeight, d.iHeight);
+		}
+		else
+		{
+			b.iChild2 = iE;
+			a.iChild1 = iD;
+			d.iParent = iA;
+			a.box = AABB::Merge(c.box, d.box);
+			b.box = AABB::Merge(a.box, e.box);
+			a.iHeight = 1 + std::max(c.iHeight, d.iHeight);
+			b.iHeight = 1 + std::max(a.iHeight, e.iHeight);
+		}
+		return iB;
+	}
+
+	return iA;
+}
@@ -9,13 +9,24 @@
 **/
 
 #include "../include/Geometry.h"
+#include "../include/MeshOptimizer.h"
 
+uint32_t Geometry::s_uCallsSaved = 0;
 
 Geometry::Geometry()
 {
+	m_VertexBuffer = 0;
+	m_uVertexCount = 0;
 	m_IndexBuffer = 0;
 	m_uIndexCount = 0;
+	m_InstanceBuffer = 0;
 	m_eDrawMode = GL_TRIANGLES;
+	m_eIndexType = GL_UNSIGNED_INT;
+	m_iStride = 0;
+	m_bNormalizedPosition = false;
+	m_bOctahedralNormal = false;
+	m_uLod = 0;
+	SetDefaultLayout();
 }
 
 
@@ -27,21 +38,37 @@ Geometry::~Geometry()
 
 void Geometry::Clear()
 {
+	ReleaseVertexArrays();
+
 	m_arrVertices.clear();
-	if (m_IndexBuffer)
-	{
-		glDeleteBuffers(1, &m_IndexBuffer);
-		m_IndexBuffer = 0;
-	}
+	ReleaseBuffer(m_VertexBuffer);
+	m_uVertexCount = 0;
+
+	ReleaseBuffer(m_IndexBuffer);
 	m_uIndexCount = 0;
+	m_eIndexType = GL_UNSIGNED_INT;
+
+	ReleaseBuffer(m_InstanceBuffer);
+
+	m_Bounds = AABB();
+	m_BoundingSphere = SPHERE();
+
+	SetDefaultLayout();
+	m_arrLods.clear();
+	m_uLod = 0;
 }
 
 
 void Geometry::GenSphere(const glm::vec3& vRadius, const glm::vec3& vOffset, uint32_t uRings, uint32_t uSegments)
 {
 	Clear();
-	GenSphere(vRadius, vOffset, uRings, uSegments, m_arrVertices);
-	m_eDrawMode = GL_TRIANGLE_STRIP;
+	std::vector<uint32_t> arrIndices;
+	GenSphere(vRadius, vOffset, uRings, uSegments, m_arrVertices, arrIndices);
+	MeshOptimizer::OptimizeVertexCache(arrIndices.data(), arrIndices.size(), m_arrVertices.size());
+	m_eDrawMode = GL_TRIANGLES;
+	m_BoundingSphere = SPHERE(vOffset, glm::max(glm::max(vRadius.x, vRadius.y), vRadius.z));
+	CreateVertexBuffer();
+	CreateIndexBuffer(arrIndices);
 }
 
 
@@ -50,6 +77,8 @@ void Geometry::GenCube(const glm::vec3& vSize, const glm::vec3& vOffset)
 	Clear();
 	GenCube(vSize, vOffset, m_arrVertices, m_IndexBuffer, m_uIndexCount);
 	m_eDrawMode = GL_TRIANGLES;
+	m_BoundingSphere = SPHERE(vOffset, glm::length(vSize * 0.5f));
+	CreateVertexBuffer();
 }
 
 
@@ -58,107 +87,529 @@ void Geometry::GenQuad(const glm::vec2& vSize, const glm::vec3& vOffset)
 	Clear();
 	GenQuad(vSize, vOffset, m_arrVertices);
 	m_eDrawMode = GL_TRIANGLES;
+	m_BoundingSphere = SPHERE(vOffset, glm::length(vSize * 0.5f));
+	CreateVertexBuffer();
+}
+
+
+void Geometry::Create(const std::vector<VERTEX>& arrVertices, const std::vector<uint32_t>& arrIndices)
+{
+	Clear();
+	m_arrVertices = arrVertices;
+	m_eDrawMode = GL_TRIANGLES;
+	CreateVertexBuffer();
+	CreateIndexBuffer(arrIndices);
+
+	// sphere around the center of the bounds
+	const glm::vec3 vCenter = (m_Bounds.vMin + m_Bounds.vMax) * 0.5f;
+	float fRadius = 0.0f;
+	for (const VERTEX& vertex : m_arrVertices)
+	{
+		fRadius = glm::max(fRadius, glm::length(glm::vec3(vertex.x, vertex.y, vertex.z) - vCenter));
+	}
+	m_BoundingSphere = SPHERE(vCenter, fRadius);
+}
+
+
+bool Geometry::Load(const std::string& strFilename)
+{
+	Clear();
+
+	MeshFile file;
+	if (!file.Open(strFilename))
+	{
+		IApplication::Debug("Geometry::Load - failed to open " + strFilename + "\n");
+		return false;
+	}
+	const MESHHEADER& header = file.GetHeader();
+
+	for (uint32_t i=0; i<header.uAttributeCount; i++)
+	{
+		const uint32_t uType = file.GetAttributes()[i].uType;
+		if ((uType == MESHTYPE_HALF && !GetRenderer()->HasHalfFloatVertices()) ||
+			(uType == MESHTYPE_INT_2_10_10_10 && !GetRenderer()->HasPackedVertices()))
+		{
+			IApplication::Debug("Geometry::Load - vertex types not supported " + strFilename + "\n");
+			return false;
+		}
+	}
+
+	SetLayout(file.GetAttributes(), header.uAttributeCount, header.uVertexStride);
+	m_arrLods.assign(file.GetLods(), file.GetLods() + header.uLodCount);
+
+	m_eDrawMode = GL_TRIANGLES;
+	m_Bounds.vMin = glm::vec3(header.arrBoundsMin[0], header.arrBoundsMin[1], header.arrBoundsMin[2]);
+	m_Bounds.vMax = glm::vec3(header.arrBoundsMax[0], header.arrBoundsMax[1], header.arrBoundsMax[2]);
+	m_BoundingSphere = SPHERE(glm::vec3(header.arrSphere[0], header.arrSphere[1], header.arrSphere[2]), header.arrSphere[3]);
+
+	// the driver copies straight from the mapped pages, pages already in
+	// the file cache are not read from disk again
+	m_uVertexCount = header.uVertexCount;
+	glGenBuffers(1, &m_VertexBuffer);
+	GetRenderer()->BindBuffer(GL_ARRAY_BUFFER, m_VertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, file.GetVertexBytes(), file.GetVertices(), GL_STATIC_DRAW);
+	GetRenderer()->BindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (header.uIndexCount)
+	{
+		m_uIndexCount = header.uIndexCount;
+		m_eIndexType = (header.uIndexSize == 2) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		glGenBuffers(1, &m_IndexBuffer);
+		GetRenderer()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, file.GetIndexBytes(), file.GetIndices(), GL_STATIC_DRAW);
+	}
+
+	return true;
+}
+
+
+bool Geometry::Quantize(const VERTEXLAYOUT& layout)
+{
+	COpenGLRenderer* pRenderer = GetRenderer();
+	if (m_arrVertices.empty())
+	{
+		IApplication::Debug("Geometry::Quantize - no vertex data\n");
+		return false;
+	}
+	if (((layout.ePosition == POSITION_HALF || layout.eUv == UV_HALF) && !pRenderer->HasHalfFloatVertices()) ||
+		(layout.eNormal == NORMAL_PACKED && !pRenderer->HasPackedVertices()))
+	{
+		IApplication::Debug("Geometry::Quantize - vertex types not supported\n");
+		return false;
+	}
+
+	std::vector<MESHATTRIBUTE> arrAttributes;
+	VertexFormat::GetAttributes(layout, arrAttributes);
+	const uint32_t uStride = VertexFormat::GetStride(layout);
+
+	// int16 positions are relative to the bounds taken by CreateVertexBuffer
+	std::vector<unsigned char> arrData(m_arrVertices.size() * uStride);
+	VertexFormat::Encode((const float*)m_arrVertices.data(), m_arrVertices.size(), layout,
+		&m_Bounds.vMin.x, &m_Bounds.vMax.x, arrData.data());
+
+	// vertex arrays point to the old layout
+	ReleaseVertexArrays();
+	SetLayout(arrAttributes.data(), (uint32_t)arrAttributes.size(), uStride);
+
+	pRenderer->BindBuffer(GL_ARRAY_BUFFER, m_VertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, arrData.size(), arrData.data(), GL_STATIC_DRAW);
+	pRenderer->BindBuffer(GL_ARRAY_BUFFER, 0);
+	return true;
+}
+
+
+glm::mat4 Geometry::GetPositionTransform() const
+{
+	if (!m_bNormalizedPosition)
+	{
+		return glm::mat4(1.0f);
+	}
+
+	// GL before 4.2 decodes snorm as (2c+1)/65535, half a step off from
+	// c/32767 used here, which is far below the precision of the positions
+	float arrCenter[3], arrScale[3];
+	VertexFormat::GetInt16Scale(&m_Bounds.vMin.x, &m_Bounds.vMax.x, arrCenter, arrScale);
+	return glm::scale(
+		glm::translate(glm::mat4(1.0f), glm::vec3(arrCenter[0], arrCenter[1], arrCenter[2])),
+		glm::vec3(arrScale[0], arrScale[1], arrScale[2]));
+}
+
+
+void Geometry::SetLod(uint32_t uLod)
+{
+	m_uLod = glm::min(uLod, GetLodCount() - 1);
+}
+
+
+uint32_t Geometry::GetLodForDistance(float fDistance) const
+{
+	for (uint32_t i=0; i<m_arrLods.size(); i++)
+	{
+		if (fDistance <= m_arrLods[i].fMaxDistance)
+		{
+			return i;
+		}
+	}
+	return GetLodCount() - 1;
+}
+
+
+void Geometry::ReleaseVertexData()
+{
+	// swap with an empty array to actually free the memory
+	std::vector<VERTEX>().swap(m_arrVertices);
+}
+
+
+void Geometry::SetDefaultLayout()
+{
+	m_arrAttributes.resize(3);
+	m_arrAttributes[0].strName = "position";
+	m_arrAttributes[0].iComponents = 3;
+	m_arrAttributes[0].uOffset = 0;
+	m_arrAttributes[1].strName = "normal";
+	m_arrAttributes[1].iComponents = 3;
+	m_arrAttributes[1].uOffset = sizeof(float) * 3;
+	m_arrAttributes[2].strName = "uv";
+	m_arrAttributes[2].iComponents = 2;
+	m_arrAttributes[2].uOffset = sizeof(float) * 6;
+	for (ATTRIBUTE& attribute : m_arrAttributes)
+	{
+		attribute.eType = GL_FLOAT;
+		attribute.bNormalized = GL_FALSE;
+	}
+	m_iStride = VERTEX::GetStride();
+	m_bNormalizedPosition = false;
+	m_bOctahedralNormal = false;
+}
+
+
+void Geometry::SetLayout(const MESHATTRIBUTE* pAttributes, uint32_t uAttributeCount, uint32_t uStride)
+{
+	// GL types of MESHTYPE
+	static const GLenum arrTypes[] = { GL_FLOAT, GL_HALF_FLOAT, GL_SHORT, GL_INT_2_10_10_10_REV };
+
+	m_arrAttributes.clear();
+	m_bNormalizedPosition = false;
+	m_bOctahedralNormal = false;
+	for (uint32_t i=0; i<uAttributeCount; i++)
+	{
+		const MESHATTRIBUTE& source = pAttributes[i];
+		ATTRIBUTE attribute;
+		attribute.strName = source.szName;
+		attribute.iComponents = (GLint)source.uComponents;
+		attribute.eType = arrTypes[source.uType];
+		attribute.bNormalized = source.uNormalized ? GL_TRUE : GL_FALSE;
+		attribute.uOffset = source.uOffset;
+		m_arrAttributes.push_back(attribute);
+
+		if (attribute.strName == "position" && source.uType == MESHTYPE_INT16)
+		{
+			m_bNormalizedPosition = true;
+		}
+		if (attribute.strName == "normal" && attribute.iComponents == 2)
+		{
+			m_bOctahedralNormal = true;
+		}
+	}
+	m_iStride = (GLsizei)uStride;
+}
+
+
+void Geometry::CreateVertexBuffer()
+{
+	m_uVertexCount = m_arrVertices.size();
+
+	// bounds are taken while the cpu copy of the vertices still exists
+	if (!m_arrVertices.empty())
+	{
+		m_Bounds.vMin = m_Bounds.vMax = glm::vec3(m_arrVertices[0].x, m_arrVertices[0].y, m_arrVertices[0].z);
+		for (size_t i=1; i<m_arrVertices.size(); i++)
+		{
+			const glm::vec3 vPos(m_arrVertices[i].x, m_arrVertices[i].y, m_arrVertices[i].z);
+			m_Bounds.vMin = glm::min(m_Bounds.vMin, vPos);
+			m_Bounds.vMax = glm::max(m_Bounds.vMax, vPos);
+		}
+	}
+
+	// upload the vertices once, draws read them from video memory
+	glGenBuffers(1, &m_VertexBuffer);
+	GetRenderer()->BindBuffer(GL_ARRAY_BUFFER, m_VertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, m_uVertexCount * VERTEX::GetStride(), m_arrVertices.data(), GL_STATIC_DRAW);
+	GetRenderer()->BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+
+void Geometry::CreateIndexBuffer(const std::vector<uint32_t>& arrIndices)
+{
+	m_uIndexCount = arrIndices.size();
+	glGenBuffers(1, &m_IndexBuffer);
+	GetRenderer()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer);
+
+	// half the index memory and bandwidth when the vertex count allows
+	if (m_uVertexCount <= 0xffff)
+	{
+		std::vector<uint16_t> arrShortIndices(arrIndices.begin(), arrIndices.end());
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, arrShortIndices.size() * sizeof(uint16_t), arrShortIndices.data(), GL_STATIC_DRAW);
+		m_eIndexType = GL_UNSIGNED_SHORT;
+	}
+	else
+	{
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, arrIndices.size() * sizeof(uint32_t), arrIndices.data(), GL_STATIC_DRAW);
+		m_eIndexType = GL_UNSIGNED_INT;
+	}
+}
+
+
+void Geometry::GetIndexRange(size_t& uFirst, size_t& uCount) const
+{
+	if (m_arrLods.empty())
+	{
+		uFirst = 0;
+		uCount = m_uIndexCount;
+	}
+	else
+	{
+		uFirst = m_arrLods[m_uLod].uFirstIndex;
+		uCount = m_arrLods[m_uLod].uIndexCount;
+	}
 }
 
 
 void Geometry::SetAttribs(GLuint uProgram) const
 {
-	// get the vertex attribute locations
-	GLint position = glGetAttribLocation(uProgram, "position");
-	GLint normal = glGetAttribLocation(uProgram, "normal");
-	GLint uv = glGetAttribLocation(uProgram, "uv");
-
-	// set the vertex position
-	glEnableVertexAttribArray(position);
-	glVertexAttribPointer(
-		position,
-		3,
-		GL_FLOAT,
-		GL_FALSE,
-		VERTEX::GetStride(),
-		GetData());
-
-	// vertex normal
-	glEnableVertexAttribArray(normal);
-	glVertexAttribPointer(
-		normal,
-		3,
-		GL_FLOAT,
-		GL_FALSE,
-		VERTEX::GetStride(),
-		(char*)((float*)GetData() + 3));
-
-	// vertex uv
-	glEnableVertexAttribArray(uv);
-	glVertexAttribPointer(
-		uv,
-		2,
-		GL_FLOAT,
-		GL_FALSE,
-		VERTEX::GetStride(),
-		(char*)((float*)GetData() + 6));
+	const VERTEXARRAY& vertexArray = GetVertexArray(uProgram);
+	GetRenderer()->BindVertexArray(vertexArray.uVertexArray);
+
+	// without the cache every call would query the attribute locations,
+	// bind the buffers and set up each attribute again
+	s_uCallsSaved += vertexArray.uSetupCalls - 1;
 }
 
 
 void Geometry::DisableAttribs(GLuint uProgram) const
 {
-	// get the vertex attribute locations
-	GLint position = glGetAttribLocation(uProgram, "position");
-	GLint normal = glGetAttribLocation(uProgram, "normal");
-	GLint uv = glGetAttribLocation(uProgram, "uv");
-
-	glDisableVertexAttribArray(position);
-	glDisableVertexAttribArray(normal);
-	glDisableVertexAttribArray(uv);
+	const VERTEXARRAY& vertexArray = GetVertexArray(uProgram);
+	if (GetRenderer()->GetVertexArray())
+	{
+		GetRenderer()->BindVertexArray(0);
+		s_uCallsSaved += vertexArray.uDisableCalls - 1;
+	}
+	else
+	{
+		s_uCallsSaved += vertexArray.uDisableCalls;
+	}
 }
 
 
 void Geometry::Draw(IRenderer* pRenderer) const
 {
+	COpenGLRenderer* pOpenGLRenderer = static_cast<COpenGLRenderer*>(pRenderer);
 	if (m_IndexBuffer && m_uIndexCount)
 	{
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer);
-		glDrawElements(m_eDrawMode, (GLsizei)m_uIndexCount, GL_UNSIGNED_INT, 0);
+		size_t uFirst = 0;
+		size_t uCount = 0;
+		GetIndexRange(uFirst, uCount);
+
+		// index buffer binding is part of the vertex array state
+		if (pOpenGLRenderer->GetVertexArray())
+		{
+			++s_uCallsSaved;
+		}
+		else
+		{
+			pOpenGLRenderer->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer);
+		}
+		const size_t uIndexSize = (m_eIndexType == GL_UNSIGNED_SHORT) ? 2 : 4;
+		glDrawElements(m_eDrawMode, (GLsizei)uCount, m_eIndexType, (void*)(uFirst * uIndexSize));
 	}
 	else
 	{
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		if (pOpenGLRenderer->GetVertexArray())
+		{
+			++s_uCallsSaved;
+		}
+		else
+		{
+			pOpenGLRenderer->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		}
 		glDrawArrays(m_eDrawMode, 0, (GLsizei)GetVertexCount());
 	}
 }
 
 
-void Geometry::GenSphere(const glm::vec3& vRadius, const glm::vec3& vOffset, uint32_t uRings, uint32_t uSegments, std::vector<VERTEX>& arrVertices)
+void Geometry::DrawInstanced(IRenderer* pRenderer, const glm::mat4* pModels, size_t count) const
+{
+	if (!m_InstanceBuffer || !count)
+	{
+		return;
+	}
+
+	// stream the matrices. Specifying new storage orphans the old contents
+	// so the driver does not have to wait for previous draws to finish
+	COpenGLRenderer* pOpenGLRenderer = static_cast<COpenGLRenderer*>(pRenderer);
+	pOpenGLRenderer->BindBuffer(GL_ARRAY_BUFFER, m_InstanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, count * sizeof(glm::mat4), pModels, GL_STREAM_DRAW);
+	pOpenGLRenderer->BindBuffer(GL_ARRAY_BUFFER, 0);
+
+	if (m_IndexBuffer && m_uIndexCount)
+	{
+		size_t uFirst = 0;
+		size_t uCount = 0;
+		GetIndexRange(uFirst, uCount);
+		const size_t uIndexSize = (m_eIndexType == GL_UNSIGNED_SHORT) ? 2 : 4;
+		glDrawElementsInstanced(m_eDrawMode, (GLsizei)uCount, m_eIndexType, (void*)(uFirst * uIndexSize), (GLsizei)count);
+	}
+	else
+	{
+		glDrawArraysInstanced(m_eDrawMode, 0, (GLsizei)GetVertexCount(), (GLsizei)count);
+	}
+}
+
+
+COpenGLRenderer* Geometry::GetRenderer()
+{
+	IApplication* pApp = IApplication::GetApp();
+	return pApp ? static_cast<COpenGLRenderer*>(pApp->GetRenderer()) : nullptr;
+}
+
+
+void Geometry::ReleaseBuffer(GLuint& uBuffer)
+{
+	// buffers are released with the context if renderer is already gone
+	COpenGLRenderer* pRenderer = GetRenderer();
+	if (uBuffer && pRenderer)
+	{
+		pRenderer->DeleteBuffer(uBuffer);
+	}
+	uBuffer = 0;
+}
+
+
+const Geometry::VERTEXARRAY& Geometry::GetVertexArray(GLuint uProgram) const
+{
+	auto it = m_mapVertexArrays.find(uProgram);
+	if (it != m_mapVertexArrays.end())
+	{
+		return it->second;
+	}
+
+	COpenGLRenderer* pRenderer = GetRenderer();
+
+	VERTEXARRAY& vertexArray = m_mapVertexArrays[uProgram];
+	glGenVertexArrays(1, &vertexArray.uVertexArray);
+	pRenderer->BindVertexArray(vertexArray.uVertexArray);
+
+	// attribute pointers are offsets into the vertex buffer
+	pRenderer->BindBuffer(GL_ARRAY_BUFFER, m_VertexBuffer);
+
+	// program may not use all of the attributes in the vertex
+	uint32_t attribCount = 0;
+	for (const ATTRIBUTE& attribute : m_arrAttributes)
+	{
+		GLint location = glGetAttribLocation(uProgram, attribute.strName.c_str());
+		if (location != -1)
+		{
+			glEnableVertexAttribArray(location);
+			glVertexAttribPointer(
+				location,
+				attribute.iComponents,
+				attribute.eType,
+				attribute.bNormalized,
+				m_iStride,
+				(void*)(size_t)attribute.uOffset);
+			++attribCount;
+		}
+	}
+
+	// instance matrix is a mat4 attribute, one vec4 column per location,
+	// advanced once per instance instead of once per vertex
+	GLint instanceMatrix = glGetAttribLocation(uProgram, "instanceMatrix");
+	if (instanceMatrix != -1)
+	{
+		if (!m_InstanceBuffer)
+		{
+			glGenBuffers(1, &m_InstanceBuffer);
+		}
+		pRenderer->BindBuffer(GL_ARRAY_BUFFER, m_InstanceBuffer);
+
+		for (GLint i=0; i<4; i++)
+		{
+			glEnableVertexAttribArray(instanceMatrix + i);
+			glVertexAttribPointer(
+				instanceMatrix + i,
+				4,
+				GL_FLOAT,
+				GL_FALSE,
+				sizeof(glm::mat4),
+				(void*)(sizeof(glm::vec4) * i));
+			glVertexAttribDivisor(instanceMatrix + i, 1);
+		}
+	}
+
+	// index buffer is stored into the vertex array
+	pRenderer->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer);
+
+	// leave the client side arrays usable for code that does not use buffers
+	pRenderer->BindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// number of driver calls the uncached path makes per draw
+	vertexArray.uSetupCalls = (uint32_t)m_arrAttributes.size() + 2 + attribCount * 2 + 1;
+	vertexArray.uDisableCalls = 3 + attribCount;
+
+	return vertexArray;
+}
+
+
+void Geometry::ReleaseVertexArrays()
+{
+	// vertex arrays are released with the context if renderer is already gone
+	COpenGLRenderer* pRenderer = GetRenderer();
+	if (pRenderer)
+	{
+		// make sure no vertex array captures buffer bindings of a new geometry
+		pRenderer->BindVertexArray(0);
+
+		for (auto& it : m_mapVertexArrays)
+		{
+			pRenderer->DeleteVertexArray(it.second.uVertexArray);
+		}
+	}
+	m_mapVertexArrays.clear();
+}
+
+
+void Geometry::GenSphere(const glm::vec3& vRadius, const glm::vec3& vOffset, uint32_t uRings, uint32_t uSegments, std::vector<VERTEX>& arrVertices, std::vector<uint32_t>& arrIndices)
 {
 	const float deltaRingAngle = (glm::pi<float>() / uRings);
 	const float deltaSegAngle = (glm::two_pi<float>() / uSegments);
 
-	for (uint32_t ring = 0; ring < uRings; ring++)
+	// one vertex per ring and segment, the seam is duplicated for the uvs
+	const uint32_t uColumns = uSegments + 1;
+	arrVertices.reserve(arrVertices.size() + (uRings + 1) * uColumns);
+	arrIndices.reserve(arrIndices.size() + uRings * uSegments * 6);
+	const uint32_t uFirst = (uint32_t)arrVertices.size();
+
+	for (uint32_t ring = 0; ring <= uRings; ring++)
 	{
-		const float r0 = sinf((ring + 0) * deltaRingAngle);
-		const float r1 = sinf((ring + 1) * deltaRingAngle);
-		const float y0 = cosf((ring + 0) * deltaRingAngle);
-		const float y1 = cosf((ring + 1) * deltaRingAngle);
+		const float r = sinf(ring * deltaRingAngle);
+		const float y = cosf(ring * deltaRingAngle);
 
-		for (uint32_t seg = 0; seg < (uSegments + 1); seg++)
+		for (uint32_t seg = 0; seg <= uSegments; seg++)
 		{
 			const float angle = seg * deltaSegAngle;
-			const float x0 = r0 * sinf(angle);
-			const float z0 = r0 * cosf(angle);
-			const float x1 = r1 * sinf(angle);
-			const float z1 = r1 * cosf(angle);
+			const float x = r * sinf(angle);
+			const float z = r * cosf(angle);
 
 			arrVertices.push_back(VERTEX(
-				vRadius.x * x1 + vOffset.x, vRadius.y * y1 + vOffset.y, vRadius.z * z1 + vOffset.z,
-				x1, y1, z1,
+				vRadius.x * x + vOffset.x, vRadius.y * y + vOffset.y, vRadius.z * z + vOffset.z,
+				x, y, z,
 				((float)seg) / uSegments,
-				(ring + 1) / (float)uRings));
+				ring / (float)uRings));
+		}
+	}
 
-			arrVertices.push_back(VERTEX(
-				vRadius.x * x0 + vOffset.x, vRadius.y * y0 + vOffset.y, vRadius.z * z0 + vOffset.z,
-				x0, y0, z0,
-				((float)seg) / uSegments,
-				(ring / (float)uRings)));
+	// two clockwise triangles per quad, the triangles that would collapse
+	// into the poles are left out
+	for (uint32_t ring = 0; ring < uRings; ring++)
+	{
+		for (uint32_t seg = 0; seg < uSegments; seg++)
+		{
+			const uint32_t i0 = uFirst + ring * uColumns + seg;
+			const uint32_t i1 = i0 + uColumns;
+
+			if (ring != uRings - 1)
+			{
+				arrIndices.push_back(i1);
+				arrIndices.push_back(i0);
+				arrIndices.push_back(i1 + 1);
+			}
+			if (ring != 0)
+			{
+				arrIndices.push_back(i0);
+				arrIndices.push_back(i0 + 1);
+				arrIndices.push_back(i1 + 1);
+			}
 		}
 	}
 }
@@ -239,7 +690,7 @@ void Geometry::GenCube(const glm::vec3& vSize, const glm::vec3& vOffset, std::ve
 	}
 
 	glGenBuffers(1, &uIndexbuffer);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, uIndexbuffer);
+	GetRenderer()->BindBuffer(GL_ELEMENT_ARRAY_BUFFER, uIndexbuffer);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
 	uIndexCount = 36;
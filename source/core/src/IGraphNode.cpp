@@ -9,23 +9,50 @@
 **/
 
 #include "../include/IGraphNode.h"
+#include "../include/Geometry.h"
+#include "../include/JobSystem.h"
+#include "../include/AABBTree.h"
+
+FRUSTUM IGraphNode::s_CullFrustum;
+bool IGraphNode::s_bCulling = false;
+uint32_t IGraphNode::s_uCullFrame = 0;
+IGraphNode::CULLSTATS IGraphNode::s_CullStats = {};
 
 IGraphNode::IGraphNode()
 {
 	m_mModel = glm::mat4(1.0f);
 	m_pParent = nullptr;
 
+	m_mWorld = glm::mat4(1.0f);
+	m_bWorldDirty = true;
+
 	m_vRotationAxis = glm::vec3(0.0f, 0.0f, -1.0f);
 	m_fRotationAngle = 0.0f;
 	m_fRotationSpeed = 0.0f;
 	m_vVelocity = glm::vec3(0.0f, 0.0f, 0.0f);
 
 	m_fRadius = 1.0f;
+
+	m_pTransforms = nullptr;
+	m_hTransform = TransformPool::INVALID_HANDLE;
+
+	m_pJobs = nullptr;
+
+	m_pBoundsTree = nullptr;
+	m_iProxy = AABBTree::NULL_NODE;
+
+	m_bHasSphere = false;
+	m_bHasSubtreeSphere = false;
+	m_uSubtreeCount = 1;
+	m_eCullResult = CULL_INTERSECT;
+	m_uCullFrame = 0;
 }
 
 
 IGraphNode::~IGraphNode()
 {
+	UnregisterBounds();
+
 	// as ownership has transferred to parent node, delete all child nodes
 	for (size_t i=0; i<m_arrChildren.size(); i++)
 	{
@@ -40,6 +67,7 @@ void IGraphNode::AddChild(IGraphNode* pChild)
 {
 	// link new child parent
 	pChild->m_pParent = this;
+	pChild->SetDirty();
 
 	// add to child array
 	m_arrChildren.push_back(pChild);
@@ -48,13 +76,22 @@ void IGraphNode::AddChild(IGraphNode* pChild)
 
 void IGraphNode::Update(float fFrametime)
 {
+	// pooled transforms are integrated by the pool in one sweep
+	if (m_pTransforms)
+	{
+		UpdateChildren(fFrametime);
+		return;
+	}
+
 	// update position per velocity
-	glm::vec3 pos = GetPos();
-	pos += m_vVelocity * fFrametime;
+	const glm::vec3 oldPos = GetPos();
+	const glm::vec3 pos = oldPos + m_vVelocity * fFrametime;
+	bool bChanged = (pos != oldPos);
 
 	// update rotations
 	if (fabsf(m_fRotationSpeed) > 0.00001f)
 	{
+		bChanged = true;
 		m_mModel = glm::rotate(glm::mat4(1.0f), m_fRotationAngle, glm::normalize(m_vRotationAxis));
 
 		m_fRotationAngle += m_fRotationSpeed * fFrametime;
@@ -68,15 +105,362 @@ void IGraphNode::Update(float fFrametime)
 		}
 	}
 
-	// set updated position back to the model matrix
-	m_mModel[3][0] = pos.x;
-	m_mModel[3][1] = pos.y;
-	m_mModel[3][2] = pos.z;
+	// set updated position back to the model matrix, static nodes keep their cached world matrix
+	if (bChanged)
+	{
+		m_mModel[3][0] = pos.x;
+		m_mModel[3][1] = pos.y;
+		m_mModel[3][2] = pos.z;
+		SetDirty();
+	}
 
 	// update all children
+	UpdateChildren(fFrametime);
+}
+
+
+void IGraphNode::UpdateChildren(float fFrametime)
+{
+	if (m_pJobs)
+	{
+		// child subtrees are independent, one job per range of children
+		m_pJobs->ParallelFor((uint32_t)m_arrChildren.size(), GetChildGrainSize(), [this, fFrametime](uint32_t uBegin, uint32_t uEnd)
+		{
+			for (uint32_t i=uBegin; i<uEnd; i++)
+			{
+				m_arrChildren[i]->Update(fFrametime);
+			}
+		});
+		return;
+	}
+
 	for (size_t i=0; i<m_arrChildren.size(); i++)
 	{
 		m_arrChildren[i]->Update(fFrametime);
 	}
 }
 
+
+uint32_t IGraphNode::GetChildGrainSize() const
+{
+	// a few jobs per thread lets the idle threads steal from the busy ones
+	const uint32_t uJobs = (m_pJobs->GetWorkerCount() + 1) * 4;
+	const uint32_t uGrainSize = (uint32_t)m_arrChildren.size() / uJobs;
+	return (uGrainSize > 0) ? uGrainSize : 1;
+}
+
+
+const glm::mat4& IGraphNode::GetWorldMatrix()
+{
+	if (m_pTransforms)
+	{
+		m_bWorldDirty = false;
+		return m_pTransforms->GetWorldMatrix(m_hTransform);
+	}
+
+	if (m_bWorldDirty)
+	{
+		// parents are resolved first, each of them only once per change
+		m_mWorld = (m_pParent) ? m_pParent->GetWorldMatrix() * m_mModel : m_mModel;
+		m_bWorldDirty = false;
+	}
+	return m_mWorld;
+}
+
+
+void IGraphNode::UpdateWorldMatrices()
+{
+	GetWorldMatrix();
+
+	if (m_pJobs)
+	{
+		// this node is resolved, children only read it
+		m_pJobs->ParallelFor((uint32_t)m_arrChildren.size(), GetChildGrainSize(), [this](uint32_t uBegin, uint32_t uEnd)
+		{
+			for (uint32_t i=uBegin; i<uEnd; i++)
+			{
+				m_arrChildren[i]->UpdateWorldMatrices();
+			}
+		});
+	}
+	else
+	{
+		for (size_t i=0; i<m_arrChildren.size(); i++)
+		{
+			m_arrChildren[i]->UpdateWorldMatrices();
+		}
+	}
+
+	UpdateSpheres();
+}
+
+
+void IGraphNode::UpdateSpheres()
+{
+	SPHERE localSphere;
+	m_bHasSphere = GetLocalSphere(localSphere);
+	if (m_bHasSphere)
+	{
+		m_WorldSphere = localSphere.Transform(GetWorldMatrix());
+	}
+
+	// grow the sphere of this node around the subtree spheres of the children
+	m_SubtreeSphere = m_WorldSphere;
+	m_bHasSubtreeSphere = m_bHasSphere;
+	m_uSubtreeCount = 1;
+	for (size_t i=0; i<m_arrChildren.size(); i++)
+	{
+		const IGraphNode* pChild = m_arrChildren[i];
+		m_uSubtreeCount += pChild->m_uSubtreeCount;
+		if (pChild->m_bHasSubtreeSphere)
+		{
+			m_SubtreeSphere = m_bHasSubtreeSphere ? SPHERE::Merge(m_SubtreeSphere, pChild->m_SubtreeSphere) : pChild->m_SubtreeSphere;
+			m_bHasSubtreeSphere = true;
+		}
+	}
+}
+
+
+void IGraphNode::BeginCulling(const glm::mat4& mViewProjection)
+{
+	s_CullFrustum.Extract(mViewProjection);
+	s_bCulling = true;
+	s_uCullFrame++;
+	s_CullStats = CULLSTATS();
+}
+
+
+void IGraphNode::EndCulling()
+{
+	s_bCulling = false;
+}
+
+
+bool IGraphNode::IsSubtreeVisible()
+{
+	s_CullStats.uVisited++;
+	m_uCullFrame = s_uCullFrame;
+	m_eCullResult = CULL_INTERSECT;
+	if (!s_bCulling || !m_bHasSubtreeSphere)
+	{
+		return true;
+	}
+
+	// everything below a node that is completely inside is inside as well
+	if (m_pParent && m_pParent->m_uCullFrame == s_uCullFrame && m_pParent->m_eCullResult == CULL_INSIDE)
+	{
+		m_eCullResult = CULL_INSIDE;
+		return true;
+	}
+
+	m_eCullResult = s_CullFrustum.Classify(m_SubtreeSphere);
+	if (m_eCullResult == CULL_OUTSIDE)
+	{
+		s_CullStats.uCulled += m_uSubtreeCount;
+		return false;
+	}
+	return true;
+}
+
+
+bool IGraphNode::IsVisible()
+{
+	// without children the subtree sphere is the sphere of the node
+	bool bVisible = true;
+	if (s_bCulling && m_bHasSphere && m_eCullResult != CULL_INSIDE && !m_arrChildren.empty())
+	{
+		bVisible = s_CullFrustum.Intersects(m_WorldSphere);
+	}
+
+	if (bVisible)
+	{
+		s_CullStats.uDrawn++;
+	}
+	else
+	{
+		s_CullStats.uCulled++;
+	}
+	return bVisible;
+}
+
+
+void IGraphNode::SetDirty()
+{
+	// children of a dirty node are always dirty as well
+	if (m_bWorldDirty)
+	{
+		return;
+	}
+
+	m_bWorldDirty = true;
+	for (size_t i=0; i<m_arrChildren.size(); i++)
+	{
+		m_arrChildren[i]->SetDirty();
+	}
+}
+
+
+void IGraphNode::AttachTransform(TransformPool& pool)
+{
+	if (!m_pTransforms)
+	{
+		TransformHandle hParent = TransformPool::INVALID_HANDLE;
+		if (m_pParent && m_pParent->m_pTransforms == &pool)
+		{
+			hParent = m_pParent->m_hTransform;
+		}
+
+		// copy the current transform into the pool
+		const TransformHandle h = pool.Allocate(hParent);
+		pool.SetLocalMatrix(h, m_mModel);
+		pool.GetVelocity(h) = m_vVelocity;
+		pool.GetRotationAxis(h) = m_vRotationAxis;
+		pool.GetRotationAngle(h) = m_fRotationAngle;
+		pool.GetRotationSpeed(h) = m_fRotationSpeed;
+		pool.GetRadius(h) = m_fRadius;
+
+		m_pTransforms = &pool;
+		m_hTransform = h;
+		m_bWorldDirty = true;
+	}
+
+	// children after the parent keeps the pool sorted parent-before-child
+	for (size_t i=0; i<m_arrChildren.size(); i++)
+	{
+		m_arrChildren[i]->AttachTransform(pool);
+	}
+}
+
+
+bool IGraphNode::GetLocalBounds(AABB& box) const
+{
+	const Geometry* pGeometry = GetGeometry();
+	if (pGeometry)
+	{
+		box = pGeometry->GetBounds();
+		return true;
+	}
+	return false;
+}
+
+
+bool IGraphNode::GetLocalSphere(SPHERE& sphere) const
+{
+	const Geometry* pGeometry = GetGeometry();
+	if (pGeometry)
+	{
+		sphere = pGeometry->GetBoundingSphere();
+		return true;
+	}
+	return false;
+}
+
+
+void IGraphNode::Render(IRenderer* pRenderer, GLuint uProgram)
+{
+	// nothing to draw when the node and its children are out of view
+	if (!IsSubtreeVisible())
+	{
+		return;
+	}
+
+	if (GetGeometry() && IsVisible())
+	{
+		Draw(pRenderer, uProgram);
+	}
+
+	for (size_t i=0; i<m_arrChildren.size(); i++)
+	{
+		m_arrChildren[i]->Render(pRenderer, uProgram);
+	}
+}
+
+
+void IGraphNode::Draw(IRenderer* /*pRenderer*/, GLuint /*uProgram*/)
+{
+}
+
+
+const Geometry* IGraphNode::GetGeometry() const
+{
+	return nullptr;
+}
+
+
+bool IGraphNode::GetWorldBounds(AABB& box)
+{
+	AABB localBox;
+	if (!GetLocalBounds(localBox))
+	{
+		return false;
+	}
+
+	box = localBox.Transform(GetWorldMatrix());
+	return true;
+}
+
+
+void IGraphNode::RegisterBounds(AABBTree& tree)
+{
+	AABB box;
+	if (!m_pBoundsTree && GetWorldBounds(box))
+	{
+		m_pBoundsTree = &tree;
+		m_iProxy = tree.CreateProxy(box, this);
+	}
+
+	for (size_t i=0; i<m_arrChildren.size(); i++)
+	{
+		m_arrChildren[i]->RegisterBounds(tree);
+	}
+}
+
+
+void IGraphNode::UnregisterBounds()
+{
+	if (m_pBoundsTree)
+	{
+		m_pBoundsTree->DestroyProxy(m_iProxy);
+		m_pBoundsTree = nullptr;
+		m_iProxy = AABBTree::NULL_NODE;
+	}
+
+	for (size_t i=0; i<m_arrChildren.size(); i++)
+	{
+		m_arrChildren[i]->UnregisterBounds();
+	}
+}
+
+
+void IGraphNode::UpdateBounds()
+{
+	AABB box;
+	if (m_pBoundsTree && GetWorldBounds(box))
+	{
+		m_pBoundsTree->MoveProxy(m_iProxy, box);
+	}
+
+	for (size_t i=0; i<m_arrChildren.size(); i++)
+	{
+		m_arrChildren[i]->UpdateBounds();
+	}
+}
+
+
+void IGraphNode::GatherInstances(InstanceBatch& batch)
+{
+	for (size_t i=0; i<m_arrChildren.size(); i++)
+	{
+		m_arrChildren[i]->GatherInstances(batch);
+	}
+}
+
+
+void IGraphNode::Enqueue(RenderQueue& queue, GLuint uProgram)
+{
+	for (size_t i=0; i<m_arrChildren.size(); i++)
+	{
+		m_arrChildren[i]->Enqueue(queue, uProgram);
+	}
+}
+
@@ -0,0 +1,80 @@
+/**
+ * ============================================================================
+ *  Name        : InstanceBatch.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : collects model matrices of objects sharing geometry and
+ *                material into instanced draw calls
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#include "../include/InstanceBatch.h"
+
+
+InstanceBatch::InstanceBatch()
+{
+	m_uDrawCalls = 0;
+	m_uInstances = 0;
+}
+
+
+InstanceBatch::~InstanceBatch()
+{
+}
+
+
+void InstanceBatch::Add(const Geometry* pGeometry, Material* pMaterial, const glm::mat4& mWorld)
+{
+	for (size_t i=0; i<m_arrBatches.size(); i++)
+	{
+		BATCH& batch = m_arrBatches[i];
+		if (batch.pGeometry == pGeometry && batch.pMaterial == pMaterial)
+		{
+			batch.arrModels.push_back(mWorld);
+			return;
+		}
+	}
+
+	m_arrBatches.push_back(BATCH());
+	m_arrBatches.back().pGeometry = pGeometry;
+	m_arrBatches.back().pMaterial = pMaterial;
+	m_arrBatches.back().arrModels.push_back(mWorld);
+}
+
+
+void InstanceBatch::Draw(COpenGLRenderer* pRenderer, GLuint uProgram)
+{
+	m_uDrawCalls = 0;
+	m_uInstances = 0;
+
+	for (size_t i=0; i<m_arrBatches.size(); i++)
+	{
+		const BATCH& batch = m_arrBatches[i];
+		if (batch.arrModels.empty())
+		{
+			continue;
+		}
+
+		if (batch.pMaterial)
+		{
+			batch.pMaterial->SetToProgram(pRenderer, uProgram);
+		}
+
+		batch.pGeometry->SetAttribs(uProgram);
+		batch.pGeometry->DrawInstanced(pRenderer, batch.arrModels.data(), batch.arrModels.size());
+
+		++m_uDrawCalls;
+		m_uInstances += (uint32_t)batch.arrModels.size();
+	}
+}
+
+
+void InstanceBatch::Clear()
+{
+	for (size_t i=0; i<m_arrBatches.size(); i++)
+	{
+		m_arrBatches[i].arrModels.clear();
+	}
+}
+
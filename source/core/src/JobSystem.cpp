@@ -0,0 +1,225 @@
+/**
+ * ============================================================================
+ *  Name        : JobSystem.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : fixed pool of worker threads with work stealing job queues
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#include "../include/JobSystem.h"
+
+// queue of the current thread, workers set their own at startup
+static thread_local const JobSystem* s_pOwner = nullptr;
+static thread_local uint32_t s_uQueueIndex = 0;
+
+
+JobSystem::JobSystem()
+{
+	m_uQueuedJobs = 0;
+	m_bQuit = false;
+}
+
+
+JobSystem::~JobSystem()
+{
+	Destroy();
+}
+
+
+bool JobSystem::Create(uint32_t uWorkerCount)
+{
+	Destroy();
+
+	if (uWorkerCount == 0)
+	{
+		const uint32_t uHardwareThreads = std::thread::hardware_concurrency();
+		uWorkerCount = (uHardwareThreads > 1) ? uHardwareThreads - 1 : 0;
+	}
+
+	m_bQuit = false;
+	m_arrQueues.resize(uWorkerCount + 1);
+	for (size_t i=0; i<m_arrQueues.size(); i++)
+	{
+		m_arrQueues[i].reset(new JOBQUEUE);
+	}
+
+	for (uint32_t i=0; i<uWorkerCount; i++)
+	{
+		m_arrThreads.push_back(std::thread(&JobSystem::WorkerThread, this, i + 1));
+	}
+	return true;
+}
+
+
+void JobSystem::Destroy()
+{
+	if (m_arrQueues.empty())
+	{
+		return;
+	}
+
+	// finish what is queued, then release the workers
+	while (RunOneJob(GetQueueIndex()))
+	{
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_WakeMutex);
+		m_bQuit = true;
+	}
+	m_WakeCondition.notify_all();
+
+	for (size_t i=0; i<m_arrThreads.size(); i++)
+	{
+		m_arrThreads[i].join();
+	}
+	m_arrThreads.clear();
+	m_arrQueues.clear();
+}
+
+
+void JobSystem::Run(std::function<void()> fnJob, std::atomic<uint32_t>* pCounter)
+{
+	if (pCounter)
+	{
+		pCounter->fetch_add(1);
+	}
+
+	// without workers, run right away
+	if (m_arrThreads.empty())
+	{
+		fnJob();
+		if (pCounter)
+		{
+			pCounter->fetch_sub(1);
+		}
+		return;
+	}
+
+	// count the job before it becomes visible, so the count never goes below
+	// zero. Wake mutex is held so that a worker going to sleep cannot miss it.
+	{
+		std::lock_guard<std::mutex> lock(m_WakeMutex);
+		m_uQueuedJobs.fetch_add(1);
+	}
+
+	JOBQUEUE& queue = *m_arrQueues[GetQueueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.arrJobs.push_back(JOB());
+		queue.arrJobs.back().fnJob = std::move(fnJob);
+		queue.arrJobs.back().pCounter = pCounter;
+	}
+	m_WakeCondition.notify_one();
+}
+
+
+void JobSystem::Wait(std::atomic<uint32_t>* pCounter)
+{
+	const uint32_t uQueue = GetQueueIndex();
+	while (pCounter->load() > 0)
+	{
+		// help with the work instead of blocking
+		if (!RunOneJob(uQueue))
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+
+void JobSystem::ParallelFor(uint32_t uCount, uint32_t uGrainSize, const std::function<void(uint32_t uBegin, uint32_t uEnd)>& fnRange)
+{
+	if (uGrainSize == 0)
+	{
+		uGrainSize = 1;
+	}
+
+	if (m_arrThreads.empty() || uCount <= uGrainSize)
+	{
+		if (uCount > 0)
+		{
+			fnRange(0, uCount);
+		}
+		return;
+	}
+
+	std::atomic<uint32_t> counter(0);
+	for (uint32_t uBegin=0; uBegin<uCount; uBegin+=uGrainSize)
+	{
+		const uint32_t uEnd = (uCount - uBegin > uGrainSize) ? uBegin + uGrainSize : uCount;
+		Run([&fnRange, uBegin, uEnd]() { fnRange(uBegin, uEnd); }, &counter);
+	}
+	Wait(&counter);
+}
+
+
+bool JobSystem::RunOneJob(uint32_t uQueue)
+{
+	JOB job;
+	bool bFound = false;
+
+	// newest job from own queue keeps the data hot in cache
+	{
+		JOBQUEUE& queue = *m_arrQueues[uQueue];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.arrJobs.empty())
+		{
+			job = std::move(queue.arrJobs.back());
+			queue.arrJobs.pop_back();
+			bFound = true;
+		}
+	}
+
+	// steal the oldest job from the other queues, it is likely the biggest one
+	for (size_t i=1; i<m_arrQueues.size() && !bFound; i++)
+	{
+		JOBQUEUE& queue = *m_arrQueues[(uQueue + i) % m_arrQueues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.arrJobs.empty())
+		{
+			job = std::move(queue.arrJobs.front());
+			queue.arrJobs.pop_front();
+			bFound = true;
+		}
+	}
+
+	if (!bFound)
+	{
+		return false;
+	}
+
+	m_uQueuedJobs.fetch_sub(1);
+	job.fnJob();
+	if (job.pCounter)
+	{
+		job.pCounter->fetch_sub(1);
+	}
+	return true;
+}
+
+
+void JobSystem::WorkerThread(uint32_t uQueue)
+{
+	s_pOwner = this;
+	s_uQueueIndex = uQueue;
+
+	while (!m_bQuit)
+	{
+		if (!RunOneJob(uQueue))
+		{
+			std::unique_lock<std::mutex> lock(m_WakeMutex);
+			m_WakeCondition.wait(lock, [this]() { return m_bQuit || m_uQueuedJobs.load() > 0; });
+		}
+	}
+
+	s_pOwner = nullptr;
+}
+
+
+uint32_t JobSystem::GetQueueIndex() const
+{
+	return (s_pOwner == this) ? s_uQueueIndex : 0;
+}
@@ -0,0 +1,203 @@
+/**
+ * ============================================================================
+ *  Name        : LightManager.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : shadowed spot lights sharing one shadow map atlas
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#include "../include/LightManager.h"
+#include <algorithm>
+
+
+LightManager::LightManager()
+{
+	m_uAtlasSize = 2048;
+	m_uTileSize = 512;
+	m_uUpdateBudget = 2;
+	m_uDeferredCount = 0;
+}
+
+
+LightManager::~LightManager()
+{
+}
+
+
+void LightManager::SetAtlas(uint32_t uAtlasSize, uint32_t uTileSize)
+{
+	m_uAtlasSize = uAtlasSize;
+	m_uTileSize = std::min(uTileSize, uAtlasSize);
+	AssignTiles();
+}
+
+
+void LightManager::Clear()
+{
+	m_arrLights.clear();
+	m_arrStates.clear();
+	m_arrUpdates.clear();
+	m_uDeferredCount = 0;
+}
+
+
+uint32_t LightManager::AddLight(const LIGHT& light)
+{
+	const uint32_t uLight = (uint32_t)m_arrLights.size();
+	m_arrLights.push_back(light);
+
+	STATE state;
+	state.uTile = NO_TILE;
+	state.mViewProjection = glm::mat4(1.0f);
+	state.mRenderedViewProjection = glm::mat4(1.0f);
+	state.mShadowMatrix = glm::mat4(1.0f);
+	state.uFramesWaited = 0;
+	state.fScore = 0.0f;
+	state.bRendered = false;
+	state.bInvalid = true;
+	m_arrStates.push_back(state);
+
+	// tiles go to lights in the order they are added
+	const uint32_t uTilesPerRow = m_uAtlasSize / m_uTileSize;
+	if (uLight < uTilesPerRow * uTilesPerRow)
+	{
+		m_arrStates[uLight].uTile = uLight;
+	}
+	return uLight;
+}
+
+
+void LightManager::InvalidateSphere(const SPHERE& sphere)
+{
+	for (uint32_t i=0; i<m_arrStates.size(); i++)
+	{
+		STATE& state = m_arrStates[i];
+		if (state.bRendered && FRUSTUM(state.mRenderedViewProjection).Intersects(sphere))
+		{
+			state.bInvalid = true;
+		}
+	}
+}
+
+
+void LightManager::Invalidate()
+{
+	for (uint32_t i=0; i<m_arrStates.size(); i++)
+	{
+		m_arrStates[i].bInvalid = true;
+	}
+}
+
+
+const std::vector<uint32_t>& LightManager::Update(const glm::vec3& vCameraPosition)
+{
+	m_arrUpdates.clear();
+	m_arrCandidates.clear();
+
+	for (uint32_t i=0; i<m_arrLights.size(); i++)
+	{
+		STATE& state = m_arrStates[i];
+		if (state.uTile == NO_TILE)
+		{
+			continue;
+		}
+
+		const LIGHT& light = m_arrLights[i];
+		state.mViewProjection = GetLightViewProjection(light);
+		if (!state.bInvalid && state.mViewProjection == state.mRenderedViewProjection)
+		{
+			// tile is up to date
+			continue;
+		}
+
+		// lights near the camera cover more of the screen, and every frame of
+		// waiting raises the score so that no shadow is left behind for good
+		state.uFramesWaited++;
+		const float fDistance = glm::length(light.vPosition - vCameraPosition);
+		const float fImportance = light.fRange / (light.fRange + fDistance);
+		state.fScore = light.fPriority * fImportance * (float)state.uFramesWaited;
+		if (!state.bRendered)
+		{
+			// empty tiles first, their light would be unshadowed otherwise
+			state.fScore += 1000000.0f;
+		}
+		m_arrCandidates.push_back(i);
+	}
+
+	const uint32_t uUpdates = std::min((uint32_t)m_arrCandidates.size(), m_uUpdateBudget);
+	std::partial_sort(m_arrCandidates.begin(), m_arrCandidates.begin() + uUpdates, m_arrCandidates.end(),
+		[this](uint32_t a, uint32_t b) { return m_arrStates[a].fScore > m_arrStates[b].fScore; });
+
+	const float fTileScale = (float)m_uTileSize / (float)m_uAtlasSize;
+	for (uint32_t i=0; i<uUpdates; i++)
+	{
+		const uint32_t uLight = m_arrCandidates[i];
+		STATE& state = m_arrStates[uLight];
+		state.mRenderedViewProjection = state.mViewProjection;
+		state.uFramesWaited = 0;
+		state.bRendered = true;
+		state.bInvalid = false;
+
+		// bias into [0, 1] and into the tile of the light
+		const glm::vec2 vTile(GetTileViewport(uLight));
+		const glm::mat4 mTile(
+			0.5f * fTileScale, 0.0f, 0.0f, 0.0f,
+			0.0f, 0.5f * fTileScale, 0.0f, 0.0f,
+			0.0f, 0.0f, 0.5f, 0.0f,
+			(0.5f * (float)m_uTileSize + vTile.x) / (float)m_uAtlasSize,
+			(0.5f * (float)m_uTileSize + vTile.y) / (float)m_uAtlasSize,
+			0.5f, 1.0f);
+		state.mShadowMatrix = mTile * state.mRenderedViewProjection;
+
+		m_arrUpdates.push_back(uLight);
+	}
+
+	m_uDeferredCount = (uint32_t)m_arrCandidates.size() - uUpdates;
+	return m_arrUpdates;
+}
+
+
+glm::ivec2 LightManager::GetTileViewport(uint32_t uLight) const
+{
+	const uint32_t uTile = m_arrStates[uLight].uTile;
+	const uint32_t uTilesPerRow = m_uAtlasSize / m_uTileSize;
+	return glm::ivec2((uTile % uTilesPerRow) * m_uTileSize, (uTile / uTilesPerRow) * m_uTileSize);
+}
+
+
+glm::vec4 LightManager::GetTileRect(uint32_t uLight) const
+{
+	// filtering at the edges stays inside the tile
+	const glm::vec2 vTile(GetTileViewport(uLight));
+	const float fTexel = 1.0f / (float)m_uAtlasSize;
+	const glm::vec2 vMin((vTile + 0.5f) * fTexel);
+	const glm::vec2 vMax((vTile + (float)m_uTileSize - 0.5f) * fTexel);
+	return glm::vec4(vMin, vMax);
+}
+
+
+glm::mat4 LightManager::GetLightViewProjection(const LIGHT& light)
+{
+	const glm::vec3 vDirection(glm::normalize(light.vDirection));
+	const glm::vec3 vUp = (fabsf(vDirection.y) > 0.99f) ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	const glm::mat4 mView(glm::lookAt(light.vPosition, light.vPosition + vDirection, vUp));
+	const glm::mat4 mProjection(glm::perspective(light.fConeAngle, 1.0f, light.fRange * 0.02f, light.fRange));
+	return mProjection * mView;
+}
+
+
+void LightManager::AssignTiles()
+{
+	const uint32_t uTilesPerRow = m_uAtlasSize / m_uTileSize;
+	const uint32_t uTiles = uTilesPerRow * uTilesPerRow;
+	for (uint32_t i=0; i<m_arrStates.size(); i++)
+	{
+		STATE& state = m_arrStates[i];
+		state.uTile = (i < uTiles) ? i : NO_TILE;
+		state.uFramesWaited = 0;
+		state.bRendered = false;
+		state.bInvalid = true;
+	}
+}
@@ -0,0 +1,136 @@
+/**
+ * ============================================================================
+ *  Name        : MappedFile.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : read only memory mapped file
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#include "../include/MappedFile.h"
+
+#if defined (_WINDOWS)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#endif
+
+#if defined (_LINUX)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+MappedFile::MappedFile()
+{
+	m_pData = nullptr;
+	m_uSize = 0;
+
+#if defined (_WINDOWS)
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_hMapping = nullptr;
+#endif
+}
+
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+
+bool MappedFile::Open(const std::string& strFilename)
+{
+	Close();
+
+#if defined (_WINDOWS)
+	m_hFile = ::CreateFileA(strFilename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_hFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!::GetFileSizeEx(m_hFile, &size) || size.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+
+	m_hMapping = ::CreateFileMappingA(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_hMapping)
+	{
+		Close();
+		return false;
+	}
+
+	m_pData = (const unsigned char*)::MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+	if (!m_pData)
+	{
+		Close();
+		return false;
+	}
+	m_uSize = (size_t)size.QuadPart;
+#endif
+
+#if defined (_LINUX)
+	const int file = open(strFilename.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size <= 0)
+	{
+		close(file);
+		return false;
+	}
+
+	// the mapping keeps the file open, descriptor is not needed anymore
+	void* pData = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, file, 0);
+	close(file);
+	if (pData == MAP_FAILED)
+	{
+		return false;
+	}
+
+	m_pData = (const unsigned char*)pData;
+	m_uSize = (size_t)info.st_size;
+#endif
+
+	return m_pData != nullptr;
+}
+
+
+void MappedFile::Close()
+{
+#if defined (_WINDOWS)
+	if (m_pData)
+	{
+		::UnmapViewOfFile(m_pData);
+	}
+	if (m_hMapping)
+	{
+		::CloseHandle(m_hMapping);
+		m_hMapping = nullptr;
+	}
+	if (m_hFile != INVALID_HANDLE_VALUE)
+	{
+		::CloseHandle(m_hFile);
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+#endif
+
+#if defined (_LINUX)
+	if (m_pData)
+	{
+		munmap((void*)m_pData, m_uSize);
+	}
+#endif
+
+	m_pData = nullptr;
+	m_uSize = 0;
+}
@@ -9,6 +9,7 @@
 **/
 
 #include "../include/Material.h"
+#include "../include/MaterialBuffer.h"
 
 
 Material::Material()
@@ -18,6 +19,10 @@ Material::Material()
 	m_cSpecular = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
 	m_cEmissive = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
 	m_fSpecularPower = 50.0f;
+
+	m_pBuffer = nullptr;
+	m_uBufferSlot = 0;
+	m_bDirty = true;
 }
 
 
@@ -26,37 +31,27 @@ Material::~Material()
 }
 
 
-void Material::SetToProgram(GLuint uProgram)
+void Material::SetToProgram(COpenGLRenderer* pRenderer, GLuint uProgram)
 {
-	GLint location = glGetUniformLocation(uProgram, "materialAmbient");
-	if (location != -1)
-	{
-		glUniform4f(location, m_cAmbient.r, m_cAmbient.g, m_cAmbient.b, m_cAmbient.a);
-	}
-
-	location = glGetUniformLocation(uProgram, "materialDiffuse");
-	if (location != -1)
-	{
-		glUniform4f(location, m_cDiffuse.r, m_cDiffuse.g, m_cDiffuse.b, m_cDiffuse.a);
-	}
-
-	location = glGetUniformLocation(uProgram, "materialSpecular");
-	if (location != -1)
-	{
-		glUniform4f(location, m_cSpecular.r, m_cSpecular.g, m_cSpecular.b, m_cSpecular.a);
-	}
-
-	location = glGetUniformLocation(uProgram, "materialEmissive");
-	if (location != -1)
+	static const UniformId materialAmbientId = COpenGLRenderer::GetUniformId("materialAmbient");
+	static const UniformId materialDiffuseId = COpenGLRenderer::GetUniformId("materialDiffuse");
+	static const UniformId materialSpecularId = COpenGLRenderer::GetUniformId("materialSpecular");
+	static const UniformId materialEmissiveId = COpenGLRenderer::GetUniformId("materialEmissive");
+	static const UniformId specularPowerId = COpenGLRenderer::GetUniformId("specularPower");
+
+	// one range bind replaces the uniform uploads
+	if (m_pBuffer && m_pBuffer->HasProgram(uProgram))
 	{
-		glUniform4f(location, m_cEmissive.r, m_cEmissive.g, m_cEmissive.b, m_cEmissive.a);
+		m_pBuffer->Bind(pRenderer, this);
+		return;
 	}
 
-	location = glGetUniformLocation(uProgram, "specularPower");
-	if (location != -1)
-	{
-		glUniform1f(location, m_fSpecularPower);
-	}
+	// renderer skips the uniforms program does not use
+	pRenderer->SetUniform(uProgram, materialAmbientId, m_cAmbient);
+	pRenderer->SetUniform(uProgram, materialDiffuseId, m_cDiffuse);
+	pRenderer->SetUniform(uProgram, materialSpecularId, m_cSpecular);
+	pRenderer->SetUniform(uProgram, materialEmissiveId, m_cEmissive);
+	pRenderer->SetUniform(uProgram, specularPowerId, m_fSpecularPower);
 }
 
 
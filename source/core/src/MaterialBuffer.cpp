@@ -0,0 +1,133 @@
+/**
+ * ============================================================================
+ *  Name        : MaterialBuffer.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : materials packed into one uniform buffer object
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#include "../include/MaterialBuffer.h"
+#include <algorithm>
+
+
+MaterialBuffer::MaterialBuffer()
+{
+	m_uBuffer = 0;
+	m_uCapacity = 0;
+	m_uStride = 0;
+	m_uUploadCount = 0;
+}
+
+
+MaterialBuffer::~MaterialBuffer()
+{
+}
+
+
+bool MaterialBuffer::Create(COpenGLRenderer* pRenderer, uint32_t uCapacity)
+{
+	if (!pRenderer->HasUniformBuffers())
+	{
+		IApplication::Debug("MaterialBuffer::Create - uniform buffers are not supported\n");
+		return false;
+	}
+
+	// each block starts at an offset glBindBufferRange accepts
+	GLint alignment = 256;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	const uint32_t uAlignment = (uint32_t)std::max(alignment, 1);
+	m_uStride = (((uint32_t)sizeof(MATERIALBLOCK) + uAlignment - 1) / uAlignment) * uAlignment;
+	m_uCapacity = uCapacity;
+	m_uUploadCount = 0;
+
+	glGenBuffers(1, &m_uBuffer);
+	pRenderer->BindBuffer(GL_UNIFORM_BUFFER, m_uBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, (GLsizeiptr)m_uStride * m_uCapacity, nullptr, GL_DYNAMIC_DRAW);
+	pRenderer->BindBuffer(GL_UNIFORM_BUFFER, 0);
+	return true;
+}
+
+
+void MaterialBuffer::Release(COpenGLRenderer* pRenderer)
+{
+	for (uint32_t i=0; i<m_arrMaterials.size(); i++)
+	{
+		m_arrMaterials[i]->m_pBuffer = nullptr;
+	}
+	m_arrMaterials.clear();
+	m_arrPrograms.clear();
+
+	if (m_uBuffer)
+	{
+		pRenderer->DeleteBuffer(m_uBuffer);
+		m_uBuffer = 0;
+	}
+}
+
+
+bool MaterialBuffer::AddMaterial(Material* pMaterial)
+{
+	if (!m_uBuffer || m_arrMaterials.size() >= m_uCapacity)
+	{
+		return false;
+	}
+
+	pMaterial->m_pBuffer = this;
+	pMaterial->m_uBufferSlot = (uint32_t)m_arrMaterials.size();
+	pMaterial->SetDirty();
+	m_arrMaterials.push_back(pMaterial);
+	return true;
+}
+
+
+bool MaterialBuffer::AttachProgram(GLuint uProgram)
+{
+	if (!m_uBuffer)
+	{
+		return false;
+	}
+
+	const GLuint uBlock = glGetUniformBlockIndex(uProgram, "MaterialBlock");
+	if (uBlock == GL_INVALID_INDEX)
+	{
+		return false;
+	}
+
+	glUniformBlockBinding(uProgram, uBlock, BINDING);
+	if (!HasProgram(uProgram))
+	{
+		m_arrPrograms.push_back(uProgram);
+	}
+	return true;
+}
+
+
+bool MaterialBuffer::HasProgram(GLuint uProgram) const
+{
+	return std::find(m_arrPrograms.begin(), m_arrPrograms.end(), uProgram) != m_arrPrograms.end();
+}
+
+
+void MaterialBuffer::Bind(COpenGLRenderer* pRenderer, Material* pMaterial)
+{
+	const GLintptr iOffset = (GLintptr)m_uStride * pMaterial->m_uBufferSlot;
+	if (pMaterial->IsDirty())
+	{
+		MATERIALBLOCK block;
+		block.cAmbient = pMaterial->m_cAmbient;
+		block.cDiffuse = pMaterial->m_cDiffuse;
+		block.cSpecular = pMaterial->m_cSpecular;
+		block.cEmissive = pMaterial->m_cEmissive;
+		block.fSpecularPower = pMaterial->m_fSpecularPower;
+		block.arrPadding[0] = block.arrPadding[1] = block.arrPadding[2] = 0.0f;
+
+		pRenderer->BindBuffer(GL_UNIFORM_BUFFER, m_uBuffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, iOffset, sizeof(MATERIALBLOCK), &block);
+		pMaterial->m_bDirty = false;
+		++m_uUploadCount;
+	}
+
+	pRenderer->BindUniformBuffer(BINDING, m_uBuffer, iOffset, sizeof(MATERIALBLOCK));
+}
@@ -0,0 +1,298 @@
+/**
+ * ============================================================================
+ *  Name        : MeshFile.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : memory mapped binary mesh container
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#include "../include/MeshFile.h"
+#include "../include/VertexFormat.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+static_assert(sizeof(MESHHEADER) == 88, "MESHHEADER is a file format struct");
+static_assert(sizeof(MESHATTRIBUTE) == 32, "MESHATTRIBUTE is a file format struct");
+static_assert(sizeof(MESHLOD) == 16, "MESHLOD is a file format struct");
+
+static const uint32_t MESHFILE_ALIGNMENT = 16;
+static const uint32_t MESHFILE_MAX_ATTRIBUTES = 16;
+static const uint32_t MESHFILE_MAX_LODS = 32;
+
+
+static uint32_t Align(uint32_t uOffset)
+{
+	return (uOffset + MESHFILE_ALIGNMENT - 1) & ~(MESHFILE_ALIGNMENT - 1);
+}
+
+
+static bool IsInside(uint64_t uOffset, uint64_t uSize, uint64_t uFileSize)
+{
+	return (uOffset % MESHFILE_ALIGNMENT) == 0 && uOffset <= uFileSize && uSize <= uFileSize - uOffset;
+}
+
+
+bool MeshFile::Open(const std::string& strFilename)
+{
+	Close();
+	if (!m_File.Open(strFilename) || m_File.GetSize() < sizeof(MESHHEADER))
+	{
+		Close();
+		return false;
+	}
+
+	const unsigned char* pData = m_File.GetData();
+	const uint64_t uFileSize = m_File.GetSize();
+	const MESHHEADER* pHeader = (const MESHHEADER*)pData;
+
+	if (pHeader->uMagic != MESHFILE_MAGIC ||
+		pHeader->uVersion != MESHFILE_VERSION ||
+		pHeader->uVertexCount == 0 ||
+		pHeader->uVertexStride == 0 ||
+		(pHeader->uIndexSize != 2 && pHeader->uIndexSize != 4) ||
+		pHeader->uAttributeCount == 0 ||
+		pHeader->uAttributeCount > MESHFILE_MAX_ATTRIBUTES ||
+		pHeader->uLodCount > MESHFILE_MAX_LODS)
+	{
+		Close();
+		return false;
+	}
+
+	// all sections have to fit into the file. Index values are not checked,
+	// that would touch every page of the index data
+	if (!IsInside(pHeader->uAttributesOffset, (uint64_t)pHeader->uAttributeCount * sizeof(MESHATTRIBUTE), uFileSize) ||
+		!IsInside(pHeader->uLodsOffset, (uint64_t)pHeader->uLodCount * sizeof(MESHLOD), uFileSize) ||
+		!IsInside(pHeader->uVerticesOffset, (uint64_t)pHeader->uVertexCount * pHeader->uVertexStride, uFileSize) ||
+		!IsInside(pHeader->uIndicesOffset, (uint64_t)pHeader->uIndexCount * pHeader->uIndexSize, uFileSize))
+	{
+		Close();
+		return false;
+	}
+
+	const MESHATTRIBUTE* pAttributes = (const MESHATTRIBUTE*)(pData + pHeader->uAttributesOffset);
+	for (uint32_t i=0; i<pHeader->uAttributeCount; i++)
+	{
+		const MESHATTRIBUTE& attribute = pAttributes[i];
+		const uint32_t uSize = GetAttributeSize(attribute);
+		if (!uSize ||
+			attribute.szName[sizeof(attribute.szName) - 1] != 0 ||
+			(uint64_t)attribute.uOffset + uSize > pHeader->uVertexStride)
+		{
+			Close();
+			return false;
+		}
+	}
+
+	const MESHLOD* pLods = (const MESHLOD*)(pData + pHeader->uLodsOffset);
+	for (uint32_t i=0; i<pHeader->uLodCount; i++)
+	{
+		if ((uint64_t)pLods[i].uFirstIndex + pLods[i].uIndexCount > pHeader->uIndexCount)
+		{
+			Close();
+			return false;
+		}
+	}
+
+	m_pHeader = pHeader;
+	m_pAttributes = pAttributes;
+	m_pLods = pLods;
+	m_pVertices = pData + pHeader->uVerticesOffset;
+	m_pIndices = pData + pHeader->uIndicesOffset;
+	return true;
+}
+
+
+void MeshFile::Close()
+{
+	m_File.Close();
+	m_pHeader = nullptr;
+	m_pAttributes = nullptr;
+	m_pLods = nullptr;
+	m_pVertices = nullptr;
+	m_pIndices = nullptr;
+}
+
+
+uint32_t MeshFile::GetAttributeSize(const MESHATTRIBUTE& attribute)
+{
+	if (attribute.uComponents < 1 || attribute.uComponents > 4)
+	{
+		return 0;
+	}
+
+	switch (attribute.uType)
+	{
+	case MESHTYPE_FLOAT:
+		return attribute.uComponents * 4;
+	case MESHTYPE_HALF:
+	case MESHTYPE_INT16:
+		return attribute.uComponents * 2;
+	case MESHTYPE_INT_2_10_10_10:
+		return (attribute.uComponents == 4) ? 4 : 0;
+	}
+	return 0;
+}
+
+
+// model space position of a vertex, int16 positions are relative to the bounds
+static void DecodePosition(const unsigned char* pVertex, const MESHATTRIBUTE& attribute,
+	const float* arrCenter, const float* arrScale, float* arrPosition)
+{
+	for (uint32_t c=0; c<3; c++)
+	{
+		if (attribute.uType == MESHTYPE_FLOAT)
+		{
+			memcpy(&arrPosition[c], pVertex + attribute.uOffset + c * 4, 4);
+		}
+		else
+		{
+			uint16_t uValue;
+			memcpy(&uValue, pVertex + attribute.uOffset + c * 2, 2);
+			arrPosition[c] = (attribute.uType == MESHTYPE_HALF) ?
+				VertexFormat::HalfToFloat(uValue) :
+				arrCenter[c] + std::max((int16_t)uValue / 32767.0f, -1.0f) * arrScale[c];
+		}
+	}
+}
+
+
+bool MeshFile::Save(const std::string& strFilename,
+	const std::vector<MESHATTRIBUTE>& arrAttributes,
+	uint32_t uVertexStride,
+	const void* pVertices,
+	uint32_t uVertexCount,
+	const std::vector<uint32_t>& arrIndices,
+	const std::vector<MESHLOD>& arrLods,
+	const float* pBounds)
+{
+	if (arrAttributes.empty() || arrAttributes.size() > MESHFILE_MAX_ATTRIBUTES ||
+		arrLods.size() > MESHFILE_MAX_LODS ||
+		!uVertexStride || !uVertexCount)
+	{
+		return false;
+	}
+
+	MESHHEADER header;
+	memset(&header, 0, sizeof(header));
+	header.uMagic = MESHFILE_MAGIC;
+	header.uVersion = MESHFILE_VERSION;
+	header.uVertexCount = uVertexCount;
+	header.uVertexStride = uVertexStride;
+	header.uIndexCount = (uint32_t)arrIndices.size();
+	header.uIndexSize = (uVertexCount <= 0xffff) ? 2 : 4;
+	header.uAttributeCount = (uint32_t)arrAttributes.size();
+	header.uLodCount = arrLods.empty() ? 1 : (uint32_t)arrLods.size();
+	header.uAttributesOffset = Align(sizeof(MESHHEADER));
+	header.uLodsOffset = Align(header.uAttributesOffset + header.uAttributeCount * sizeof(MESHATTRIBUTE));
+	header.uVerticesOffset = Align(header.uLodsOffset + header.uLodCount * sizeof(MESHLOD));
+
+	const uint64_t uIndicesOffset = ((uint64_t)header.uVerticesOffset + (uint64_t)uVertexCount * uVertexStride + MESHFILE_ALIGNMENT - 1) & ~(uint64_t)(MESHFILE_ALIGNMENT - 1);
+	if (uIndicesOffset + (uint64_t)arrIndices.size() * header.uIndexSize > 0xffffffff)
+	{
+		return false;
+	}
+	header.uIndicesOffset = (uint32_t)uIndicesOffset;
+
+	// bounds and sphere from the positions
+	const unsigned char* pVertexData = (const unsigned char*)pVertices;
+	for (const MESHATTRIBUTE& attribute : arrAttributes)
+	{
+		if (strcmp(attribute.szName, "position") || attribute.uComponents < 3 || attribute.uType == MESHTYPE_INT_2_10_10_10)
+		{
+			continue;
+		}
+
+		float arrCenter[3] = { 0.0f, 0.0f, 0.0f };
+		float arrScale[3] = { 1.0f, 1.0f, 1.0f };
+		float arrPosition[3];
+		if (attribute.uType == MESHTYPE_INT16)
+		{
+			if (!pBounds)
+			{
+				return false;
+			}
+			memcpy(header.arrBoundsMin, pBounds, sizeof(float) * 3);
+			memcpy(header.arrBoundsMax, pBounds + 3, sizeof(float) * 3);
+			VertexFormat::GetInt16Scale(header.arrBoundsMin, header.arrBoundsMax, arrCenter, arrScale);
+		}
+		else
+		{
+			float arrMin[3] = { INFINITY, INFINITY, INFINITY };
+			float arrMax[3] = { -INFINITY, -INFINITY, -INFINITY };
+			for (uint32_t i=0; i<uVertexCount; i++)
+			{
+				DecodePosition(pVertexData + (size_t)i * uVertexStride, attribute, arrCenter, arrScale, arrPosition);
+				for (uint32_t c=0; c<3; c++)
+				{
+					arrMin[c] = std::min(arrMin[c], arrPosition[c]);
+					arrMax[c] = std::max(arrMax[c], arrPosition[c]);
+				}
+			}
+			memcpy(header.arrBoundsMin, arrMin, sizeof(arrMin));
+			memcpy(header.arrBoundsMax, arrMax, sizeof(arrMax));
+		}
+
+		float fRadius = 0.0f;
+		for (uint32_t c=0; c<3; c++)
+		{
+			header.arrSphere[c] = (header.arrBoundsMin[c] + header.arrBoundsMax[c]) * 0.5f;
+		}
+		for (uint32_t i=0; i<uVertexCount; i++)
+		{
+			DecodePosition(pVertexData + (size_t)i * uVertexStride, attribute, arrCenter, arrScale, arrPosition);
+			const float dx = arrPosition[0] - header.arrSphere[0];
+			const float dy = arrPosition[1] - header.arrSphere[1];
+			const float dz = arrPosition[2] - header.arrSphere[2];
+			fRadius = std::max(fRadius, dx * dx + dy * dy + dz * dz);
+		}
+		header.arrSphere[3] = std::sqrt(fRadius);
+		break;
+	}
+
+	std::vector<MESHLOD> arrFileLods(arrLods);
+	if (arrFileLods.empty())
+	{
+		MESHLOD lod;
+		memset(&lod, 0, sizeof(lod));
+		lod.uIndexCount = header.uIndexCount;
+		lod.fMaxDistance = INFINITY;
+		arrFileLods.push_back(lod);
+	}
+
+	std::ofstream file(strFilename, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+
+	const char arrPadding[MESHFILE_ALIGNMENT] = {};
+	auto pad = [&](uint32_t uOffset)
+	{
+		file.write(arrPadding, (std::streamsize)(uOffset - (uint32_t)file.tellp()));
+	};
+
+	file.write((const char*)&header, sizeof(header));
+	pad(header.uAttributesOffset);
+	file.write((const char*)arrAttributes.data(), (std::streamsize)(arrAttributes.size() * sizeof(MESHATTRIBUTE)));
+	pad(header.uLodsOffset);
+	file.write((const char*)arrFileLods.data(), (std::streamsize)(arrFileLods.size() * sizeof(MESHLOD)));
+	pad(header.uVerticesOffset);
+	file.write((const char*)pVertices, (std::streamsize)((size_t)uVertexCount * uVertexStride));
+	pad(header.uIndicesOffset);
+
+	if (header.uIndexSize == 2)
+	{
+		std::vector<uint16_t> arrShortIndices(arrIndices.begin(), arrIndices.end());
+		file.write((const char*)arrShortIndices.data(), (std::streamsize)(arrShortIndices.size() * 2));
+	}
+	else
+	{
+		file.write((const char*)arrIndices.data(), (std::streamsize)(arrIndices.size() * 4));
+	}
+
+	return file.good();
+}
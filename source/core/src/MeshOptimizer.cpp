@@ -0,0 +1,642 @@
+/**
+ * ============================================================================
+ *  Name        : MeshOptimizer.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : indexed triangle list welding and reordering for the gpu
+ *                vertex caches, overdraw and vertex fetch
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#include "../include/MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+static const uint32_t INVALID_INDEX = 0xffffffff;
+
+// cache model and scoring constants from the original article
+static const uint32_t CACHE_SIZE = 32;
+static const float CACHE_DECAY_POWER = 1.5f;
+static const float LAST_TRIANGLE_SCORE = 0.75f;
+static const float VALENCE_BOOST_SCALE = 2.0f;
+static const float VALENCE_BOOST_POWER = 0.5f;
+
+
+static float GetVertexScore(int32_t iCachePosition, uint32_t uRemaining)
+{
+	if (uRemaining == 0)
+	{
+		// no triangles left to use the vertex
+		return -1.0f;
+	}
+
+	float fScore = 0.0f;
+	if (iCachePosition >= 0)
+	{
+		// vertices of the last triangle get a fixed score so that the next
+		// triangle does not simply reuse the edge it was just drawn from
+		if (iCachePosition < 3)
+		{
+			fScore = LAST_TRIANGLE_SCORE;
+		}
+		else
+		{
+			fScore = powf(1.0f - (float)(iCachePosition - 3) / (CACHE_SIZE - 3), CACHE_DECAY_POWER);
+		}
+	}
+
+	// boost vertices with few triangles left to finish them off and avoid
+	// leaving lone triangles behind
+	return fScore + VALENCE_BOOST_SCALE * powf((float)uRemaining, -VALENCE_BOOST_POWER);
+}
+
+
+void MeshOptimizer::OptimizeVertexCache(uint32_t* pIndices, size_t uIndexCount, size_t uVertexCount)
+{
+	const size_t uTriangleCount = uIndexCount / 3;
+	if (uTriangleCount == 0)
+	{
+		return;
+	}
+
+	// remaining triangles of each vertex, packed into one array
+	std::vector<uint32_t> arrRemaining(uVertexCount, 0);
+	for (size_t i=0; i<uTriangleCount * 3; i++)
+	{
+		++arrRemaining[pIndices[i]];
+	}
+
+	std::vector<uint32_t> arrFirst(uVertexCount + 1, 0);
+	for (size_t i=0; i<uVertexCount; i++)
+	{
+		arrFirst[i + 1] = arrFirst[i] + arrRemaining[i];
+	}
+
+	std::vector<uint32_t> arrTriangles(uTriangleCount * 3);
+	std::vector<uint32_t> arrFill(arrFirst.begin(), arrFirst.end() - 1);
+	for (size_t i=0; i<uTriangleCount * 3; i++)
+	{
+		arrTriangles[arrFill[pIndices[i]]++] = (uint32_t)(i / 3);
+	}
+
+	std::vector<int32_t> arrCachePosition(uVertexCount, -1);
+	std::vector<float> arrVertexScore(uVertexCount);
+	for (size_t i=0; i<uVertexCount; i++)
+	{
+		arrVertexScore[i] = GetVertexScore(-1, arrRemaining[i]);
+	}
+
+	std::vector<float> arrTriangleScore(uTriangleCount);
+	std::vector<unsigned char> arrEmitted(uTriangleCount, 0);
+	for (size_t i=0; i<uTriangleCount; i++)
+	{
+		arrTriangleScore[i] = arrVertexScore[pIndices[i * 3 + 0]] +
+			arrVertexScore[pIndices[i * 3 + 1]] +
+			arrVertexScore[pIndices[i * 3 + 2]];
+	}
+
+	std::vector<uint32_t> arrOutput;
+	arrOutput.reserve(uTriangleCount * 3);
+
+	// cache holds the triangle just added on top of the previous contents
+	uint32_t arrCache[CACHE_SIZE + 3];
+	uint32_t arrNewCache[CACHE_SIZE + 3];
+	uint32_t uCacheCount = 0;
+
+	size_t uNextTriangle = 0;
+	int64_t iBest = -1;
+
+	while (arrOutput.size() < uTriangleCount * 3)
+	{
+		if (iBest < 0)
+		{
+			// nothing in the cache has triangles left, continue in input order
+			while (arrEmitted[uNextTriangle])
+			{
+				++uNextTriangle;
+			}
+			iBest = (int64_t)uNextTriangle;
+		}
+
+		const uint32_t* pTriangle = pIndices + iBest * 3;
+		arrEmitted[iBest] = 1;
+
+		uint32_t uNewCount = 0;
+		for (uint32_t k=0; k<3; k++)
+		{
+			const uint32_t v = pTriangle[k];
+			arrOutput.push_back(v);
+
+			// remove the triangle from the vertex
+			uint32_t* pBegin = &arrTriangles[arrFirst[v]];
+			uint32_t* pEnd = pBegin + arrRemaining[v];
+			uint32_t* pFound = std::find(pBegin, pEnd, (uint32_t)iBest);
+			*pFound = *(pEnd - 1);
+			--arrRemaining[v];
+
+			if (std::find(arrNewCache, arrNewCache + uNewCount, v) == arrNewCache + uNewCount)
+			{
+				arrNewCache[uNewCount++] = v;
+			}
+		}
+		for (uint32_t c=0; c<uCacheCount; c++)
+		{
+			const uint32_t v = arrCache[c];
+			if (v != pTriangle[0] && v != pTriangle[1] && v != pTriangle[2])
+			{
+				arrNewCache[uNewCount++] = v;
+			}
+		}
+
+		// rescore the cached vertices and the ones that just dropped out
+		for (uint32_t c=0; c<uNewCount; c++)
+		{
+			const uint32_t v = arrNewCache[c];
+			arrCachePosition[v] = (c < CACHE_SIZE) ? (int32_t)c : -1;
+
+			const float fScore = GetVertexScore(arrCachePosition[v], arrRemaining[v]);
+			const float fDelta = fScore - arrVertexScore[v];
+			arrVertexScore[v] = fScore;
+
+			for (uint32_t i=arrFirst[v]; i<arrFirst[v] + arrRemaining[v]; i++)
+			{
+				arrTriangleScore[arrTriangles[i]] += fDelta;
+			}
+		}
+		uCacheCount = std::min(uNewCount, CACHE_SIZE);
+		memcpy(arrCache, arrNewCache, uCacheCount * sizeof(uint32_t));
+
+		// next triangle is the best one using a cached vertex
+		iBest = -1;
+		float fBestScore = -1.0f;
+		for (uint32_t c=0; c<uCacheCount; c++)
+		{
+			const uint32_t v = arrCache[c];
+			for (uint32_t i=arrFirst[v]; i<arrFirst[v] + arrRemaining[v]; i++)
+			{
+				const uint32_t t = arrTriangles[i];
+				if (arrTriangleScore[t] > fBestScore)
+				{
+					fBestScore = arrTriangleScore[t];
+					iBest = t;
+				}
+			}
+		}
+	}
+
+	memcpy(pIndices, arrOutput.data(), arrOutput.size() * sizeof(uint32_t));
+}
+
+
+static uint64_t HashCell(int64_t x, int64_t y, int64_t z)
+{
+	return (uint64_t)(x * 73856093) ^ (uint64_t)(y * 19349663) ^ (uint64_t)(z * 83492791);
+}
+
+
+static uint64_t HashBytes(const void* pData, size_t uSize)
+{
+	// FNV-1a
+	const unsigned char* pBytes = (const unsigned char*)pData;
+	uint64_t uHash = 14695981039346656037ull;
+	for (size_t i=0; i<uSize; i++)
+	{
+		uHash = (uHash ^ pBytes[i]) * 1099511628211ull;
+	}
+	return uHash;
+}
+
+
+static bool IsNear(const float* pA, const float* pB, uint32_t uVertexSize, float fEpsilon)
+{
+	for (uint32_t i=0; i<uVertexSize; i++)
+	{
+		if (fabsf(pA[i] - pB[i]) > fEpsilon)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+size_t MeshOptimizer::WeldVertices(float* pVertices, size_t uVertexCount, uint32_t uVertexSize,
+	uint32_t* pIndices, size_t uIndexCount, float fEpsilon)
+{
+	const size_t uVertexBytes = uVertexSize * sizeof(float);
+	const float fCellScale = (fEpsilon > 0.0f) ? 1.0f / fEpsilon : 0.0f;
+
+	// kept vertices with the same hash are chained through arrNext
+	std::unordered_map<uint64_t, uint32_t> mapFirst;
+	mapFirst.reserve(uVertexCount);
+	std::vector<uint32_t> arrNext;
+	arrNext.reserve(uVertexCount);
+	std::vector<uint32_t> arrRemap(uVertexCount);
+
+	uint32_t uKept = 0;
+	for (size_t i=0; i<uVertexCount; i++)
+	{
+		const float* pVertex = pVertices + i * uVertexSize;
+		uint32_t uMatch = INVALID_INDEX;
+		uint64_t uKey = 0;
+
+		if (fEpsilon > 0.0f)
+		{
+			// a vertex within epsilon may be in any of the neighbouring cells
+			const int64_t x = (int64_t)floorf(pVertex[0] * fCellScale);
+			const int64_t y = (int64_t)floorf(pVertex[1] * fCellScale);
+			const int64_t z = (int64_t)floorf(pVertex[2] * fCellScale);
+			uKey = HashCell(x, y, z);
+
+			for (int64_t dz = -1; dz <= 1 && uMatch == INVALID_INDEX; dz++)
+			{
+				for (int64_t dy = -1; dy <= 1 && uMatch == INVALID_INDEX; dy++)
+				{
+					for (int64_t dx = -1; dx <= 1 && uMatch == INVALID_INDEX; dx++)
+					{
+						auto it = mapFirst.find(HashCell(x + dx, y + dy, z + dz));
+						for (uint32_t k = (it != mapFirst.end()) ? it->second : INVALID_INDEX; k != INVALID_INDEX; k = arrNext[k])
+						{
+							if (IsNear(pVertex, pVertices + (size_t)k * uVertexSize, uVertexSize, fEpsilon))
+							{
+								uMatch = k;
+								break;
+							}
+						}
+					}
+				}
+			}
+		}
+		else
+		{
+			uKey = HashBytes(pVertex, uVertexBytes);
+			auto it = mapFirst.find(uKey);
+			for (uint32_t k = (it != mapFirst.end()) ? it->second : INVALID_INDEX; k != INVALID_INDEX; k = arrNext[k])
+			{
+				if (!memcmp(pVertex, pVertices + (size_t)k * uVertexSize, uVertexBytes))
+				{
+					uMatch = k;
+					break;
+				}
+			}
+		}
+
+		if (uMatch != INVALID_INDEX)
+		{
+			arrRemap[i] = uMatch;
+			continue;
+		}
+
+		// kept vertices are packed to the front, the slot is already read
+		if (uKept != i)
+		{
+			memcpy(pVertices + (size_t)uKept * uVertexSize, pVertex, uVertexBytes);
+		}
+		arrRemap[i] = uKept;
+
+		auto it = mapFirst.find(uKey);
+		arrNext.push_back((it != mapFirst.end()) ? it->second : INVALID_INDEX);
+		mapFirst[uKey] = uKept;
+		++uKept;
+	}
+
+	for (size_t i=0; i<uIndexCount; i++)
+	{
+		pIndices[i] = arrRemap[pIndices[i]];
+	}
+	return uKept;
+}
+
+
+void MeshOptimizer::OptimizeOverdraw(uint32_t* pIndices, size_t uIndexCount,
+	const float* pVertices, size_t uVertexCount, uint32_t uVertexSize, float fThreshold)
+{
+	const size_t uTriangleCount = uIndexCount / 3;
+	if (uTriangleCount < 2)
+	{
+		return;
+	}
+
+	const uint32_t uCacheSize = 16;
+	const float fTargetACMR = GetACMR(pIndices, uTriangleCount * 3, uVertexCount, uCacheSize) * fThreshold;
+
+	// split into clusters. A cluster starts where the cache is cold anyway,
+	// at a triangle that misses all of its vertices, or after a run that is
+	// already as cache efficient as the target so restarting costs little
+	std::vector<size_t> arrClusters;
+	std::vector<size_t> arrLoaded(uVertexCount, 0);
+	size_t uMisses = 0;
+	size_t uClusterStart = 0;
+	size_t uClusterMisses = 0;
+	for (size_t t=0; t<uTriangleCount; t++)
+	{
+		uint32_t uTriangleMisses = 0;
+		for (uint32_t k=0; k<3; k++)
+		{
+			const uint32_t v = pIndices[t * 3 + k];
+			if (!arrLoaded[v] || uMisses - arrLoaded[v] >= uCacheSize)
+			{
+				arrLoaded[v] = ++uMisses;
+				++uTriangleMisses;
+			}
+		}
+
+		if (t == uClusterStart || uTriangleMisses == 3)
+		{
+			arrClusters.push_back(t);
+			uClusterStart = t;
+			uClusterMisses = 0;
+		}
+		uClusterMisses += uTriangleMisses;
+
+		if ((float)uClusterMisses / (float)(t + 1 - uClusterStart) <= fTargetACMR)
+		{
+			// the next cluster may be drawn after any other, start it cold
+			uClusterStart = t + 1;
+			uMisses += uCacheSize;
+		}
+	}
+	arrClusters.push_back(uTriangleCount);
+
+	struct CLUSTER
+	{
+		size_t	uFirst;
+		size_t	uCount;
+		float	arrCenter[3];
+		float	arrNormal[3];
+		float	fArea;
+		float	fSortKey;
+	};
+	std::vector<CLUSTER> arrSorted(arrClusters.size() - 1);
+	float arrMeshCenter[3] = { 0.0f, 0.0f, 0.0f };
+	float fMeshArea = 0.0f;
+
+	for (size_t c=0; c<arrSorted.size(); c++)
+	{
+		CLUSTER& cluster = arrSorted[c];
+		cluster.uFirst = arrClusters[c];
+		cluster.uCount = arrClusters[c + 1] - arrClusters[c];
+		memset(cluster.arrCenter, 0, sizeof(cluster.arrCenter));
+		memset(cluster.arrNormal, 0, sizeof(cluster.arrNormal));
+		cluster.fArea = 0.0f;
+
+		for (size_t t=cluster.uFirst; t<cluster.uFirst + cluster.uCount; t++)
+		{
+			const float* p0 = pVertices + (size_t)pIndices[t * 3 + 0] * uVertexSize;
+			const float* p1 = pVertices + (size_t)pIndices[t * 3 + 1] * uVertexSize;
+			const float* p2 = pVertices + (size_t)pIndices[t * 3 + 2] * uVertexSize;
+
+			// clockwise front faces, outwards normal is (p2 - p0) x (p1 - p0)
+			const float ax = p2[0] - p0[0], ay = p2[1] - p0[1], az = p2[2] - p0[2];
+			const float bx = p1[0] - p0[0], by = p1[1] - p0[1], bz = p1[2] - p0[2];
+			const float nx = ay * bz - az * by;
+			const float ny = az * bx - ax * bz;
+			const float nz = ax * by - ay * bx;
+			const float fArea = sqrtf(nx * nx + ny * ny + nz * nz);
+
+			for (uint32_t i=0; i<3; i++)
+			{
+				cluster.arrCenter[i] += (p0[i] + p1[i] + p2[i]) * fArea;
+			}
+			cluster.arrNormal[0] += nx;
+			cluster.arrNormal[1] += ny;
+			cluster.arrNormal[2] += nz;
+			cluster.fArea += fArea;
+		}
+
+		for (uint32_t i=0; i<3; i++)
+		{
+			arrMeshCenter[i] += cluster.arrCenter[i];
+		}
+		fMeshArea += cluster.fArea;
+	}
+
+	// clusters facing away from the mesh center are the likely occluders
+	for (CLUSTER& cluster : arrSorted)
+	{
+		float fKey = 0.0f;
+		const float fNormalLength = sqrtf(cluster.arrNormal[0] * cluster.arrNormal[0] +
+			cluster.arrNormal[1] * cluster.arrNormal[1] +
+			cluster.arrNormal[2] * cluster.arrNormal[2]);
+		if (cluster.fArea > 0.0f && fMeshArea > 0.0f && fNormalLength > 0.0f)
+		{
+			for (uint32_t i=0; i<3; i++)
+			{
+				const float fOffset = cluster.arrCenter[i] / (cluster.fArea * 3.0f) - arrMeshCenter[i] / (fMeshArea * 3.0f);
+				fKey += fOffset * cluster.arrNormal[i] / fNormalLength;
+			}
+		}
+		cluster.fSortKey = fKey;
+	}
+
+	std::stable_sort(arrSorted.begin(), arrSorted.end(), [](const CLUSTER& a, const CLUSTER& b)
+	{
+		return a.fSortKey > b.fSortKey;
+	});
+
+	std::vector<uint32_t> arrOutput;
+	arrOutput.reserve(uTriangleCount * 3);
+	for (const CLUSTER& cluster : arrSorted)
+	{
+		arrOutput.insert(arrOutput.end(), pIndices + cluster.uFirst * 3, pIndices + (cluster.uFirst + cluster.uCount) * 3);
+	}
+	memcpy(pIndices, arrOutput.data(), arrOutput.size() * sizeof(uint32_t));
+}
+
+
+size_t MeshOptimizer::OptimizeVertexFetch(float* pVertices, size_t uVertexCount, uint32_t uVertexSize,
+	uint32_t* pIndices, size_t uIndexCount)
+{
+	std::vector<uint32_t> arrRemap(uVertexCount, INVALID_INDEX);
+	uint32_t uUsed = 0;
+	for (size_t i=0; i<uIndexCount; i++)
+	{
+		uint32_t& uRemap = arrRemap[pIndices[i]];
+		if (uRemap == INVALID_INDEX)
+		{
+			uRemap = uUsed++;
+		}
+		pIndices[i] = uRemap;
+	}
+
+	const std::vector<float> arrSource(pVertices, pVertices + uVertexCount * uVertexSize);
+	for (size_t i=0; i<uVertexCount; i++)
+	{
+		if (arrRemap[i] != INVALID_INDEX)
+		{
+			memcpy(pVertices + (size_t)arrRemap[i] * uVertexSize, &arrSource[i * uVertexSize], uVertexSize * sizeof(float));
+		}
+	}
+	return uUsed;
+}
+
+
+size_t MeshOptimizer::GetCacheMisses(const uint32_t* pIndices, size_t uIndexCount, size_t uVertexCount,
+	uint32_t uCacheSize, size_t* pUsedVertices)
+{
+	// vertex stays in the cache until uCacheSize newer vertices are loaded
+	std::vector<size_t> arrLoaded(uVertexCount, 0);
+	size_t uMisses = 0;
+	size_t uUsed = 0;
+	for (size_t i=0; i<uIndexCount; i++)
+	{
+		const uint32_t v = pIndices[i];
+		if (!arrLoaded[v])
+		{
+			++uUsed;
+		}
+		if (!arrLoaded[v] || uMisses - arrLoaded[v] >= uCacheSize)
+		{
+			arrLoaded[v] = ++uMisses;
+		}
+	}
+
+	if (pUsedVertices)
+	{
+		*pUsedVertices = uUsed;
+	}
+	return uMisses;
+}
+
+
+float MeshOptimizer::GetACMR(const uint32_t* pIndices, size_t uIndexCount, size_t uVertexCount, uint32_t uCacheSize)
+{
+	if (uIndexCount < 3)
+	{
+		return 0.0f;
+	}
+	return (float)GetCacheMisses(pIndices, uIndexCount, uVertexCount, uCacheSize, nullptr) / (float)(uIndexCount / 3);
+}
+
+
+float MeshOptimizer::GetATVR(const uint32_t* pIndices, size_t uIndexCount, size_t uVertexCount, uint32_t uCacheSize)
+{
+	size_t uUsed = 0;
+	const size_t uMisses = GetCacheMisses(pIndices, uIndexCount, uVertexCount, uCacheSize, &uUsed);
+	return uUsed ? (float)uMisses / (float)uUsed : 0.0f;
+}
+
+
+float MeshOptimizer::GetOverdraw(const uint32_t* pIndices, size_t uIndexCount,
+	const float* pVertices, size_t uVertexCount, uint32_t uVertexSize, uint32_t uResolution)
+{
+	if (uIndexCount < 3 || uVertexCount == 0 || uResolution == 0)
+	{
+		return 0.0f;
+	}
+
+	float arrMin[3] = { pVertices[0], pVertices[1], pVertices[2] };
+	float fExtent = 0.0f;
+	{
+		float arrMax[3] = { pVertices[0], pVertices[1], pVertices[2] };
+		for (size_t i=1; i<uVertexCount; i++)
+		{
+			for (uint32_t c=0; c<3; c++)
+			{
+				arrMin[c] = std::min(arrMin[c], pVertices[i * uVertexSize + c]);
+				arrMax[c] = std::max(arrMax[c], pVertices[i * uVertexSize + c]);
+			}
+		}
+		for (uint32_t c=0; c<3; c++)
+		{
+			fExtent = std::max(fExtent, arrMax[c] - arrMin[c]);
+		}
+	}
+	if (fExtent <= 0.0f)
+	{
+		return 0.0f;
+	}
+	const float fScale = (float)uResolution / fExtent;
+
+	std::vector<float> arrDepth((size_t)uResolution * uResolution);
+	size_t uShaded = 0;
+	size_t uCovered = 0;
+
+	for (uint32_t uView=0; uView<6; uView++)
+	{
+		// look along an axis, from the negative or the positive side
+		const uint32_t uAxis = uView % 3;
+		const uint32_t uAxisX = (uAxis + 1) % 3;
+		const uint32_t uAxisY = (uAxis + 2) % 3;
+		const float fSide = (uView < 3) ? 1.0f : -1.0f;
+		std::fill(arrDepth.begin(), arrDepth.end(), INFINITY);
+
+		for (size_t t=0; t<uIndexCount / 3; t++)
+		{
+			const float* p0 = pVertices + (size_t)pIndices[t * 3 + 0] * uVertexSize;
+			const float* p1 = pVertices + (size_t)pIndices[t * 3 + 1] * uVertexSize;
+			const float* p2 = pVertices + (size_t)pIndices[t * 3 + 2] * uVertexSize;
+
+			// back face culling with the outwards normal (p2 - p0) x (p1 - p0)
+			const float a0 = p2[uAxisX] - p0[uAxisX], a1 = p2[uAxisY] - p0[uAxisY];
+			const float b0 = p1[uAxisX] - p0[uAxisX], b1 = p1[uAxisY] - p0[uAxisY];
+			if (-fSide * (a0 * b1 - a1 * b0) <= 0.0f)
+			{
+				continue;
+			}
+
+			const float x0 = (p0[uAxisX] - arrMin[uAxisX]) * fScale, y0 = (p0[uAxisY] - arrMin[uAxisY]) * fScale;
+			const float x1 = (p1[uAxisX] - arrMin[uAxisX]) * fScale, y1 = (p1[uAxisY] - arrMin[uAxisY]) * fScale;
+			const float x2 = (p2[uAxisX] - arrMin[uAxisX]) * fScale, y2 = (p2[uAxisY] - arrMin[uAxisY]) * fScale;
+			const float z0 = fSide * p0[uAxis], z1 = fSide * p1[uAxis], z2 = fSide * p2[uAxis];
+
+			const float fArea = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+			if (fArea == 0.0f)
+			{
+				continue;
+			}
+			const float fInvArea = 1.0f / fArea;
+
+			const int32_t iMinX = std::max((int32_t)floorf(std::min(std::min(x0, x1), x2)), 0);
+			const int32_t iMinY = std::max((int32_t)floorf(std::min(std::min(y0, y1), y2)), 0);
+			const int32_t iMaxX = std::min((int32_t)ceilf(std::max(std::max(x0, x1), x2)), (int32_t)uResolution - 1);
+			const int32_t iMaxY = std::min((int32_t)ceilf(std::max(std::max(y0, y1), y2)), (int32_t)uResolution - 1);
+
+			for (int32_t y=iMinY; y<=iMaxY; y++)
+			{
+				const float py = y + 0.5f;
+				for (int32_t x=iMinX; x<=iMaxX; x++)
+				{
+					// barycentrics of the pixel center, all positive inside
+					const float px = x + 0.5f;
+					const float w0 = ((x2 - x1) * (py - y1) - (px - x1) * (y2 - y1)) * fInvArea;
+					const float w1 = ((x0 - x2) * (py - y2) - (px - x2) * (y0 - y2)) * fInvArea;
+					const float w2 = 1.0f - w0 - w1;
+					if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+					{
+						continue;
+					}
+
+					const float z = w0 * z0 + w1 * z1 + w2 * z2;
+					float& fDepth = arrDepth[(size_t)y * uResolution + x];
+					if (z < fDepth)
+					{
+						fDepth = z;
+						++uShaded;
+					}
+				}
+			}
+		}
+
+		for (float fDepth : arrDepth)
+		{
+			uCovered += (fDepth != INFINITY) ? 1 : 0;
+		}
+	}
+
+	return uCovered ? (float)uShaded / (float)uCovered : 0.0f;
+}
+
+
+MESHSTATS MeshOptimizer::Analyze(const uint32_t* pIndices, size_t uIndexCount,
+	const float* pVertices, size_t uVertexCount, uint32_t uVertexSize)
+{
+	MESHSTATS stats;
+	stats.fACMR = GetACMR(pIndices, uIndexCount, uVertexCount);
+	stats.fATVR = GetATVR(pIndices, uIndexCount, uVertexCount);
+	stats.fOverdraw = GetOverdraw(pIndices, uIndexCount, pVertices, uVertexCount, uVertexSize);
+	return stats;
+}
@@ -9,10 +9,16 @@
 **/
 
 #include "../include/OpenGLRenderer.h"
+#include "../include/PixelKernels.h"
+#include "../include/TextureCompression.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "../include/stb_image.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
 PFNGLBLENDEQUATIONSEPARATEPROC glBlendEquationSeparate = nullptr;
 PFNGLBLENDFUNCSEPARATEPROC glBlendFuncSeparate = nullptr;
 
@@ -67,6 +73,22 @@ PFNGLBUFFERDATAPROC	glBufferData = nullptr;
 PFNGLVERTEXATTRIBPOINTERPROC glVertexAttribPointer = nullptr;
 PFNGLVERTEXATTRIBIPOINTERPROC glVertexAttribIPointer = nullptr;
 
+// VAO
+PFNGLGENVERTEXARRAYSPROC glGenVertexArrays = nullptr;
+PFNGLDELETEVERTEXARRAYSPROC glDeleteVertexArrays = nullptr;
+PFNGLBINDVERTEXARRAYPROC glBindVertexArray = nullptr;
+
+// instancing
+PFNGLVERTEXATTRIBDIVISORPROC glVertexAttribDivisor = nullptr;
+PFNGLDRAWARRAYSINSTANCEDPROC glDrawArraysInstanced = nullptr;
+PFNGLDRAWELEMENTSINSTANCEDPROC glDrawElementsInstanced = nullptr;
+
+// uniform buffers
+PFNGLBUFFERSUBDATAPROC glBufferSubData = nullptr;
+PFNGLGETUNIFORMBLOCKINDEXPROC glGetUniformBlockIndex = nullptr;
+PFNGLUNIFORMBLOCKBINDINGPROC glUniformBlockBinding = nullptr;
+PFNGLBINDBUFFERRANGEPROC glBindBufferRange = nullptr;
+
 
 PFNGLGENFRAMEBUFFERSPROC glGenFramebuffers = nullptr;
 PFNGLGENRENDERBUFFERSPROC glGenRenderbuffers = nullptr;
@@ -96,9 +118,18 @@ PFNGLBLENDCOLORPROC glBlendColor = nullptr;
 #endif
 
 
+std::map<std::string, UniformId> COpenGLRenderer::s_mapUniformIds;
+
+
 COpenGLRenderer::COpenGLRenderer()
 {
 	m_Context = nullptr;
+	m_uStateCallsSaved = 0;
+	m_uTextureUnits = MAX_TEXTURE_UNITS;
+	m_fMaxAnisotropy = 1.0f;
+	m_bS3TC = false;
+	m_bHalfFloatVertex = false;
+	m_bPackedVertex = false;
 
 	#if defined (_WINDOWS)
 	m_hRC = nullptr;
@@ -234,6 +265,9 @@ void COpenGLRenderer::Flip()
 	glXSwapBuffers(display, wnd);
 #endif
 
+#ifdef _DEBUG
+	ValidateState();
+#endif
 }
 
 
@@ -254,8 +288,13 @@ void COpenGLRenderer::SetViewport(int32_t iX, int32_t iY, int32_t iWidth, int32_
 }
 
 
-GLuint COpenGLRenderer::CreateTexture(const std::string& strFilename)
+GLuint COpenGLRenderer::CreateTexture(const std::string& strFilename, const TEXTUREPARAMS& params)
 {
+	if (strFilename.size() > 4 && strFilename.compare(strFilename.size() - 4, 4, ".dds") == 0)
+	{
+		return CreateCompressedTexture(strFilename, params);
+	}
+
 	GLuint textureHandle = 0;
 
 	int textureWidth = 0;
@@ -269,51 +308,152 @@ GLuint COpenGLRenderer::CreateTexture(const std::string& strFilename)
 	}
 
 	// premultiply the alpha for faster blending
-	int i;
-	int imgdatabytes = textureWidth * textureHeight * 4;
-	for (i = 0; i < imgdatabytes; i += 4)
+	PixelKernels::PremultiplyAlpha(imgdata, (size_t)textureWidth * textureHeight);
+
+	glGenTextures(1, &textureHandle);
+
+	if (params.eMipmaps == MIPMAPS_BOX || params.eMipmaps == MIPMAPS_KAISER)
 	{
-		int alpha = imgdata[i + 3];
-		if (alpha != 255)
-		{
-			imgdata[i] = imgdata[i] * alpha / 255;
-			imgdata[i + 1] = imgdata[i + 1] * alpha / 255;
-			imgdata[i + 2] = imgdata[i + 2] * alpha / 255;
-		}
+		std::vector<unsigned char> arrLevels(imgdata, imgdata + (size_t)textureWidth * textureHeight * 4);
+		PixelKernels::BuildMipChain(arrLevels, textureWidth, textureHeight, (params.eMipmaps == MIPMAPS_BOX) ? MIPFILTER_BOX : MIPFILTER_KAISER);
+		UploadTexture(textureHandle, textureWidth, textureHeight, arrLevels.data(), params);
+	}
+	else
+	{
+		UploadTexture(textureHandle, textureWidth, textureHeight, imgdata, params);
 	}
 
-	GLint internalFormat = GL_RGBA;
-	GLenum format = GL_RGBA;
-	GLenum err = glGetError();
+	stbi_image_free(imgdata);
+
+	return textureHandle;
+}
 
+
+GLuint COpenGLRenderer::CreateCompressedTexture(const std::string& strFilename, const TEXTUREPARAMS& params)
+{
+	TextureCompression::IMAGE image;
+	if (!TextureCompression::LoadDDS(strFilename, image))
+	{
+		return 0;
+	}
+
+	GLuint textureHandle = 0;
 	glGenTextures(1, &textureHandle);
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, textureHandle);
+	if (!HasCompressedTextures())
+	{
+		// decode the blocks and upload as RGBA8
+		std::vector<unsigned char> arrPixels;
+		size_t uOffset = 0;
+		int32_t w = image.iWidth;
+		int32_t h = image.iHeight;
+		for (uint32_t i=0; i<image.uLevels; i++)
+		{
+			const size_t uPixelBytes = arrPixels.size();
+			arrPixels.resize(uPixelBytes + (size_t)w * h * 4);
+			TextureCompression::Decode(&image.arrData[uOffset], w, h, image.eFormat, &arrPixels[uPixelBytes]);
 
-	glTexImage2D(GL_TEXTURE_2D,
-		0,
-		internalFormat,
-		textureWidth,
-		textureHeight,
-		0,
-		format,
-		GL_UNSIGNED_BYTE,
-		imgdata);
+			uOffset += TextureCompression::GetLevelSize(image.eFormat, w, h);
+			w = std::max(w / 2, 1);
+			h = std::max(h / 2, 1);
+		}
 
-	delete[] imgdata;
+		// levels from the file are used as a cpu built chain when complete
+		TEXTUREPARAMS decodedParams = params;
+		if (image.uLevels == PixelKernels::GetMipLevelCount(image.iWidth, image.iHeight) && image.uLevels > 1)
+		{
+			decodedParams.eMipmaps = MIPMAPS_BOX;
+		}
+		else if (params.eMipmaps != MIPMAPS_NONE)
+		{
+			decodedParams.eMipmaps = MIPMAPS_GPU;
+		}
+		UploadTexture(textureHandle, image.iWidth, image.iHeight, arrPixels.data(), decodedParams);
+		return textureHandle;
+	}
 
-	err = glGetError();
+	// blocks are uploaded as is, mip levels come from the file
+	BindTexture(0, textureHandle);
+	const GLenum eInternalFormat = (image.eFormat == BLOCKFORMAT_BC1) ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	size_t uOffset = 0;
+	int32_t w = image.iWidth;
+	int32_t h = image.iHeight;
+	for (uint32_t i=0; i<image.uLevels; i++)
+	{
+		const size_t uLevelSize = TextureCompression::GetLevelSize(image.eFormat, w, h);
+		glCompressedTexImage2D(GL_TEXTURE_2D, i, eInternalFormat, w, h, 0, (GLsizei)uLevelSize, &image.arrData[uOffset]);
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		uOffset += uLevelSize;
+		w = std::max(w / 2, 1);
+		h = std::max(h / 2, 1);
+	}
 
+	SetTextureSampling(params, (int32_t)image.uLevels - 1);
 	return textureHandle;
 }
 
 
+void COpenGLRenderer::UploadTexture(GLuint uTexture, int32_t iWidth, int32_t iHeight, const unsigned char* pPixels, const TEXTUREPARAMS& params)
+{
+	BindTexture(0, uTexture);
+
+	const bool bCpuMipmaps = (params.eMipmaps == MIPMAPS_BOX || params.eMipmaps == MIPMAPS_KAISER);
+	const uint32_t uLevels = bCpuMipmaps ? PixelKernels::GetMipLevelCount(iWidth, iHeight) : 1;
+
+	size_t uOffset = 0;
+	int32_t w = iWidth;
+	int32_t h = iHeight;
+	for (uint32_t i=0; i<uLevels; i++)
+	{
+		glTexImage2D(GL_TEXTURE_2D,
+			i,
+			GL_RGBA,
+			w,
+			h,
+			0,
+			GL_RGBA,
+			GL_UNSIGNED_BYTE,
+			(const void*)((uintptr_t)pPixels + uOffset));		// pPixels is null when uploading from a pixel buffer
+
+		uOffset += (size_t)w * h * 4;
+		w = std::max(w / 2, 1);
+		h = std::max(h / 2, 1);
+	}
+
+	int32_t iMaxLevel = (int32_t)uLevels - 1;
+	if (params.eMipmaps == MIPMAPS_GPU && glGenerateMipmap)
+	{
+		glGenerateMipmap(GL_TEXTURE_2D);
+		iMaxLevel = (int32_t)PixelKernels::GetMipLevelCount(iWidth, iHeight) - 1;
+	}
+
+	SetTextureSampling(params, iMaxLevel);
+}
+
+
+void COpenGLRenderer::SetTextureSampling(const TEXTUREPARAMS& params, int32_t iMaxLevel)
+{
+	// mip filters sample only up to the max level, a texture without mipmaps
+	// stays complete with any filter
+	static const GLenum arrMinFilters[2][3] =
+	{
+		{ GL_NEAREST, GL_LINEAR, GL_LINEAR },
+		{ GL_NEAREST_MIPMAP_NEAREST, GL_LINEAR_MIPMAP_NEAREST, GL_LINEAR_MIPMAP_LINEAR }
+	};
+	const bool bMipmapped = iMaxLevel > 0;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, iMaxLevel);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, arrMinFilters[bMipmapped ? 1 : 0][params.eFilter]);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, (params.eFilter == FILTER_NEAREST) ? GL_NEAREST : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, params.eWrap);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, params.eWrap);
+
+	if (m_fMaxAnisotropy > 1.0f)
+	{
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, glm::clamp(params.fAnisotropy, 1.0f, m_fMaxAnisotropy));
+	}
+}
+
+
 GLuint COpenGLRenderer::CreateVertexShader(const char* pVertexShader)
 {
 	// compile vertex shader
@@ -343,7 +483,22 @@ GLuint COpenGLRenderer::CreateVertexShader(const char* pVertexShader)
 }
 
 
-GLuint COpenGLRenderer::CreateVertexShaderFromFile(const std::string& strFilename)
+// defines go after the #version line, which must come first in the source
+static std::string InsertDefines(const char* pSource, const std::string& strDefines)
+{
+	std::string strSource(pSource);
+	size_t uPos = 0;
+	if (strSource.compare(0, 8, "#version") == 0)
+	{
+		uPos = strSource.find('\n');
+		uPos = (uPos == std::string::npos) ? strSource.size() : uPos + 1;
+	}
+	strSource.insert(uPos, strDefines);
+	return strSource;
+}
+
+
+GLuint COpenGLRenderer::CreateVertexShaderFromFile(const std::string& strFilename, const std::string& strDefines)
 {
 	FILE* file = 0;
 	#if defined (_WINDOWS)
@@ -366,7 +521,8 @@ GLuint COpenGLRenderer::CreateVertexShaderFromFile(const std::string& strFilenam
 	fclose(file);
 
 	//IApplication::Debug(buffer);
-	GLuint shader = CreateVertexShader(buffer);
+	const std::string strSource = InsertDefines(buffer, strDefines);
+	GLuint shader = CreateVertexShader(strSource.c_str());
 	delete[] buffer;
 	return shader;
 }
@@ -401,7 +557,7 @@ GLuint COpenGLRenderer::CreateFragmentShader(const char* pFragmentShader)
 }
 
 
-GLuint COpenGLRenderer::CreateFragmentShaderFromFile(const std::string& strFilename)
+GLuint COpenGLRenderer::CreateFragmentShaderFromFile(const std::string& strFilename, const std::string& strDefines)
 {
 	FILE* file = 0;
 	#if defined (_WINDOWS)
@@ -423,7 +579,8 @@ GLuint COpenGLRenderer::CreateFragmentShaderFromFile(const std::string& strFilen
 	size_t s = fread(buffer, size, 1, file);
 	fclose(file);
 
-	GLuint shader = CreateFragmentShader(buffer);
+	const std::string strSource = InsertDefines(buffer, strDefines);
+	GLuint shader = CreateFragmentShader(strSource.c_str());
 	delete[] buffer;
 	return shader;
 }
@@ -447,11 +604,567 @@ GLuint COpenGLRenderer::CreateProgram(GLuint uVertexShader, GLuint uFragmentShad
 		glDeleteProgram(programHandle);
 		programHandle = 0;
 	}
+	else
+	{
+		ReflectProgram(programHandle);
+	}
 
 	return programHandle;
 }
 
 
+void COpenGLRenderer::ReflectProgram(GLuint uProgram)
+{
+	if (uProgram >= m_arrPrograms.size())
+	{
+		m_arrPrograms.resize(uProgram + 1);
+	}
+
+	// handle may be reused from a deleted program, start from scratch
+	PROGRAM& program = m_arrPrograms[uProgram];
+	program.arrUniforms.clear();
+
+	GLint uniformCount = 0;
+	GLint maxNameLength = 0;
+	glGetProgramiv(uProgram, GL_ACTIVE_UNIFORMS, &uniformCount);
+	glGetProgramiv(uProgram, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	std::vector<GLchar> name(maxNameLength + 1, 0);
+	for (GLint i = 0; i < uniformCount; i++)
+	{
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(uProgram, i, (GLsizei)name.size(), &length, &size, &type, name.data());
+
+		std::string strName(name.data(), length);
+
+		// arrays are reported with [0] suffix
+		const size_t bracket = strName.find('[');
+		if (bracket != std::string::npos)
+		{
+			strName.resize(bracket);
+		}
+
+		const UniformId id = GetUniformId(strName);
+		if (id >= program.arrUniforms.size())
+		{
+			program.arrUniforms.resize(id + 1);
+		}
+		program.arrUniforms[id].iLocation = glGetUniformLocation(uProgram, strName.c_str());
+	}
+}
+
+
+UniformId COpenGLRenderer::GetUniformId(const std::string& strName)
+{
+	auto it = s_mapUniformIds.find(strName);
+	if (it != s_mapUniformIds.end())
+	{
+		return it->second;
+	}
+
+	const UniformId id = (UniformId)s_mapUniformIds.size();
+	s_mapUniformIds[strName] = id;
+	return id;
+}
+
+
+GLint COpenGLRenderer::GetUniformLocation(GLuint uProgram, UniformId uId) const
+{
+	if (uProgram >= m_arrPrograms.size() ||
+		uId >= m_arrPrograms[uProgram].arrUniforms.size())
+	{
+		return -1;
+	}
+	return m_arrPrograms[uProgram].arrUniforms[uId].iLocation;
+}
+
+
+GLint COpenGLRenderer::GetChangedUniform(GLuint uProgram, UniformId uId, const void* pValue, size_t uSize)
+{
+	if (uProgram >= m_arrPrograms.size() ||
+		uId >= m_arrPrograms[uProgram].arrUniforms.size())
+	{
+		return -1;
+	}
+
+	UNIFORM& uniform = m_arrPrograms[uProgram].arrUniforms[uId];
+	if (uniform.iLocation == -1)
+	{
+		return -1;
+	}
+
+	// uniform values are program state, skip if the program already has the value
+	if (uniform.bHasValue && memcmp(uniform.arrValue, pValue, uSize) == 0)
+	{
+		return -1;
+	}
+
+	memcpy(uniform.arrValue, pValue, uSize);
+	uniform.bHasValue = true;
+	return uniform.iLocation;
+}
+
+
+void COpenGLRenderer::SetUniform(GLuint uProgram, UniformId uId, int32_t value)
+{
+	GLint location = GetChangedUniform(uProgram, uId, &value, sizeof(value));
+	if (location != -1)
+	{
+		glUniform1i(location, value);
+	}
+}
+
+
+void COpenGLRenderer::SetUniform(GLuint uProgram, UniformId uId, float value)
+{
+	GLint location = GetChangedUniform(uProgram, uId, &value, sizeof(value));
+	if (location != -1)
+	{
+		glUniform1f(location, value);
+	}
+}
+
+
+void COpenGLRenderer::SetUniform(GLuint uProgram, UniformId uId, const glm::vec2& value)
+{
+	GLint location = GetChangedUniform(uProgram, uId, &value[0], sizeof(value));
+	if (location != -1)
+	{
+		glUniform2fv(location, 1, &value[0]);
+	}
+}
+
+
+void COpenGLRenderer::SetUniform(GLuint uProgram, UniformId uId, const glm::vec3& value)
+{
+	GLint location = GetChangedUniform(uProgram, uId, &value[0], sizeof(value));
+	if (location != -1)
+	{
+		glUniform3fv(location, 1, &value[0]);
+	}
+}
+
+
+void COpenGLRenderer::SetUniform(GLuint uProgram, UniformId uId, const glm::vec4& value)
+{
+	GLint location = GetChangedUniform(uProgram, uId, &value[0], sizeof(value));
+	if (location != -1)
+	{
+		glUniform4fv(location, 1, &value[0]);
+	}
+}
+
+
+void COpenGLRenderer::SetUniform(GLuint uProgram, UniformId uId, const glm::mat3& value)
+{
+	GLint location = GetChangedUniform(uProgram, uId, &value[0][0], sizeof(value));
+	if (location != -1)
+	{
+		glUniformMatrix3fv(location, 1, GL_FALSE, &value[0][0]);
+	}
+}
+
+
+void COpenGLRenderer::SetUniform(GLuint uProgram, UniformId uId, const glm::mat4& value)
+{
+	GLint location = GetChangedUniform(uProgram, uId, &value[0][0], sizeof(value));
+	if (location != -1)
+	{
+		glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
+	}
+}
+
+
+void COpenGLRenderer::UseProgram(GLuint uProgram)
+{
+	if (m_State.uProgram == uProgram)
+	{
+		++m_uStateCallsSaved;
+		return;
+	}
+	glUseProgram(uProgram);
+	m_State.uProgram = uProgram;
+}
+
+
+void COpenGLRenderer::BindTexture(uint32_t uUnit, GLuint uTexture)
+{
+	if (m_State.uActiveTexture != uUnit)
+	{
+		glActiveTexture(GL_TEXTURE0 + uUnit);
+		m_State.uActiveTexture = uUnit;
+	}
+	else
+	{
+		++m_uStateCallsSaved;
+	}
+
+	if (uUnit >= m_uTextureUnits)
+	{
+		glBindTexture(GL_TEXTURE_2D, uTexture);
+		return;
+	}
+
+	if (m_State.arrTextures[uUnit] == uTexture)
+	{
+		++m_uStateCallsSaved;
+		return;
+	}
+	glBindTexture(GL_TEXTURE_2D, uTexture);
+	m_State.arrTextures[uUnit] = uTexture;
+}
+
+
+void COpenGLRenderer::BindBuffer(GLenum eTarget, GLuint uBuffer)
+{
+	GLuint* pBinding = nullptr;
+	if (eTarget == GL_ARRAY_BUFFER)
+	{
+		pBinding = &m_State.uArrayBuffer;
+	}
+	else if (eTarget == GL_ELEMENT_ARRAY_BUFFER && m_State.uVertexArray == 0)
+	{
+		pBinding = &m_State.uElementArrayBuffer;
+	}
+	else if (eTarget == GL_UNIFORM_BUFFER)
+	{
+		pBinding = &m_State.uUniformBuffer;
+	}
+
+	if (pBinding && *pBinding == uBuffer)
+	{
+		++m_uStateCallsSaved;
+		return;
+	}
+	glBindBuffer(eTarget, uBuffer);
+	if (pBinding)
+	{
+		*pBinding = uBuffer;
+	}
+}
+
+
+void COpenGLRenderer::BindUniformBuffer(uint32_t uIndex, GLuint uBuffer, GLintptr iOffset, GLsizeiptr iSize)
+{
+	UNIFORMBUFFER& binding = m_State.arrUniformBuffers[uIndex];
+	if (binding.uBuffer == uBuffer && binding.iOffset == iOffset && binding.iSize == iSize)
+	{
+		++m_uStateCallsSaved;
+		return;
+	}
+	glBindBufferRange(GL_UNIFORM_BUFFER, uIndex, uBuffer, iOffset, iSize);
+	m_State.uUniformBuffer = uBuffer;
+	binding.uBuffer = uBuffer;
+	binding.iOffset = iOffset;
+	binding.iSize = iSize;
+}
+
+
+void COpenGLRenderer::BindVertexArray(GLuint uVertexArray)
+{
+	if (m_State.uVertexArray == uVertexArray)
+	{
+		++m_uStateCallsSaved;
+		return;
+	}
+	glBindVertexArray(uVertexArray);
+	m_State.uVertexArray = uVertexArray;
+}
+
+
+void COpenGLRenderer::BindFramebuffer(GLuint uFrameBuffer)
+{
+	if (m_State.uFrameBuffer == uFrameBuffer)
+	{
+		++m_uStateCallsSaved;
+		return;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, uFrameBuffer);
+	m_State.uFrameBuffer = uFrameBuffer;
+}
+
+
+void COpenGLRenderer::SetBlend(bool bEnable)
+{
+	if (m_State.bBlend == bEnable)
+	{
+		++m_uStateCallsSaved;
+		return;
+	}
+	bEnable ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+	m_State.bBlend = bEnable;
+}
+
+
+void COpenGLRenderer::SetBlendFunc(GLenum eSrcFactor, GLenum eDstFactor)
+{
+	if (m_State.eBlendSrc == eSrcFactor && m_State.eBlendDst == eDstFactor)
+	{
+		++m_uStateCallsSaved;
+		return;
+	}
+	glBlendFunc(eSrcFactor, eDstFactor);
+	m_State.eBlendSrc = eSrcFactor;
+	m_State.eBlendDst = eDstFactor;
+}
+
+
+void COpenGLRenderer::SetDepthTest(bool bEnable)
+{
+	if (m_State.bDepthTest == bEnable)
+	{
+		++m_uStateCallsSaved;
+		return;
+	}
+	bEnable ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+	m_State.bDepthTest = bEnable;
+}
+
+
+void COpenGLRenderer::SetDepthMask(bool bEnable)
+{
+	if (m_State.bDepthMask == bEnable)
+	{
+		++m_uStateCallsSaved;
+		return;
+	}
+	glDepthMask(bEnable ? GL_TRUE : GL_FALSE);
+	m_State.bDepthMask = bEnable;
+}
+
+
+void COpenGLRenderer::SetDepthFunc(GLenum eFunc)
+{
+	if (m_State.eDepthFunc == eFunc)
+	{
+		++m_uStateCallsSaved;
+		return;
+	}
+	glDepthFunc(eFunc);
+	m_State.eDepthFunc = eFunc;
+}
+
+
+void COpenGLRenderer::SetCulling(bool bEnable)
+{
+	if (m_State.bCulling == bEnable)
+	{
+		++m_uStateCallsSaved;
+		return;
+	}
+	bEnable ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE);
+	m_State.bCulling = bEnable;
+}
+
+
+void COpenGLRenderer::SetCullFace(GLenum eFace)
+{
+	if (m_State.eCullFace == eFace)
+	{
+		++m_uStateCallsSaved;
+		return;
+	}
+	glCullFace(eFace);
+	m_State.eCullFace = eFace;
+}
+
+
+void COpenGLRenderer::SetColorMask(bool bRed, bool bGreen, bool bBlue, bool bAlpha)
+{
+	bool* mask = m_State.arrColorMask;
+	if (mask[0] == bRed && mask[1] == bGreen && mask[2] == bBlue && mask[3] == bAlpha)
+	{
+		++m_uStateCallsSaved;
+		return;
+	}
+	glColorMask(bRed, bGreen, bBlue, bAlpha);
+	mask[0] = bRed;
+	mask[1] = bGreen;
+	mask[2] = bBlue;
+	mask[3] = bAlpha;
+}
+
+
+void COpenGLRenderer::DeleteTexture(GLuint uTexture)
+{
+	for (uint32_t i = 0; i < MAX_TEXTURE_UNITS; i++)
+	{
+		if (m_State.arrTextures[i] == uTexture)
+		{
+			m_State.arrTextures[i] = 0;
+		}
+	}
+	glDeleteTextures(1, &uTexture);
+}
+
+
+void COpenGLRenderer::DeleteBuffer(GLuint uBuffer)
+{
+	if (m_State.uArrayBuffer == uBuffer)
+	{
+		m_State.uArrayBuffer = 0;
+	}
+	if (m_State.uElementArrayBuffer == uBuffer)
+	{
+		m_State.uElementArrayBuffer = 0;
+	}
+	if (m_State.uUniformBuffer == uBuffer)
+	{
+		m_State.uUniformBuffer = 0;
+	}
+	for (uint32_t i = 0; i < MAX_UNIFORM_BUFFERS; i++)
+	{
+		if (m_State.arrUniformBuffers[i].uBuffer == uBuffer)
+		{
+			m_State.arrUniformBuffers[i] = UNIFORMBUFFER();
+		}
+	}
+	glDeleteBuffers(1, &uBuffer);
+}
+
+
+void COpenGLRenderer::DeleteVertexArray(GLuint uVertexArray)
+{
+	if (m_State.uVertexArray == uVertexArray)
+	{
+		m_State.uVertexArray = 0;
+	}
+	glDeleteVertexArrays(1, &uVertexArray);
+}
+
+
+void COpenGLRenderer::DeleteProgram(GLuint uProgram)
+{
+	// program in use would stay alive until another program is set
+	if (m_State.uProgram == uProgram)
+	{
+		glUseProgram(0);
+		m_State.uProgram = 0;
+	}
+	glDeleteProgram(uProgram);
+}
+
+
+void COpenGLRenderer::ResetState()
+{
+	glUseProgram(m_State.uProgram);
+
+	for (uint32_t i = 0; i < m_uTextureUnits; i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_2D, m_State.arrTextures[i]);
+	}
+	glActiveTexture(GL_TEXTURE0 + m_State.uActiveTexture);
+
+	glBindVertexArray(m_State.uVertexArray);
+	glBindBuffer(GL_ARRAY_BUFFER, m_State.uArrayBuffer);
+	if (m_State.uVertexArray == 0)
+	{
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_State.uElementArrayBuffer);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, m_State.uFrameBuffer);
+
+	for (uint32_t i = 0; i < MAX_UNIFORM_BUFFERS; i++)
+	{
+		const UNIFORMBUFFER& binding = m_State.arrUniformBuffers[i];
+		if (binding.uBuffer)
+		{
+			glBindBufferRange(GL_UNIFORM_BUFFER, i, binding.uBuffer, binding.iOffset, binding.iSize);
+		}
+	}
+	if (HasUniformBuffers())
+	{
+		// the ranges above changed the generic binding too
+		glBindBuffer(GL_UNIFORM_BUFFER, m_State.uUniformBuffer);
+	}
+
+	m_State.bBlend ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+	glBlendFunc(m_State.eBlendSrc, m_State.eBlendDst);
+	m_State.bDepthTest ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+	glDepthMask(m_State.bDepthMask ? GL_TRUE : GL_FALSE);
+	glDepthFunc(m_State.eDepthFunc);
+	m_State.bCulling ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE);
+	glCullFace(m_State.eCullFace);
+
+	const bool* mask = m_State.arrColorMask;
+	glColorMask(mask[0], mask[1], mask[2], mask[3]);
+}
+
+
+bool COpenGLRenderer::ValidateState()
+{
+	bool valid = true;
+	auto check = [&valid](const char* pName, GLint iShadow, GLint iActual)
+	{
+		if (iShadow != iActual)
+		{
+			IApplication::Debug(std::string("OpenGLRenderer: state mismatch ") + pName +
+				" shadow " + std::to_string(iShadow) + " actual " + std::to_string(iActual) + "\n");
+			valid = false;
+		}
+	};
+
+	GLint value = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &value);
+	check("program", (GLint)m_State.uProgram, value);
+
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &value);
+	check("active texture", (GLint)(GL_TEXTURE0 + m_State.uActiveTexture), value);
+
+	for (uint32_t i = 0; i < m_uTextureUnits; i++)
+	{
+		glActiveTexture(GL_TEXTURE0 + i);
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &value);
+		check("texture unit", (GLint)m_State.arrTextures[i], value);
+	}
+	glActiveTexture(GL_TEXTURE0 + m_State.uActiveTexture);
+
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &value);
+	check("vertex array", (GLint)m_State.uVertexArray, value);
+	glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &value);
+	check("array buffer", (GLint)m_State.uArrayBuffer, value);
+	if (m_State.uVertexArray == 0)
+	{
+		glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &value);
+		check("element array buffer", (GLint)m_State.uElementArrayBuffer, value);
+	}
+	if (HasUniformBuffers())
+	{
+		glGetIntegerv(GL_UNIFORM_BUFFER_BINDING, &value);
+		check("uniform buffer", (GLint)m_State.uUniformBuffer, value);
+	}
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &value);
+	check("framebuffer", (GLint)m_State.uFrameBuffer, value);
+
+	check("blend", m_State.bBlend, glIsEnabled(GL_BLEND));
+	glGetIntegerv(GL_BLEND_SRC_RGB, &value);
+	check("blend src", (GLint)m_State.eBlendSrc, value);
+	glGetIntegerv(GL_BLEND_DST_RGB, &value);
+	check("blend dst", (GLint)m_State.eBlendDst, value);
+
+	check("depth test", m_State.bDepthTest, glIsEnabled(GL_DEPTH_TEST));
+	GLboolean mask[4] = {};
+	glGetBooleanv(GL_DEPTH_WRITEMASK, mask);
+	check("depth mask", m_State.bDepthMask, mask[0]);
+	glGetIntegerv(GL_DEPTH_FUNC, &value);
+	check("depth func", (GLint)m_State.eDepthFunc, value);
+
+	check("culling", m_State.bCulling, glIsEnabled(GL_CULL_FACE));
+	glGetIntegerv(GL_CULL_FACE_MODE, &value);
+	check("cull face", (GLint)m_State.eCullFace, value);
+
+	glGetBooleanv(GL_COLOR_WRITEMASK, mask);
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		check("color mask", m_State.arrColorMask[i], mask[i]);
+	}
+
+	return valid;
+}
+
+
 void COpenGLRenderer::PrintShaderError(GLuint uShader)
 {
 	GLint infologLength;
@@ -497,16 +1210,9 @@ bool COpenGLRenderer::SetDefaultSettings()
 	glStencilMask(0);
 	glDisable(GL_SCISSOR_TEST);
 
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
 	glPixelStorei(GL_PACK_ALIGNMENT, 1);
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_DEPTH_FUNC);
-	glDepthMask(GL_TRUE);
-	glDepthFunc(GL_LEQUAL);
 	//glDepthRangef(0.0f, 1.0f);
 	glDisable(GL_STENCIL_TEST);
 
@@ -517,9 +1223,35 @@ bool COpenGLRenderer::SetDefaultSettings()
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 	glBlendColor(1.0f, 1.0f, 1.0f, 1.0f);
 
-	glEnable(GL_CULL_FACE);
 	glFrontFace(GL_CW);
-	glCullFace(GL_CCW);
+
+	// set the shadowed state: no buffers bound, depth test with less or equal,
+	// back face culling, blending off
+	GLint textureUnits = 0;
+	glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &textureUnits);
+	m_uTextureUnits = glm::clamp<uint32_t>((uint32_t)textureUnits, 1, MAX_TEXTURE_UNITS);
+
+	m_fMaxAnisotropy = 1.0f;
+	const char* pExtensions = (const char*)glGetString(GL_EXTENSIONS);
+	if (pExtensions && strstr(pExtensions, "GL_EXT_texture_filter_anisotropic"))
+	{
+		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &m_fMaxAnisotropy);
+	}
+	// InitFunctions has already cleared the flag if the upload entry point is missing
+	m_bS3TC = m_bS3TC && pExtensions && strstr(pExtensions, "GL_EXT_texture_compression_s3tc");
+
+	// both vertex types are core since 3.0 and 3.3
+	int32_t iMajor = 0, iMinor = 0;
+	const char* pVersion = (const char*)glGetString(GL_VERSION);
+	if (pVersion)
+	{
+		sscanf(pVersion, "%d.%d", &iMajor, &iMinor);
+	}
+	m_bHalfFloatVertex = (iMajor >= 3) || (pExtensions && strstr(pExtensions, "GL_ARB_half_float_vertex"));
+	m_bPackedVertex = (iMajor > 3 || (iMajor == 3 && iMinor >= 3)) || (pExtensions && strstr(pExtensions, "GL_ARB_vertex_type_2_10_10_10_rev"));
+
+	m_State = RENDERSTATE();
+	ResetState();
 
 	return true;
 }
@@ -541,7 +1273,10 @@ bool COpenGLRenderer::InitFunctions()
 	glActiveTexture = (PFNGLACTIVETEXTUREPROC)GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glActiveTexture");
 	glCompressedTexImage2D		= (PFNGLCOMPRESSEDTEXIMAGE2D		) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glCompressedTexImage2D");
 	glBlendColor			= (PFNGLBLENDCOLORPROC)GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glBlendColor");
-
+	m_bS3TC = (glCompressedTexImage2D != nullptr);
+	#else
+	// linked directly from libGL
+	m_bS3TC = true;
 	#endif
 
 	glBlendEquationSeparate = (PFNGLBLENDEQUATIONSEPARATEPROC)GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glBlendEquationSeparate");
@@ -602,6 +1337,22 @@ bool COpenGLRenderer::InitFunctions()
 	glVertexAttribPointer = (PFNGLVERTEXATTRIBPOINTERPROC)GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glVertexAttribPointer");
 	glVertexAttribIPointer = (PFNGLVERTEXATTRIBIPOINTERPROC)GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glVertexAttribIPointer");
 
+	// VAO
+	glGenVertexArrays = (PFNGLGENVERTEXARRAYSPROC)GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glGenVertexArrays");
+	glDeleteVertexArrays = (PFNGLDELETEVERTEXARRAYSPROC)GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glDeleteVertexArrays");
+	glBindVertexArray = (PFNGLBINDVERTEXARRAYPROC)GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glBindVertexArray");
+
+	// instancing
+	glVertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISORPROC)GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glVertexAttribDivisor");
+	glDrawArraysInstanced = (PFNGLDRAWARRAYSINSTANCEDPROC)GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glDrawArraysInstanced");
+	glDrawElementsInstanced = (PFNGLDRAWELEMENTSINSTANCEDPROC)GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glDrawElementsInstanced");
+
+	// uniform buffers
+	glBufferSubData = (PFNGLBUFFERSUBDATAPROC)GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glBufferSubData");
+	glGetUniformBlockIndex = (PFNGLGETUNIFORMBLOCKINDEXPROC)GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glGetUniformBlockIndex");
+	glUniformBlockBinding = (PFNGLUNIFORMBLOCKBINDINGPROC)GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glUniformBlockBinding");
+	glBindBufferRange = (PFNGLBINDBUFFERRANGEPROC)GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glBindBufferRange");
+
 
 	glGenFramebuffers			= (PFNGLGENFRAMEBUFFERSPROC			) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glGenFramebuffers");
 	glGenRenderbuffers			= (PFNGLGENRENDERBUFFERSPROC		) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glGenRenderbuffers");
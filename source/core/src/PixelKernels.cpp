@@ -0,0 +1,388 @@
+/**
+ * ============================================================================
+ *  Name        : PixelKernels.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : image pixel conversion kernels, with SSE2 and AVX2 paths
+ *                selected at runtime
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#include "../include/PixelKernels.h"
+#include "../include/JobSystem.h"
+#include <algorithm>
+#include <cmath>
+
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+#define PIXEL_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(_MSC_VER)
+#define PIXEL_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(PIXEL_AVX2) && defined(__GNUC__)
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#else
+#define AVX2_FUNCTION
+#endif
+
+// images smaller than this are not worth splitting across threads
+static const size_t PARALLEL_PIXELS = 256 * 1024;
+static const uint32_t PIXELS_PER_JOB = 64 * 1024;
+
+SIMDLEVEL PixelKernels::s_eLevel = TransformKernels::GetBestLevel();
+
+
+SIMDLEVEL PixelKernels::GetLevel()
+{
+	return s_eLevel;
+}
+
+
+void PixelKernels::SetLevel(SIMDLEVEL eLevel)
+{
+	const SIMDLEVEL eBest = TransformKernels::GetBestLevel();
+	s_eLevel = (eLevel > eBest) ? eBest : eLevel;
+}
+
+
+const char* PixelKernels::GetLevelName()
+{
+	switch (s_eLevel)
+	{
+	case SIMD_SSE2: return "SSE2";
+	case SIMD_AVX2: return "AVX2";
+	default: return "scalar";
+	}
+}
+
+
+//
+// scalar kernel, also handles the tails of the simd kernels
+//
+
+static void PremultiplyScalar(unsigned char* pPixels, size_t uBegin, size_t uEnd)
+{
+	for (size_t i = uBegin * 4; i < uEnd * 4; i += 4)
+	{
+		int alpha = pPixels[i + 3];
+		if (alpha != 255)
+		{
+			pPixels[i] = pPixels[i] * alpha / 255;
+			pPixels[i + 1] = pPixels[i + 1] * alpha / 255;
+			pPixels[i + 2] = pPixels[i + 2] * alpha / 255;
+		}
+	}
+}
+
+
+#if defined(PIXEL_SSE2)
+
+//
+// simd kernels work on 16 bit lanes, t / 255 rounded down for t = c * a is
+// (t + 1 + (t >> 8)) >> 8, exact for all 8 bit c and a
+//
+
+static void PremultiplySSE2(unsigned char* pPixels, size_t uCount)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi16(1);
+
+	// alpha lane is multiplied with 255 so that it stays as is
+	const __m128i alphaLanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+	const __m128i alpha255 = _mm_and_si128(alphaLanes, _mm_set1_epi16(255));
+
+	size_t i = 0;
+	for (; i + 4 <= uCount; i += 4)
+	{
+		__m128i* pData = (__m128i*)(pPixels + i * 4);
+		const __m128i pixels = _mm_loadu_si128(pData);
+
+		__m128i halves[2] = { _mm_unpacklo_epi8(pixels, zero), _mm_unpackhi_epi8(pixels, zero) };
+		for (uint32_t h = 0; h < 2; h++)
+		{
+			// broadcast the alpha of both pixels over their four lanes
+			__m128i alpha = _mm_shufflelo_epi16(halves[h], _MM_SHUFFLE(3, 3, 3, 3));
+			alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+			alpha = _mm_or_si128(_mm_andnot_si128(alphaLanes, alpha), alpha255);
+
+			const __m128i t = _mm_mullo_epi16(halves[h], alpha);
+			halves[h] = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(t, one), _mm_srli_epi16(t, 8)), 8);
+		}
+
+		_mm_storeu_si128(pData, _mm_packus_epi16(halves[0], halves[1]));
+	}
+	PremultiplyScalar(pPixels, i, uCount);
+}
+
+#endif
+
+
+#if defined(PIXEL_AVX2)
+
+AVX2_FUNCTION static void PremultiplyAVX2(unsigned char* pPixels, size_t uCount)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i one = _mm256_set1_epi16(1);
+	const __m256i alphaLanes = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0);
+	const __m256i alpha255 = _mm256_and_si256(alphaLanes, _mm256_set1_epi16(255));
+
+	// unpack and pack work within 128 bit halves, so the pixel order is kept
+	size_t i = 0;
+	for (; i + 8 <= uCount; i += 8)
+	{
+		__m256i* pData = (__m256i*)(pPixels + i * 4);
+		const __m256i pixels = _mm256_loadu_si256(pData);
+
+		__m256i halves[2] = { _mm256_unpacklo_epi8(pixels, zero), _mm256_unpackhi_epi8(pixels, zero) };
+		for (uint32_t h = 0; h < 2; h++)
+		{
+			__m256i alpha = _mm256_shufflelo_epi16(halves[h], _MM_SHUFFLE(3, 3, 3, 3));
+			alpha = _mm256_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+			alpha = _mm256_or_si256(_mm256_andnot_si256(alphaLanes, alpha), alpha255);
+
+			const __m256i t = _mm256_mullo_epi16(halves[h], alpha);
+			halves[h] = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(t, one), _mm256_srli_epi16(t, 8)), 8);
+		}
+
+		_mm256_storeu_si256(pData, _mm256_packus_epi16(halves[0], halves[1]));
+	}
+	PremultiplyScalar(pPixels, i, uCount);
+}
+
+#endif
+
+
+void PixelKernels::PremultiplyRange(unsigned char* pPixels, size_t uPixelCount)
+{
+	switch (s_eLevel)
+	{
+#if defined(PIXEL_AVX2)
+	case SIMD_AVX2:
+		PremultiplyAVX2(pPixels, uPixelCount);
+		break;
+#endif
+#if defined(PIXEL_SSE2)
+	case SIMD_SSE2:
+		PremultiplySSE2(pPixels, uPixelCount);
+		break;
+#endif
+	default:
+		PremultiplyScalar(pPixels, 0, uPixelCount);
+		break;
+	}
+}
+
+
+void PixelKernels::PremultiplyAlpha(unsigned char* pPixels, size_t uPixelCount, JobSystem* pJobs)
+{
+	if (!pJobs || uPixelCount < PARALLEL_PIXELS || uPixelCount > 0xffffffff)
+	{
+		PremultiplyRange(pPixels, uPixelCount);
+		return;
+	}
+
+	// pixels are independent, any split works
+	pJobs->ParallelFor((uint32_t)uPixelCount, PIXELS_PER_JOB, [pPixels](uint32_t uBegin, uint32_t uEnd)
+	{
+		PremultiplyRange(pPixels + (size_t)uBegin * 4, uEnd - uBegin);
+	});
+}
+
+
+uint32_t PixelKernels::GetMipLevelCount(int32_t iWidth, int32_t iHeight)
+{
+	uint32_t uLevels = 1;
+	int32_t iSize = std::max(iWidth, iHeight);
+	while (iSize > 1)
+	{
+		iSize /= 2;
+		++uLevels;
+	}
+	return uLevels;
+}
+
+
+void PixelKernels::BuildMipChain(std::vector<unsigned char>& arrPixels, int32_t iWidth, int32_t iHeight, MIPFILTER eFilter)
+{
+	const uint32_t uLevels = GetMipLevelCount(iWidth, iHeight);
+
+	size_t uTotal = 0;
+	int32_t w = iWidth;
+	int32_t h = iHeight;
+	for (uint32_t i=0; i<uLevels; i++)
+	{
+		uTotal += (size_t)w * h * 4;
+		w = std::max(w / 2, 1);
+		h = std::max(h / 2, 1);
+	}
+	arrPixels.resize(uTotal);
+
+	// each level is filtered from the previous one
+	size_t uOffset = 0;
+	w = iWidth;
+	h = iHeight;
+	for (uint32_t i=1; i<uLevels; i++)
+	{
+		const int32_t dw = std::max(w / 2, 1);
+		const int32_t dh = std::max(h / 2, 1);
+		const size_t uDest = uOffset + (size_t)w * h * 4;
+		Downsample(&arrPixels[uOffset], w, h, &arrPixels[uDest], dw, dh, eFilter);
+		uOffset = uDest;
+		w = dw;
+		h = dh;
+	}
+}
+
+
+//
+// separable resampling, the weights of each destination pixel are computed
+// once per row and column
+//
+
+struct FILTERTAPS
+{
+	int32_t				iFirst = 0;
+	std::vector<float>	arrWeights;
+};
+
+static float Sinc(float x)
+{
+	if (std::fabs(x) < 1e-5f)
+	{
+		return 1.0f;
+	}
+	x *= 3.14159265f;
+	return std::sin(x) / x;
+}
+
+// zeroth order modified bessel function of the first kind
+static float BesselI0(float x)
+{
+	float fSum = 1.0f;
+	float fTerm = 1.0f;
+	for (int32_t k = 1; k < 16; k++)
+	{
+		fTerm *= (x * 0.5f) / (float)k;
+		fSum += fTerm * fTerm;
+	}
+	return fSum;
+}
+
+static void GetFilterTaps(int32_t iSource, int32_t iDest, MIPFILTER eFilter, std::vector<FILTERTAPS>& arrTaps)
+{
+	// kaiser window reaches two destination pixels each way, alpha 4
+	static const float fKaiserRadius = 2.0f;
+	static const float fKaiserAlpha = 4.0f;
+	const float fKaiserNorm = 1.0f / BesselI0(fKaiserAlpha);
+
+	const float fScale = (float)iSource / (float)iDest;
+	const float fRadius = (eFilter == MIPFILTER_BOX) ? fScale * 0.5f : fScale * fKaiserRadius;
+
+	arrTaps.resize(iDest);
+	for (int32_t i = 0; i < iDest; i++)
+	{
+		// source position of the destination pixel center
+		const float fCenter = ((float)i + 0.5f) * fScale;
+		const int32_t iFirst = (int32_t)std::floor(fCenter - fRadius);
+		const int32_t iLast = (int32_t)std::ceil(fCenter + fRadius);
+
+		FILTERTAPS& taps = arrTaps[i];
+		taps.iFirst = iFirst;
+		taps.arrWeights.clear();
+
+		float fSum = 0.0f;
+		for (int32_t s = iFirst; s < iLast; s++)
+		{
+			float fWeight = 0.0f;
+			if (eFilter == MIPFILTER_BOX)
+			{
+				// coverage of the source pixel
+				fWeight = std::max(std::min((float)s + 1.0f, fCenter + fRadius) - std::max((float)s, fCenter - fRadius), 0.0f);
+			}
+			else
+			{
+				// in destination pixels
+				const float x = ((float)s + 0.5f - fCenter) / fScale;
+				const float t = x / fKaiserRadius;
+				if (t > -1.0f && t < 1.0f)
+				{
+					fWeight = Sinc(x) * BesselI0(fKaiserAlpha * std::sqrt(1.0f - t * t)) * fKaiserNorm;
+				}
+			}
+			taps.arrWeights.push_back(fWeight);
+			fSum += fWeight;
+		}
+
+		for (uint32_t w=0; w<taps.arrWeights.size(); w++)
+		{
+			taps.arrWeights[w] /= fSum;
+		}
+	}
+}
+
+
+void PixelKernels::Downsample(const unsigned char* pSource, int32_t iWidth, int32_t iHeight,
+	unsigned char* pDest, int32_t iDestWidth, int32_t iDestHeight, MIPFILTER eFilter)
+{
+	std::vector<FILTERTAPS> arrColumns;
+	std::vector<FILTERTAPS> arrRows;
+	GetFilterTaps(iWidth, iDestWidth, eFilter, arrColumns);
+	GetFilterTaps(iHeight, iDestHeight, eFilter, arrRows);
+
+	// horizontal pass keeps full precision
+	std::vector<float> arrTemp((size_t)iDestWidth * iHeight * 4);
+	for (int32_t y = 0; y < iHeight; y++)
+	{
+		const unsigned char* pRow = pSource + (size_t)y * iWidth * 4;
+		float* pOut = &arrTemp[(size_t)y * iDestWidth * 4];
+		for (int32_t x = 0; x < iDestWidth; x++)
+		{
+			const FILTERTAPS& taps = arrColumns[x];
+			float arrSum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			for (uint32_t t=0; t<taps.arrWeights.size(); t++)
+			{
+				const int32_t s = std::min(std::max(taps.iFirst + (int32_t)t, 0), iWidth - 1);
+				for (uint32_t c=0; c<4; c++)
+				{
+					arrSum[c] += taps.arrWeights[t] * (float)pRow[s * 4 + c];
+				}
+			}
+			for (uint32_t c=0; c<4; c++)
+			{
+				pOut[x * 4 + c] = arrSum[c];
+			}
+		}
+	}
+
+	// vertical pass, negative lobes of the sinc can overshoot. Premultiplied
+	// color must not exceed its alpha.
+	for (int32_t y = 0; y < iDestHeight; y++)
+	{
+		const FILTERTAPS& taps = arrRows[y];
+		unsigned char* pOut = pDest + (size_t)y * iDestWidth * 4;
+		for (int32_t x = 0; x < iDestWidth; x++)
+		{
+			float arrSum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			for (uint32_t t=0; t<taps.arrWeights.size(); t++)
+			{
+				const int32_t s = std::min(std::max(taps.iFirst + (int32_t)t, 0), iHeight - 1);
+				const float* pIn = &arrTemp[((size_t)s * iDestWidth + x) * 4];
+				for (uint32_t c=0; c<4; c++)
+				{
+					arrSum[c] += taps.arrWeights[t] * pIn[c];
+				}
+			}
+
+			const float fAlpha = std::min(std::max(arrSum[3] + 0.5f, 0.0f), 255.0f);
+			for (uint32_t c=0; c<3; c++)
+			{
+				pOut[x * 4 + c] = (unsigned char)std::min(std::max(arrSum[c] + 0.5f, 0.0f), fAlpha);
+			}
+			pOut[x * 4 + 3] = (unsigned char)fAlpha;
+		}
+	}
+}
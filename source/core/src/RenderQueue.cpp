@@ -0,0 +1,236 @@
+/**
+ * ============================================================================
+ *  Name        : RenderQueue.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : collects draw packets from the scenegraph and submits them
+ *                sorted by render state
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#include "../include/RenderQueue.h"
+
+
+RenderQueue::RenderQueue()
+{
+	m_uUnsortedStateChanges = 0;
+	m_uSortedStateChanges = 0;
+}
+
+
+RenderQueue::~RenderQueue()
+{
+}
+
+
+void RenderQueue::Add(GLuint uProgram, const TEXTURESET* pTextures, Material* pMaterial, const Geometry* pGeometry, const glm::mat4& mWorld)
+{
+	DRAWPACKET packet;
+	packet.uProgram = uProgram;
+	packet.pTextures = pTextures;
+	packet.pMaterial = pMaterial;
+	packet.pGeometry = pGeometry;
+	packet.mWorld = mWorld;
+
+	// most expensive state change in the highest bits:
+	// program | texture set | material | geometry, 16 bits each
+	packet.uSortKey =
+		(GetKeyIndex(m_mapProgramIds, uProgram) << 48) |
+		(GetKeyIndex(m_mapTextureSetIds, (uintptr_t)pTextures) << 32) |
+		(GetKeyIndex(m_mapMaterialIds, (uintptr_t)pMaterial) << 16) |
+		GetKeyIndex(m_mapGeometryIds, (uintptr_t)pGeometry);
+
+	m_arrPackets.push_back(packet);
+}
+
+
+void RenderQueue::Sort()
+{
+	const uint32_t count = (uint32_t)m_arrPackets.size();
+
+	// state changes in traversal order, for comparison
+	STATE state;
+	m_uUnsortedStateChanges = 0;
+	for (uint32_t i=0; i<count; i++)
+	{
+		m_uUnsortedStateChanges += CountStateChanges(state, m_arrPackets[i]);
+	}
+
+	m_arrOrder.resize(count);
+	m_arrTemp.resize(count);
+	for (uint32_t i=0; i<count; i++)
+	{
+		m_arrOrder[i] = i;
+	}
+
+	// least significant digit radix sort, one byte per pass
+	for (uint32_t shift=0; shift<64; shift+=8)
+	{
+		uint32_t histogram[257] = {};
+		for (uint32_t i=0; i<count; i++)
+		{
+			++histogram[((m_arrPackets[i].uSortKey >> shift) & 0xff) + 1];
+		}
+
+		// skip the pass if every key has the same byte
+		if (count && histogram[((m_arrPackets[0].uSortKey >> shift) & 0xff) + 1] == count)
+		{
+			continue;
+		}
+
+		for (uint32_t i=1; i<257; i++)
+		{
+			histogram[i] += histogram[i - 1];
+		}
+
+		for (uint32_t i=0; i<count; i++)
+		{
+			const uint32_t index = m_arrOrder[i];
+			m_arrTemp[histogram[(m_arrPackets[index].uSortKey >> shift) & 0xff]++] = index;
+		}
+		m_arrOrder.swap(m_arrTemp);
+	}
+}
+
+
+void RenderQueue::Submit(COpenGLRenderer* pRenderer)
+{
+	static const UniformId modelMatrixId = COpenGLRenderer::GetUniformId("modelMatrix");
+	static const UniformId modelViewProjectionMatrixId = COpenGLRenderer::GetUniformId("modelViewProjectionMatrix");
+	static const UniformId normalMatrixId = COpenGLRenderer::GetUniformId("normalMatrix");
+	static const UniformId textureIds[TEXTURESET::MAX_TEXTURES] = {
+		COpenGLRenderer::GetUniformId("texture01"),
+		COpenGLRenderer::GetUniformId("texture02"),
+		COpenGLRenderer::GetUniformId("texture03"),
+		COpenGLRenderer::GetUniformId("texture04") };
+
+	// packets added after Sort are drawn in traversal order
+	if (m_arrOrder.size() != m_arrPackets.size())
+	{
+		m_arrOrder.resize(m_arrPackets.size());
+		for (uint32_t i=0; i<m_arrOrder.size(); i++)
+		{
+			m_arrOrder[i] = i;
+		}
+	}
+
+	const glm::mat4 viewProjection = pRenderer->GetProjectionMatrix() * pRenderer->GetViewMatrix();
+
+	STATE state;
+	m_uSortedStateChanges = 0;
+	for (size_t i=0; i<m_arrOrder.size(); i++)
+	{
+		const DRAWPACKET& packet = m_arrPackets[m_arrOrder[i]];
+		const STATE previous = state;
+		m_uSortedStateChanges += CountStateChanges(state, packet);
+
+		const bool programChanged = (previous.uProgram != state.uProgram) || i == 0;
+		if (programChanged)
+		{
+			pRenderer->UseProgram(packet.uProgram);
+		}
+
+		if (packet.pTextures)
+		{
+			for (uint32_t unit=0; unit<packet.pTextures->uCount; unit++)
+			{
+				if (previous.arrTextures[unit] != state.arrTextures[unit] || i == 0)
+				{
+					pRenderer->BindTexture(unit, state.arrTextures[unit]);
+				}
+
+				// uniform cache skips the samplers the program already has
+				pRenderer->SetUniform(packet.uProgram, textureIds[unit], (int32_t)unit);
+			}
+		}
+
+		if (packet.pMaterial && (programChanged || previous.pMaterial != state.pMaterial))
+		{
+			packet.pMaterial->SetToProgram(pRenderer, packet.uProgram);
+		}
+
+		if (programChanged || previous.pGeometry != state.pGeometry)
+		{
+			packet.pGeometry->SetAttribs(packet.uProgram);
+		}
+
+		// per object uniforms
+		pRenderer->SetUniform(packet.uProgram, modelMatrixId, packet.mWorld);
+		pRenderer->SetUniform(packet.uProgram, modelViewProjectionMatrixId, viewProjection * packet.mWorld);
+		pRenderer->SetUniform(packet.uProgram, normalMatrixId, glm::mat3(glm::transpose(glm::inverse(packet.mWorld))));
+
+		packet.pGeometry->Draw(pRenderer);
+	}
+
+	if (state.pGeometry)
+	{
+		state.pGeometry->DisableAttribs(state.uProgram);
+	}
+}
+
+
+void RenderQueue::Clear()
+{
+	m_arrPackets.clear();
+	m_arrOrder.clear();
+
+	// indices are only valid for one frame, deleted objects may reuse addresses
+	m_mapProgramIds.clear();
+	m_mapTextureSetIds.clear();
+	m_mapMaterialIds.clear();
+	m_mapGeometryIds.clear();
+}
+
+
+uint64_t RenderQueue::GetKeyIndex(std::unordered_map<uintptr_t, uint16_t>& mapIds, uintptr_t id)
+{
+	auto it = mapIds.find(id);
+	if (it != mapIds.end())
+	{
+		return it->second;
+	}
+
+	// saturate instead of wrapping into the neighbouring key field
+	const uint16_t index = (uint16_t)std::min<size_t>(mapIds.size(), 0xffff);
+	mapIds.emplace(id, index);
+	return index;
+}
+
+
+uint32_t RenderQueue::CountStateChanges(STATE& state, const DRAWPACKET& packet)
+{
+	uint32_t changes = 0;
+	if (state.uProgram != packet.uProgram)
+	{
+		state.uProgram = packet.uProgram;
+		++changes;
+	}
+
+	if (packet.pTextures)
+	{
+		for (uint32_t unit=0; unit<packet.pTextures->uCount; unit++)
+		{
+			if (state.arrTextures[unit] != packet.pTextures->arrTextures[unit])
+			{
+				state.arrTextures[unit] = packet.pTextures->arrTextures[unit];
+				++changes;
+			}
+		}
+	}
+
+	if (packet.pMaterial && state.pMaterial != packet.pMaterial)
+	{
+		state.pMaterial = packet.pMaterial;
+		++changes;
+	}
+
+	if (state.pGeometry != packet.pGeometry)
+	{
+		state.pGeometry = packet.pGeometry;
+		++changes;
+	}
+
+	return changes;
+}
+
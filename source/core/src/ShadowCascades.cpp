@@ -0,0 +1,128 @@
+/**
+ * ============================================================================
+ *  Name        : ShadowCascades.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : cascaded shadow map splits fitted to the camera frustum
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#include "../include/ShadowCascades.h"
+#include <algorithm>
+
+
+ShadowCascades::ShadowCascades()
+{
+	m_uCascadeCount = MAX_CASCADES;
+	m_fMaxDistance = 50.0f;
+	m_fSplitLambda = 0.75f;
+	m_fCasterDistance = 20.0f;
+
+	for (uint32_t i=0; i<MAX_CASCADES; i++)
+	{
+		m_arrViewProjections[i] = glm::mat4(1.0f);
+		m_arrShadowMatrices[i] = glm::mat4(1.0f);
+	}
+	m_vSplitDistances = glm::vec4(0.0f);
+}
+
+
+ShadowCascades::~ShadowCascades()
+{
+}
+
+
+void ShadowCascades::SetCascadeCount(uint32_t uCount)
+{
+	const uint32_t uMaxCount = MAX_CASCADES;
+	m_uCascadeCount = std::min(std::max(uCount, 1u), uMaxCount);
+}
+
+
+void ShadowCascades::Update(const glm::mat4& mView, const glm::mat4& mProjection, const glm::vec3& vLightDirection, uint32_t uTileSize)
+{
+	// near and far planes of a perspective projection
+	const float fNear = mProjection[3][2] / (mProjection[2][2] - 1.0f);
+	const float fFrustumFar = mProjection[3][2] / (mProjection[2][2] + 1.0f);
+	const float fFar = std::min(fFrustumFar, m_fMaxDistance);
+
+	// frustum corners in world space, near plane first
+	const glm::mat4 mInvViewProjection(glm::inverse(mProjection * mView));
+	glm::vec3 arrCorners[8];
+	for (uint32_t i=0; i<8; i++)
+	{
+		const glm::vec4 vCorner(mInvViewProjection * glm::vec4(
+			(i & 1) ? 1.0f : -1.0f,
+			(i & 2) ? 1.0f : -1.0f,
+			(i & 4) ? 1.0f : -1.0f, 1.0f));
+		arrCorners[i] = glm::vec3(vCorner) / vCorner.w;
+	}
+
+	// light space rotation is the same for all cascades, snapping is done in it
+	const glm::vec3 vDirection(glm::normalize(vLightDirection));
+	const glm::vec3 vUp = (fabsf(vDirection.y) > 0.99f) ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	const glm::mat4 mLightView(glm::lookAt(glm::vec3(0.0f), vDirection, vUp));
+
+	// bias into [0, 1] and into the tile of the cascade in the 2x2 atlas
+	const glm::mat4 mBias(
+		0.25f, 0.0f, 0.0f, 0.0f,
+		0.0f, 0.25f, 0.0f, 0.0f,
+		0.0f, 0.0f, 0.5f, 0.0f,
+		0.25f, 0.25f, 0.5f, 1.0f);
+
+	m_vSplitDistances = glm::vec4(0.0f);
+	float fSplitNear = fNear;
+	for (uint32_t c=0; c<m_uCascadeCount; c++)
+	{
+		// blend of logarithmic and uniform splits
+		const float t = (float)(c + 1) / (float)m_uCascadeCount;
+		const float fLog = fNear * powf(fFar / fNear, t);
+		const float fUniform = fNear + (fFar - fNear) * t;
+		const float fSplitFar = m_fSplitLambda * fLog + (1.0f - m_fSplitLambda) * fUniform;
+		m_vSplitDistances[c] = fSplitFar;
+
+		// slice of the frustum, points along the corner edges are linear in view depth
+		const float t0 = (fSplitNear - fNear) / (fFrustumFar - fNear);
+		const float t1 = (fSplitFar - fNear) / (fFrustumFar - fNear);
+		glm::vec3 arrSlice[8];
+		glm::vec3 vCenter(0.0f);
+		for (uint32_t i=0; i<4; i++)
+		{
+			arrSlice[i] = glm::mix(arrCorners[i], arrCorners[i + 4], t0);
+			arrSlice[i + 4] = glm::mix(arrCorners[i], arrCorners[i + 4], t1);
+			vCenter += arrSlice[i] + arrSlice[i + 4];
+		}
+		vCenter /= 8.0f;
+
+		float fRadius = 0.0f;
+		for (uint32_t i=0; i<8; i++)
+		{
+			fRadius = std::max(fRadius, glm::length(arrSlice[i] - vCenter));
+		}
+
+		// round the radius up so that rounding noise does not resize the cascade
+		fRadius = ceilf(fRadius * 16.0f) / 16.0f;
+
+		// move the center in whole texels of the cascade
+		const float fTexel = (fRadius * 2.0f) / (float)uTileSize;
+		glm::vec3 vLightCenter(mLightView * glm::vec4(vCenter, 1.0f));
+		vLightCenter.x = floorf(vLightCenter.x / fTexel) * fTexel;
+		vLightCenter.y = floorf(vLightCenter.y / fTexel) * fTexel;
+
+		// light looks down -z, casters up to fCasterDistance towards the light are included
+		const glm::mat4 mLightProjection(glm::ortho(
+			vLightCenter.x - fRadius, vLightCenter.x + fRadius,
+			vLightCenter.y - fRadius, vLightCenter.y + fRadius,
+			-(vLightCenter.z + fRadius + m_fCasterDistance), -(vLightCenter.z - fRadius)));
+		m_arrViewProjections[c] = mLightProjection * mLightView;
+
+		const glm::ivec2 vTile(GetTileViewport(c, 1));
+		glm::mat4 mTile(mBias);
+		mTile[3][0] += 0.5f * (float)vTile.x;
+		mTile[3][1] += 0.5f * (float)vTile.y;
+		m_arrShadowMatrices[c] = mTile * m_arrViewProjections[c];
+
+		fSplitNear = fSplitFar;
+	}
+}
@@ -0,0 +1,178 @@
+/**
+ * ============================================================================
+ *  Name        : SpatialHash.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : uniform spatial hash grid broadphase for bounding spheres
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#include "../include/SpatialHash.h"
+#include "../include/IGraphNode.h"
+#include "../include/JobSystem.h"
+#include <algorithm>
+
+
+SpatialHash::SpatialHash()
+{
+	m_pJobs = nullptr;
+	m_fInvCellSize = 1.0f;
+	m_fMaxRadius = 0.0f;
+	m_uMaskX = 0;
+	m_uMaskY = 0;
+	m_uMaskZ = 0;
+	m_uShiftY = 0;
+	m_uShiftZ = 0;
+}
+
+
+SpatialHash::~SpatialHash()
+{
+}
+
+
+void SpatialHash::Build(const glm::vec3* pPositions, const float* pRadii, uint32_t uCount)
+{
+	m_arrPairs.clear();
+	if (uCount < 2)
+	{
+		return;
+	}
+
+	// twice the largest diameter as the cell size, the box around a sphere
+	// that holds all of its possible partners then touches 2x2x2 cells
+	float fMaxRadius = 0.0f;
+	for (uint32_t i=0; i<uCount; i++)
+	{
+		fMaxRadius = std::max(fMaxRadius, pRadii[i]);
+	}
+	m_fInvCellSize = (fMaxRadius > 0.0f) ? 1.0f / (fMaxRadius * 4.0f) : 1.0f;
+
+	// about two buckets per object keeps the collisions low, bits of the
+	// bucket index are shared evenly between the axes
+	uint32_t uBits = 1;
+	while ((1u << uBits) < uCount * 2)
+	{
+		uBits++;
+	}
+	const uint32_t uBitsX = (uBits + 2) / 3;
+	const uint32_t uBitsY = (uBits - uBitsX + 1) / 2;
+	const uint32_t uBitsZ = uBits - uBitsX - uBitsY;
+	m_uMaskX = (1u << uBitsX) - 1;
+	m_uMaskY = (1u << uBitsY) - 1;
+	m_uMaskZ = (1u << uBitsZ) - 1;
+	m_uShiftY = uBitsX;
+	m_uShiftZ = uBitsX + uBitsY;
+	const uint32_t uBuckets = 1u << uBits;
+
+	// counting sort of the objects into the buckets
+	m_arrBucketStart.assign(uBuckets + 1, 0);
+	m_arrCells.resize(uCount);
+	for (uint32_t i=0; i<uCount; i++)
+	{
+		const glm::vec3 cell = glm::floor(pPositions[i] * m_fInvCellSize);
+		CELL& c = m_arrCells[i];
+		c.x = (int32_t)cell.x;
+		c.y = (int32_t)cell.y;
+		c.z = (int32_t)cell.z;
+		c.uBucket = GetBucket(c.x, c.y, c.z);
+		m_arrBucketStart[c.uBucket]++;
+	}
+
+	// running sum gives the end of each bucket, filling backwards moves it to the start
+	for (uint32_t b=1; b<=uBuckets; b++)
+	{
+		m_arrBucketStart[b] += m_arrBucketStart[b - 1];
+	}
+
+	// copy the spheres in bucket order, a bucket is then one contiguous read
+	m_arrEntries.resize(uCount);
+	for (uint32_t i=uCount; i>0; i--)
+	{
+		const CELL& c = m_arrCells[i - 1];
+		ENTRY& entry = m_arrEntries[--m_arrBucketStart[c.uBucket]];
+		entry.vPos = pPositions[i - 1];
+		entry.fRadius = pRadii[i - 1];
+		entry.x = c.x;
+		entry.y = c.y;
+		entry.z = c.z;
+		entry.uIndex = i - 1;
+	}
+
+	m_fMaxRadius = fMaxRadius;
+	if (!m_pJobs)
+	{
+		QueryRange(0, uCount, m_arrPairs);
+		return;
+	}
+
+	// a few ranges per thread, each collects its own pairs
+	const uint32_t uRanges = (m_pJobs->GetWorkerCount() + 1) * 4;
+	const uint32_t uGrainSize = (uCount + uRanges - 1) / uRanges;
+	m_arrRangePairs.resize(uRanges);
+	for (uint32_t r=0; r<uRanges; r++)
+	{
+		m_arrRangePairs[r].clear();
+	}
+
+	m_pJobs->ParallelFor(uCount, uGrainSize, [this, uGrainSize](uint32_t uBegin, uint32_t uEnd)
+	{
+		QueryRange(uBegin, uEnd, m_arrRangePairs[uBegin / uGrainSize]);
+	});
+
+	for (uint32_t r=0; r<uRanges; r++)
+	{
+		m_arrPairs.insert(m_arrPairs.end(), m_arrRangePairs[r].begin(), m_arrRangePairs[r].end());
+	}
+}
+
+
+void SpatialHash::QueryRange(uint32_t uBegin, uint32_t uEnd, std::vector<PAIR>& arrPairs) const
+{
+	for (uint32_t k=uBegin; k<uEnd; k++)
+	{
+		const ENTRY& entry = m_arrEntries[k];
+
+		// cells touched by the box that can hold overlapping spheres
+		const float fReach = entry.fRadius + m_fMaxRadius;
+		const glm::vec3 vMin = glm::floor((entry.vPos - fReach) * m_fInvCellSize);
+		const glm::vec3 vMax = glm::floor((entry.vPos + fReach) * m_fInvCellSize);
+
+		for (int32_t z=(int32_t)vMin.z; z<=(int32_t)vMax.z; z++)
+		{
+			for (int32_t y=(int32_t)vMin.y; y<=(int32_t)vMax.y; y++)
+			{
+				for (int32_t x=(int32_t)vMin.x; x<=(int32_t)vMax.x; x++)
+				{
+					// other cells wrapped into the same bucket are skipped, only
+					// the smaller index of a pair tests it so that it is found once
+					const uint32_t uBucket = GetBucket(x, y, z);
+					const uint32_t uBucketEnd = m_arrBucketStart[uBucket + 1];
+					for (uint32_t n=m_arrBucketStart[uBucket]; n<uBucketEnd; n++)
+					{
+						const ENTRY& other = m_arrEntries[n];
+						if (other.uIndex > entry.uIndex && other.x == x && other.y == y && other.z == z)
+						{
+							TestPair(entry, other, arrPairs);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+
+void SpatialHash::Build(const std::vector<IGraphNode*>& arrNodes)
+{
+	m_arrNodePositions.resize(arrNodes.size());
+	m_arrNodeRadii.resize(arrNodes.size());
+	for (size_t i=0; i<arrNodes.size(); i++)
+	{
+		m_arrNodePositions[i] = arrNodes[i]->GetPos();
+		m_arrNodeRadii[i] = arrNodes[i]->GetRadius();
+	}
+
+	Build(m_arrNodePositions.data(), m_arrNodeRadii.data(), (uint32_t)arrNodes.size());
+}
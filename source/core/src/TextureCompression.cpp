@@ -0,0 +1,543 @@
+/**
+ * ============================================================================
+ *  Name        : TextureCompression.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : BC1/BC3 block compression and DDS files
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#include "../include/TextureCompression.h"
+#include "../include/JobSystem.h"
+#include "../include/PixelKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+
+//
+// color endpoints are 5:6:5, expanded to 8 bits by repeating the high bits
+//
+
+static uint16_t PackColor(const float* pColor)
+{
+	const uint32_t r = (uint32_t)(std::min(std::max(pColor[0], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+	const uint32_t g = (uint32_t)(std::min(std::max(pColor[1], 0.0f), 255.0f) * 63.0f / 255.0f + 0.5f);
+	const uint32_t b = (uint32_t)(std::min(std::max(pColor[2], 0.0f), 255.0f) * 31.0f / 255.0f + 0.5f);
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void UnpackColor(uint16_t uColor, int32_t* pColor)
+{
+	const int32_t r = (uColor >> 11) & 31;
+	const int32_t g = (uColor >> 5) & 63;
+	const int32_t b = uColor & 31;
+	pColor[0] = (r << 3) | (r >> 2);
+	pColor[1] = (g << 2) | (g >> 4);
+	pColor[2] = (b << 3) | (b >> 2);
+}
+
+// palette of a color block, 4 color mode when c0 > c1
+static void GetColorPalette(uint16_t uColor0, uint16_t uColor1, int32_t arrPalette[4][3], bool bAllowTransparent)
+{
+	UnpackColor(uColor0, arrPalette[0]);
+	UnpackColor(uColor1, arrPalette[1]);
+	for (uint32_t c=0; c<3; c++)
+	{
+		if (uColor0 > uColor1 || !bAllowTransparent)
+		{
+			arrPalette[2][c] = (2 * arrPalette[0][c] + arrPalette[1][c]) / 3;
+			arrPalette[3][c] = (arrPalette[0][c] + 2 * arrPalette[1][c]) / 3;
+		}
+		else
+		{
+			arrPalette[2][c] = (arrPalette[0][c] + arrPalette[1][c]) / 2;
+			arrPalette[3][c] = 0;
+		}
+	}
+}
+
+static uint32_t FindColorIndices(const unsigned char* pBlock, const int32_t arrPalette[4][3], uint8_t* pIndices)
+{
+	uint32_t uTotalError = 0;
+	for (uint32_t i=0; i<16; i++)
+	{
+		uint32_t uBest = 0;
+		int32_t iBestError = 0x7fffffff;
+		for (uint32_t p=0; p<4; p++)
+		{
+			const int32_t dr = (int32_t)pBlock[i * 4] - arrPalette[p][0];
+			const int32_t dg = (int32_t)pBlock[i * 4 + 1] - arrPalette[p][1];
+			const int32_t db = (int32_t)pBlock[i * 4 + 2] - arrPalette[p][2];
+			const int32_t iError = dr * dr + dg * dg + db * db;
+			if (iError < iBestError)
+			{
+				iBestError = iError;
+				uBest = p;
+			}
+		}
+		pIndices[i] = (uint8_t)uBest;
+		uTotalError += (uint32_t)iBestError;
+	}
+	return uTotalError;
+}
+
+static void EncodeColorBlock(const unsigned char* pBlock, unsigned char* pOut)
+{
+	// principal axis of the colors with power iteration on the covariance
+	float arrMean[3] = { 0.0f, 0.0f, 0.0f };
+	for (uint32_t i=0; i<16; i++)
+	{
+		for (uint32_t c=0; c<3; c++)
+		{
+			arrMean[c] += pBlock[i * 4 + c] / 16.0f;
+		}
+	}
+
+	float arrCovariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+	for (uint32_t i=0; i<16; i++)
+	{
+		const float r = pBlock[i * 4] - arrMean[0];
+		const float g = pBlock[i * 4 + 1] - arrMean[1];
+		const float b = pBlock[i * 4 + 2] - arrMean[2];
+		arrCovariance[0] += r * r;
+		arrCovariance[1] += r * g;
+		arrCovariance[2] += r * b;
+		arrCovariance[3] += g * g;
+		arrCovariance[4] += g * b;
+		arrCovariance[5] += b * b;
+	}
+
+	float arrAxis[3] = { 1.0f, 1.0f, 1.0f };
+	for (uint32_t k=0; k<8; k++)
+	{
+		const float x = arrCovariance[0] * arrAxis[0] + arrCovariance[1] * arrAxis[1] + arrCovariance[2] * arrAxis[2];
+		const float y = arrCovariance[1] * arrAxis[0] + arrCovariance[3] * arrAxis[1] + arrCovariance[4] * arrAxis[2];
+		const float z = arrCovariance[2] * arrAxis[0] + arrCovariance[4] * arrAxis[1] + arrCovariance[5] * arrAxis[2];
+		const float fLength = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+		if (fLength < 1e-6f)
+		{
+			break;
+		}
+		arrAxis[0] = x / fLength;
+		arrAxis[1] = y / fLength;
+		arrAxis[2] = z / fLength;
+	}
+
+	// extreme colors along the axis are the first guess for the endpoints
+	float fMin = 1e30f;
+	float fMax = -1e30f;
+	for (uint32_t i=0; i<16; i++)
+	{
+		const float t = (pBlock[i * 4] - arrMean[0]) * arrAxis[0] +
+			(pBlock[i * 4 + 1] - arrMean[1]) * arrAxis[1] +
+			(pBlock[i * 4 + 2] - arrMean[2]) * arrAxis[2];
+		fMin = std::min(fMin, t);
+		fMax = std::max(fMax, t);
+	}
+
+	const float fAxisLength = arrAxis[0] * arrAxis[0] + arrAxis[1] * arrAxis[1] + arrAxis[2] * arrAxis[2];
+	float arrEnd0[3];
+	float arrEnd1[3];
+	for (uint32_t c=0; c<3; c++)
+	{
+		const float fScale = (fAxisLength > 0.0f) ? arrAxis[c] / fAxisLength : 0.0f;
+		arrEnd0[c] = arrMean[c] + fMax * fScale;
+		arrEnd1[c] = arrMean[c] + fMin * fScale;
+	}
+
+	uint16_t uColor0 = PackColor(arrEnd0);
+	uint16_t uColor1 = PackColor(arrEnd1);
+	int32_t arrPalette[4][3];
+	uint8_t arrIndices[16];
+	GetColorPalette(uColor0, uColor1, arrPalette, false);
+	uint32_t uError = FindColorIndices(pBlock, arrPalette, arrIndices);
+
+	// least squares fit of the endpoints to the chosen indices, keep if better
+	static const float arrWeights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+	for (uint32_t k=0; k<2 && uError > 0; k++)
+	{
+		float aa = 0.0f;
+		float ab = 0.0f;
+		float bb = 0.0f;
+		float arrAx[3] = { 0.0f, 0.0f, 0.0f };
+		float arrBx[3] = { 0.0f, 0.0f, 0.0f };
+		for (uint32_t i=0; i<16; i++)
+		{
+			const float a = arrWeights[arrIndices[i]];
+			const float b = 1.0f - a;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (uint32_t c=0; c<3; c++)
+			{
+				arrAx[c] += a * pBlock[i * 4 + c];
+				arrBx[c] += b * pBlock[i * 4 + c];
+			}
+		}
+
+		const float fDeterminant = aa * bb - ab * ab;
+		if (std::fabs(fDeterminant) < 1e-6f)
+		{
+			break;
+		}
+		for (uint32_t c=0; c<3; c++)
+		{
+			arrEnd0[c] = (arrAx[c] * bb - arrBx[c] * ab) / fDeterminant;
+			arrEnd1[c] = (arrBx[c] * aa - arrAx[c] * ab) / fDeterminant;
+		}
+
+		const uint16_t uFitted0 = PackColor(arrEnd0);
+		const uint16_t uFitted1 = PackColor(arrEnd1);
+		int32_t arrFittedPalette[4][3];
+		uint8_t arrFittedIndices[16];
+		GetColorPalette(uFitted0, uFitted1, arrFittedPalette, false);
+		const uint32_t uFittedError = FindColorIndices(pBlock, arrFittedPalette, arrFittedIndices);
+		if (uFittedError >= uError)
+		{
+			break;
+		}
+		uColor0 = uFitted0;
+		uColor1 = uFitted1;
+		uError = uFittedError;
+		memcpy(arrIndices, arrFittedIndices, sizeof(arrIndices));
+	}
+
+	// 4 color mode needs c0 > c1, swapping the endpoints swaps the indices
+	if (uColor0 < uColor1)
+	{
+		std::swap(uColor0, uColor1);
+		static const uint8_t arrSwapped[4] = { 1, 0, 3, 2 };
+		for (uint32_t i=0; i<16; i++)
+		{
+			arrIndices[i] = arrSwapped[arrIndices[i]];
+		}
+	}
+	else if (uColor0 == uColor1)
+	{
+		// 3 color mode, index 0 is the only color
+		memset(arrIndices, 0, sizeof(arrIndices));
+	}
+
+	uint32_t uBits = 0;
+	for (uint32_t i=0; i<16; i++)
+	{
+		uBits |= (uint32_t)arrIndices[i] << (i * 2);
+	}
+
+	pOut[0] = (unsigned char)(uColor0 & 0xff);
+	pOut[1] = (unsigned char)(uColor0 >> 8);
+	pOut[2] = (unsigned char)(uColor1 & 0xff);
+	pOut[3] = (unsigned char)(uColor1 >> 8);
+	memcpy(pOut + 4, &uBits, 4);
+}
+
+static void GetAlphaPalette(uint32_t uAlpha0, uint32_t uAlpha1, int32_t arrPalette[8])
+{
+	arrPalette[0] = (int32_t)uAlpha0;
+	arrPalette[1] = (int32_t)uAlpha1;
+	if (uAlpha0 > uAlpha1)
+	{
+		for (int32_t i = 1; i < 7; i++)
+		{
+			arrPalette[i + 1] = ((7 - i) * (int32_t)uAlpha0 + i * (int32_t)uAlpha1) / 7;
+		}
+	}
+	else
+	{
+		for (int32_t i = 1; i < 5; i++)
+		{
+			arrPalette[i + 1] = ((5 - i) * (int32_t)uAlpha0 + i * (int32_t)uAlpha1) / 5;
+		}
+		arrPalette[6] = 0;
+		arrPalette[7] = 255;
+	}
+}
+
+static void EncodeAlphaBlock(const unsigned char* pBlock, unsigned char* pOut)
+{
+	uint32_t uMin = 255;
+	uint32_t uMax = 0;
+	for (uint32_t i=0; i<16; i++)
+	{
+		uMin = std::min<uint32_t>(uMin, pBlock[i * 4 + 3]);
+		uMax = std::max<uint32_t>(uMax, pBlock[i * 4 + 3]);
+	}
+
+	// 8 value mode with the extremes, equal endpoints give index 0 everywhere
+	int32_t arrPalette[8];
+	GetAlphaPalette(uMax, uMin, arrPalette);
+
+	uint64_t uBits = 0;
+	for (uint32_t i=0; i<16; i++)
+	{
+		uint32_t uBest = 0;
+		if (uMax > uMin)
+		{
+			int32_t iBestError = 256;
+			for (uint32_t p=0; p<8; p++)
+			{
+				const int32_t iError = std::abs((int32_t)pBlock[i * 4 + 3] - arrPalette[p]);
+				if (iError < iBestError)
+				{
+					iBestError = iError;
+					uBest = p;
+				}
+			}
+		}
+		uBits |= (uint64_t)uBest << (i * 3);
+	}
+
+	pOut[0] = (unsigned char)uMax;
+	pOut[1] = (unsigned char)uMin;
+	for (uint32_t i=0; i<6; i++)
+	{
+		pOut[2 + i] = (unsigned char)(uBits >> (i * 8));
+	}
+}
+
+
+size_t TextureCompression::GetLevelSize(BLOCKFORMAT eFormat, int32_t iWidth, int32_t iHeight)
+{
+	const size_t uBlockBytes = (eFormat == BLOCKFORMAT_BC1) ? 8 : 16;
+	return (size_t)((iWidth + 3) / 4) * (size_t)((iHeight + 3) / 4) * uBlockBytes;
+}
+
+
+void TextureCompression::Encode(const unsigned char* pPixels, int32_t iWidth, int32_t iHeight, BLOCKFORMAT eFormat, unsigned char* pBlocks, JobSystem* pJobs)
+{
+	const int32_t iBlockRows = (iHeight + 3) / 4;
+	if (!pJobs)
+	{
+		EncodeRows(pPixels, iWidth, iHeight, eFormat, pBlocks, 0, iBlockRows);
+		return;
+	}
+
+	pJobs->ParallelFor((uint32_t)iBlockRows, 4, [=](uint32_t uBegin, uint32_t uEnd)
+	{
+		EncodeRows(pPixels, iWidth, iHeight, eFormat, pBlocks, (int32_t)uBegin, (int32_t)uEnd);
+	});
+}
+
+
+void TextureCompression::EncodeRows(const unsigned char* pPixels, int32_t iWidth, int32_t iHeight, BLOCKFORMAT eFormat,
+	unsigned char* pBlocks, int32_t iFirstRow, int32_t iLastRow)
+{
+	const int32_t iBlockColumns = (iWidth + 3) / 4;
+	const size_t uBlockBytes = (eFormat == BLOCKFORMAT_BC1) ? 8 : 16;
+
+	unsigned char arrBlock[64];
+	for (int32_t by = iFirstRow; by < iLastRow; by++)
+	{
+		for (int32_t bx = 0; bx < iBlockColumns; bx++)
+		{
+			for (int32_t y = 0; y < 4; y++)
+			{
+				const int32_t sy = std::min(by * 4 + y, iHeight - 1);
+				for (int32_t x = 0; x < 4; x++)
+				{
+					const int32_t sx = std::min(bx * 4 + x, iWidth - 1);
+					memcpy(&arrBlock[(y * 4 + x) * 4], &pPixels[((size_t)sy * iWidth + sx) * 4], 4);
+				}
+			}
+
+			unsigned char* pOut = pBlocks + ((size_t)by * iBlockColumns + bx) * uBlockBytes;
+			if (eFormat == BLOCKFORMAT_BC3)
+			{
+				EncodeAlphaBlock(arrBlock, pOut);
+				pOut += 8;
+			}
+			EncodeColorBlock(arrBlock, pOut);
+		}
+	}
+}
+
+
+void TextureCompression::Decode(const unsigned char* pBlocks, int32_t iWidth, int32_t iHeight, BLOCKFORMAT eFormat, unsigned char* pPixels)
+{
+	const int32_t iBlockColumns = (iWidth + 3) / 4;
+	const int32_t iBlockRows = (iHeight + 3) / 4;
+	const size_t uBlockBytes = (eFormat == BLOCKFORMAT_BC1) ? 8 : 16;
+
+	for (int32_t by = 0; by < iBlockRows; by++)
+	{
+		for (int32_t bx = 0; bx < iBlockColumns; bx++)
+		{
+			const unsigned char* pBlock = pBlocks + ((size_t)by * iBlockColumns + bx) * uBlockBytes;
+
+			int32_t arrAlphaPalette[8];
+			uint64_t uAlphaBits = 0;
+			if (eFormat == BLOCKFORMAT_BC3)
+			{
+				GetAlphaPalette(pBlock[0], pBlock[1], arrAlphaPalette);
+				for (uint32_t i=0; i<6; i++)
+				{
+					uAlphaBits |= (uint64_t)pBlock[2 + i] << (i * 8);
+				}
+				pBlock += 8;
+			}
+
+			const uint16_t uColor0 = (uint16_t)(pBlock[0] | (pBlock[1] << 8));
+			const uint16_t uColor1 = (uint16_t)(pBlock[2] | (pBlock[3] << 8));
+			int32_t arrPalette[4][3];
+			GetColorPalette(uColor0, uColor1, arrPalette, eFormat == BLOCKFORMAT_BC1);
+
+			uint32_t uBits = 0;
+			memcpy(&uBits, pBlock + 4, 4);
+
+			for (int32_t y = 0; y < 4 && by * 4 + y < iHeight; y++)
+			{
+				for (int32_t x = 0; x < 4 && bx * 4 + x < iWidth; x++)
+				{
+					const uint32_t i = (uint32_t)(y * 4 + x);
+					const uint32_t uIndex = (uBits >> (i * 2)) & 3;
+					unsigned char* pOut = &pPixels[((size_t)(by * 4 + y) * iWidth + bx * 4 + x) * 4];
+					pOut[0] = (unsigned char)arrPalette[uIndex][0];
+					pOut[1] = (unsigned char)arrPalette[uIndex][1];
+					pOut[2] = (unsigned char)arrPalette[uIndex][2];
+
+					if (eFormat == BLOCKFORMAT_BC3)
+					{
+						pOut[3] = (unsigned char)arrAlphaPalette[(uAlphaBits >> (i * 3)) & 7];
+					}
+					else
+					{
+						pOut[3] = (uColor0 <= uColor1 && uIndex == 3) ? 0 : 255;
+					}
+				}
+			}
+		}
+	}
+}
+
+
+//
+// DDS files, the legacy header with a DXT1 or DXT5 four character code
+//
+
+static const uint32_t DDS_MAGIC = 0x20534444;			// "DDS "
+static const uint32_t DDS_FOURCC_DXT1 = 0x31545844;		// "DXT1"
+static const uint32_t DDS_FOURCC_DXT5 = 0x35545844;		// "DXT5"
+
+struct DDSHEADER
+{
+	uint32_t	uSize;
+	uint32_t	uFlags;
+	uint32_t	uHeight;
+	uint32_t	uWidth;
+	uint32_t	uLinearSize;
+	uint32_t	uDepth;
+	uint32_t	uMipMapCount;
+	uint32_t	arrReserved1[11];
+	uint32_t	uPixelFormatSize;
+	uint32_t	uPixelFormatFlags;
+	uint32_t	uFourCC;
+	uint32_t	arrPixelFormatMasks[5];
+	uint32_t	uCaps;
+	uint32_t	arrCaps[3];
+	uint32_t	uReserved2;
+};
+
+
+bool TextureCompression::SaveDDS(const std::string& strFilename, const IMAGE& image)
+{
+	DDSHEADER header;
+	memset(&header, 0, sizeof(header));
+	header.uSize = 124;
+	header.uFlags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x80000;		// caps, height, width, pixel format, linear size
+	header.uHeight = (uint32_t)image.iHeight;
+	header.uWidth = (uint32_t)image.iWidth;
+	header.uLinearSize = (uint32_t)GetLevelSize(image.eFormat, image.iWidth, image.iHeight);
+	header.uMipMapCount = image.uLevels;
+	header.uPixelFormatSize = 32;
+	header.uPixelFormatFlags = 0x4;								// four character code
+	header.uFourCC = (image.eFormat == BLOCKFORMAT_BC1) ? DDS_FOURCC_DXT1 : DDS_FOURCC_DXT5;
+	header.uCaps = 0x1000;										// texture
+	if (image.uLevels > 1)
+	{
+		header.uFlags |= 0x20000;								// mip map count
+		header.uCaps |= 0x8 | 0x400000;							// complex, mip map
+	}
+
+	std::ofstream file(strFilename, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+	file.write((const char*)&DDS_MAGIC, 4);
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)image.arrData.data(), (std::streamsize)image.arrData.size());
+	return file.good();
+}
+
+
+bool TextureCompression::LoadDDS(const std::string& strFilename, IMAGE& image)
+{
+	std::ifstream file(strFilename, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+
+	uint32_t uMagic = 0;
+	DDSHEADER header;
+	file.read((char*)&uMagic, 4);
+	file.read((char*)&header, sizeof(header));
+	if (!file || uMagic != DDS_MAGIC || header.uSize != 124 || !(header.uPixelFormatFlags & 0x4))		// fourcc
+	{
+		return false;
+	}
+
+	// the header is not trusted: dimensions must fit int32_t and the mip count the full chain
+	if (!header.uWidth || !header.uHeight || header.uWidth > INT32_MAX || header.uHeight > INT32_MAX)
+	{
+		return false;
+	}
+
+	if (header.uFourCC == DDS_FOURCC_DXT1)
+	{
+		image.eFormat = BLOCKFORMAT_BC1;
+	}
+	else if (header.uFourCC == DDS_FOURCC_DXT5)
+	{
+		image.eFormat = BLOCKFORMAT_BC3;
+	}
+	else
+	{
+		return false;
+	}
+
+	image.iWidth = (int32_t)header.uWidth;
+	image.iHeight = (int32_t)header.uHeight;
+	image.uLevels = std::max(header.uMipMapCount, 1u);
+	if (image.uLevels > PixelKernels::GetMipLevelCount(image.iWidth, image.iHeight))
+	{
+		return false;
+	}
+
+	size_t uTotal = 0;
+	int32_t w = image.iWidth;
+	int32_t h = image.iHeight;
+	for (uint32_t i=0; i<image.uLevels; i++)
+	{
+		uTotal += GetLevelSize(image.eFormat, w, h);
+		w = std::max(w / 2, 1);
+		h = std::max(h / 2, 1);
+	}
+
+	// the levels must be in the file before anything is allocated for them
+	const std::streamoff uDataStart = file.tellg();
+	file.seekg(0, std::ios::end);
+	const std::streamoff uFileSize = file.tellg();
+	if (uDataStart < 0 || uFileSize < uDataStart || (uint64_t)(uFileSize - uDataStart) < uTotal)
+	{
+		return false;
+	}
+	file.seekg(uDataStart);
+
+	image.arrData.resize(uTotal);
+	file.read((char*)image.arrData.data(), (std::streamsize)uTotal);
+	return (bool)file;
+}
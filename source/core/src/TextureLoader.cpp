@@ -0,0 +1,182 @@
+/**
+ * ============================================================================
+ *  Name        : TextureLoader.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : textures decoded on worker threads and uploaded within a budget
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#include "../include/TextureLoader.h"
+#include "../include/PixelKernels.h"
+#include "../include/stb_image.h"
+#include <algorithm>
+
+
+TextureLoader::TextureLoader()
+{
+	m_pRenderer = nullptr;
+	m_pJobs = nullptr;
+	m_uJobs = 0;
+}
+
+
+TextureLoader::~TextureLoader()
+{
+}
+
+
+bool TextureLoader::Create(COpenGLRenderer* pRenderer, JobSystem* pJobs)
+{
+	m_pRenderer = pRenderer;
+	m_pJobs = pJobs;
+	return m_pRenderer && m_pJobs;
+}
+
+
+void TextureLoader::Release()
+{
+	if (m_pJobs)
+	{
+		m_pJobs->Wait(&m_uJobs);
+	}
+
+	for (uint32_t i=0; i<m_arrRequests.size(); i++)
+	{
+		FreeRequest(m_arrRequests[i]);
+	}
+	m_arrRequests.clear();
+}
+
+
+GLuint TextureLoader::Load(const std::string& strFilename, const TEXTUREPARAMS& params)
+{
+	// grey placeholder until the image arrives, it has no mip levels
+	static const unsigned char placeholder[4] = { 128, 128, 128, 255 };
+	TEXTUREPARAMS placeholderParams = params;
+	placeholderParams.eMipmaps = MIPMAPS_NONE;
+
+	GLuint uTexture = 0;
+	glGenTextures(1, &uTexture);
+	m_pRenderer->UploadTexture(uTexture, 1, 1, placeholder, placeholderParams);
+
+	REQUEST* pRequest = new REQUEST;
+	pRequest->uTexture = uTexture;
+	pRequest->strFilename = strFilename;
+	pRequest->params = params;
+	m_arrRequests.push_back(pRequest);
+
+	JobSystem* pJobs = m_pJobs;
+	m_pJobs->Run([pRequest, pJobs]() { Decode(pRequest, pJobs); }, &m_uJobs);
+	return uTexture;
+}
+
+
+void TextureLoader::Update(uint32_t uByteBudget)
+{
+	uint32_t uBytes = 0;
+	size_t uRequest = 0;
+	while (uRequest < m_arrRequests.size() && uBytes < uByteBudget)
+	{
+		REQUEST* pRequest = m_arrRequests[uRequest];
+		if (!pRequest->bDecoded.load(std::memory_order_acquire))
+		{
+			// later images may be ready first
+			++uRequest;
+			continue;
+		}
+
+		if (pRequest->arrPixels.empty())
+		{
+			IApplication::Debug("TextureLoader::Update - failed to load " + pRequest->strFilename + "\n");
+			FreeRequest(pRequest);
+			m_arrRequests.erase(m_arrRequests.begin() + uRequest);
+			continue;
+		}
+
+		const size_t uTotalBytes = pRequest->arrPixels.size();
+		if (!pRequest->uPixelBuffer)
+		{
+			glGenBuffers(1, &pRequest->uPixelBuffer);
+			m_pRenderer->BindBuffer(GL_PIXEL_UNPACK_BUFFER, pRequest->uPixelBuffer);
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)uTotalBytes, nullptr, GL_STREAM_DRAW);
+		}
+		else
+		{
+			m_pRenderer->BindBuffer(GL_PIXEL_UNPACK_BUFFER, pRequest->uPixelBuffer);
+		}
+
+		// copy whole rows of the largest level within the budget
+		const uint32_t uRowBytes = (uint32_t)pRequest->iWidth * 4;
+		const uint32_t uBudgetBytes = std::max((uByteBudget - uBytes) / uRowBytes, 1u) * uRowBytes;
+		const size_t uCopyBytes = std::min((size_t)uBudgetBytes, uTotalBytes - pRequest->uBytesStaged);
+		glBufferSubData(GL_PIXEL_UNPACK_BUFFER, (GLintptr)pRequest->uBytesStaged, (GLsizeiptr)uCopyBytes, &pRequest->arrPixels[pRequest->uBytesStaged]);
+		pRequest->uBytesStaged += uCopyBytes;
+		uBytes += (uint32_t)uCopyBytes;
+
+		if (pRequest->uBytesStaged < uTotalBytes)
+		{
+			m_pRenderer->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			break;
+		}
+
+		// all levels are in the pixel buffer, the driver copies it to the texture
+		m_pRenderer->UploadTexture(pRequest->uTexture, pRequest->iWidth, pRequest->iHeight, nullptr, pRequest->params);
+		m_pRenderer->BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		FreeRequest(pRequest);
+		m_arrRequests.erase(m_arrRequests.begin() + uRequest);
+	}
+}
+
+
+bool TextureLoader::IsLoaded(GLuint uTexture) const
+{
+	for (uint32_t i=0; i<m_arrRequests.size(); i++)
+	{
+		if (m_arrRequests[i]->uTexture == uTexture)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+void TextureLoader::Decode(REQUEST* pRequest, JobSystem* pJobs)
+{
+	int width = 0;
+	int height = 0;
+	int bpp = 0;
+	unsigned char* pPixels = stbi_load(pRequest->strFilename.c_str(), &width, &height, &bpp, STBI_rgb_alpha);
+	if (pPixels && width && height)
+	{
+		// large images are split further across the workers
+		PixelKernels::PremultiplyAlpha(pPixels, (size_t)width * height, pJobs);
+		pRequest->iWidth = width;
+		pRequest->iHeight = height;
+		pRequest->arrPixels.assign(pPixels, pPixels + (size_t)width * height * 4);
+
+		const TEXTUREMIPMAPS eMipmaps = pRequest->params.eMipmaps;
+		if (eMipmaps == MIPMAPS_BOX || eMipmaps == MIPMAPS_KAISER)
+		{
+			PixelKernels::BuildMipChain(pRequest->arrPixels, width, height, (eMipmaps == MIPMAPS_BOX) ? MIPFILTER_BOX : MIPFILTER_KAISER);
+		}
+	}
+	if (pPixels)
+	{
+		stbi_image_free(pPixels);
+	}
+	pRequest->bDecoded.store(true, std::memory_order_release);
+}
+
+
+void TextureLoader::FreeRequest(REQUEST* pRequest)
+{
+	if (pRequest->uPixelBuffer)
+	{
+		m_pRenderer->DeleteBuffer(pRequest->uPixelBuffer);
+	}
+	delete pRequest;
+}
@@ -0,0 +1,328 @@
+/**
+ * ============================================================================
+ *  Name        : TransformKernels.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : batch kernels for integrating and combining transforms,
+ *                with SSE2 and AVX2 paths selected at runtime
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#include "../include/TransformKernels.h"
+#include "../glm-master/glm/gtc/constants.hpp"
+
+// sse2 path uses the vendored glm simd kernels, avx2 path is compiled for the
+// function only and selected when the cpu supports it
+#if GLM_ARCH & GLM_ARCH_SSE2_BIT
+#define TRANSFORM_SSE2
+#include "../glm-master/glm/simd/matrix.h"
+#if defined(__GNUC__) || defined(_MSC_VER)
+#define TRANSFORM_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(TRANSFORM_AVX2) && defined(__GNUC__)
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#else
+#define AVX2_FUNCTION
+#endif
+
+static const uint32_t NO_PARENT = 0xffffffff;
+
+SIMDLEVEL TransformKernels::s_eLevel = TransformKernels::GetBestLevel();
+
+
+SIMDLEVEL TransformKernels::GetBestLevel()
+{
+#if defined(TRANSFORM_AVX2) && defined(__GNUC__)
+	// may run from a static initializer, before the cpu model is set up
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+	{
+		return SIMD_AVX2;
+	}
+#elif defined(TRANSFORM_AVX2) && defined(_MSC_VER)
+	// avx2 needs both the cpu feature and os support for the ymm registers
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] >= 7)
+	{
+		__cpuid(info, 1);
+		const bool bOSXSave = (info[2] & (1 << 27)) != 0;
+		__cpuidex(info, 7, 0);
+		const bool bAVX2 = (info[1] & (1 << 5)) != 0;
+		if (bOSXSave && bAVX2 && (_xgetbv(0) & 6) == 6)
+		{
+			return SIMD_AVX2;
+		}
+	}
+#endif
+
+#if defined(TRANSFORM_SSE2)
+	return SIMD_SSE2;
+#else
+	return SIMD_SCALAR;
+#endif
+}
+
+
+SIMDLEVEL TransformKernels::GetLevel()
+{
+	return s_eLevel;
+}
+
+
+void TransformKernels::SetLevel(SIMDLEVEL eLevel)
+{
+	const SIMDLEVEL eBest = GetBestLevel();
+	s_eLevel = (eLevel > eBest) ? eBest : eLevel;
+}
+
+
+const char* TransformKernels::GetLevelName(SIMDLEVEL eLevel)
+{
+	switch (eLevel)
+	{
+	case SIMD_SSE2: return "SSE2";
+	case SIMD_AVX2: return "AVX2";
+	default: return "scalar";
+	}
+}
+
+
+//
+// scalar kernels, also handle the tails of the simd kernels
+//
+
+static void IntegrateScalar(float* pPositions, const float* pVelocities, uint32_t uBegin, uint32_t uEnd, float fFrametime)
+{
+	for (uint32_t i=uBegin; i<uEnd; i++)
+	{
+		pPositions[i] += pVelocities[i] * fFrametime;
+	}
+}
+
+
+static void AdvanceAnglesScalar(float* pAngles, const float* pSpeeds, uint32_t uBegin, uint32_t uEnd, float fFrametime)
+{
+	const float fTwoPi = glm::two_pi<float>();
+	const float fInvTwoPi = 1.0f / fTwoPi;
+	for (uint32_t i=uBegin; i<uEnd; i++)
+	{
+		const float fAngle = pAngles[i] + pSpeeds[i] * fFrametime;
+		pAngles[i] = fAngle - floorf(fAngle * fInvTwoPi) * fTwoPi;
+	}
+}
+
+
+static void CombineScalar(const uint32_t* pParents, const glm::mat4* pLocals, glm::mat4* pWorlds, uint32_t uCount)
+{
+	for (uint32_t i=0; i<uCount; i++)
+	{
+		const uint32_t uParent = pParents[i];
+		pWorlds[i] = (uParent != NO_PARENT) ? pWorlds[uParent] * pLocals[i] : pLocals[i];
+	}
+}
+
+
+#if defined(TRANSFORM_SSE2)
+
+//
+// sse2 kernels, 4 floats at a time
+//
+
+static void IntegrateSSE2(float* pPositions, const float* pVelocities, uint32_t uCount, float fFrametime)
+{
+	const __m128 dt = _mm_set1_ps(fFrametime);
+	uint32_t i = 0;
+	for (; i+4<=uCount; i+=4)
+	{
+		const __m128 p = _mm_loadu_ps(pPositions + i);
+		const __m128 v = _mm_loadu_ps(pVelocities + i);
+		_mm_storeu_ps(pPositions + i, _mm_add_ps(p, _mm_mul_ps(v, dt)));
+	}
+	IntegrateScalar(pPositions, pVelocities, i, uCount, fFrametime);
+}
+
+
+static void AdvanceAnglesSSE2(float* pAngles, const float* pSpeeds, uint32_t uCount, float fFrametime)
+{
+	const __m128 dt = _mm_set1_ps(fFrametime);
+	const __m128 twoPi = _mm_set1_ps(glm::two_pi<float>());
+	const __m128 invTwoPi = _mm_set1_ps(1.0f / glm::two_pi<float>());
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	uint32_t i = 0;
+	for (; i+4<=uCount; i+=4)
+	{
+		const __m128 angle = _mm_add_ps(_mm_loadu_ps(pAngles + i), _mm_mul_ps(_mm_loadu_ps(pSpeeds + i), dt));
+
+		// floor without sse4.1: truncate, then step down where truncation rounded up
+		const __m128 q = _mm_mul_ps(angle, invTwoPi);
+		__m128 turns = _mm_cvtepi32_ps(_mm_cvttps_epi32(q));
+		turns = _mm_sub_ps(turns, _mm_and_ps(_mm_cmpgt_ps(turns, q), one));
+
+		_mm_storeu_ps(pAngles + i, _mm_sub_ps(angle, _mm_mul_ps(turns, twoPi)));
+	}
+	AdvanceAnglesScalar(pAngles, pSpeeds, i, uCount, fFrametime);
+}
+
+
+static void CombineSSE2(const uint32_t* pParents, const glm::mat4* pLocals, glm::mat4* pWorlds, uint32_t uCount)
+{
+	for (uint32_t i=0; i<uCount; i++)
+	{
+		const uint32_t uParent = pParents[i];
+		if (uParent == NO_PARENT)
+		{
+			pWorlds[i] = pLocals[i];
+			continue;
+		}
+
+		// glm matrices are not guaranteed to be 16 byte aligned, load unaligned
+		const float* pParent = &pWorlds[uParent][0][0];
+		const float* pLocal = &pLocals[i][0][0];
+		glm_vec4 parent[4] = { _mm_loadu_ps(pParent), _mm_loadu_ps(pParent + 4), _mm_loadu_ps(pParent + 8), _mm_loadu_ps(pParent + 12) };
+		glm_vec4 local[4] = { _mm_loadu_ps(pLocal), _mm_loadu_ps(pLocal + 4), _mm_loadu_ps(pLocal + 8), _mm_loadu_ps(pLocal + 12) };
+		glm_vec4 world[4];
+		glm_mat4_mul(parent, local, world);
+
+		float* pWorld = &pWorlds[i][0][0];
+		_mm_storeu_ps(pWorld, world[0]);
+		_mm_storeu_ps(pWorld + 4, world[1]);
+		_mm_storeu_ps(pWorld + 8, world[2]);
+		_mm_storeu_ps(pWorld + 12, world[3]);
+	}
+}
+
+#endif
+
+
+#if defined(TRANSFORM_AVX2)
+
+//
+// avx2 kernels, 8 floats or two matrix columns at a time
+//
+
+AVX2_FUNCTION static void IntegrateAVX2(float* pPositions, const float* pVelocities, uint32_t uCount, float fFrametime)
+{
+	const __m256 dt = _mm256_set1_ps(fFrametime);
+	uint32_t i = 0;
+	for (; i+8<=uCount; i+=8)
+	{
+		const __m256 p = _mm256_loadu_ps(pPositions + i);
+		const __m256 v = _mm256_loadu_ps(pVelocities + i);
+		_mm256_storeu_ps(pPositions + i, _mm256_add_ps(p, _mm256_mul_ps(v, dt)));
+	}
+	IntegrateScalar(pPositions, pVelocities, i, uCount, fFrametime);
+}
+
+
+AVX2_FUNCTION static void AdvanceAnglesAVX2(float* pAngles, const float* pSpeeds, uint32_t uCount, float fFrametime)
+{
+	const __m256 dt = _mm256_set1_ps(fFrametime);
+	const __m256 twoPi = _mm256_set1_ps(glm::two_pi<float>());
+	const __m256 invTwoPi = _mm256_set1_ps(1.0f / glm::two_pi<float>());
+
+	uint32_t i = 0;
+	for (; i+8<=uCount; i+=8)
+	{
+		const __m256 angle = _mm256_add_ps(_mm256_loadu_ps(pAngles + i), _mm256_mul_ps(_mm256_loadu_ps(pSpeeds + i), dt));
+		const __m256 turns = _mm256_floor_ps(_mm256_mul_ps(angle, invTwoPi));
+		_mm256_storeu_ps(pAngles + i, _mm256_sub_ps(angle, _mm256_mul_ps(turns, twoPi)));
+	}
+	AdvanceAnglesScalar(pAngles, pSpeeds, i, uCount, fFrametime);
+}
+
+
+AVX2_FUNCTION static void CombineAVX2(const uint32_t* pParents, const glm::mat4* pLocals, glm::mat4* pWorlds, uint32_t uCount)
+{
+	for (uint32_t i=0; i<uCount; i++)
+	{
+		const uint32_t uParent = pParents[i];
+		if (uParent == NO_PARENT)
+		{
+			pWorlds[i] = pLocals[i];
+			continue;
+		}
+
+		// parent columns duplicated into both 128 bit lanes
+		const float* pParent = &pWorlds[uParent][0][0];
+		const __m256 p0 = _mm256_broadcast_ps((const __m128*)pParent);
+		const __m256 p1 = _mm256_broadcast_ps((const __m128*)(pParent + 4));
+		const __m256 p2 = _mm256_broadcast_ps((const __m128*)(pParent + 8));
+		const __m256 p3 = _mm256_broadcast_ps((const __m128*)(pParent + 12));
+
+		// each lane computes one output column: parent * local column
+		const float* pLocal = &pLocals[i][0][0];
+		float* pWorld = &pWorlds[i][0][0];
+		for (uint32_t c=0; c<16; c+=8)
+		{
+			const __m256 l = _mm256_loadu_ps(pLocal + c);
+			__m256 r = _mm256_mul_ps(p0, _mm256_permute_ps(l, 0x00));
+			r = _mm256_add_ps(r, _mm256_mul_ps(p1, _mm256_permute_ps(l, 0x55)));
+			r = _mm256_add_ps(r, _mm256_mul_ps(p2, _mm256_permute_ps(l, 0xaa)));
+			r = _mm256_add_ps(r, _mm256_mul_ps(p3, _mm256_permute_ps(l, 0xff)));
+			_mm256_storeu_ps(pWorld + c, r);
+		}
+	}
+}
+
+#endif
+
+
+void TransformKernels::IntegratePositions(glm::vec3* pPositions, const glm::vec3* pVelocities, uint32_t uCount, float fFrametime)
+{
+	if (uCount == 0)
+	{
+		return;
+	}
+
+	// vec3 arrays are tightly packed, integrate them as flat float arrays
+	float* pDst = &pPositions[0].x;
+	const float* pSrc = &pVelocities[0].x;
+	const uint32_t uFloats = uCount * 3;
+
+	switch (s_eLevel)
+	{
+#if defined(TRANSFORM_AVX2)
+	case SIMD_AVX2: IntegrateAVX2(pDst, pSrc, uFloats, fFrametime); break;
+#endif
+#if defined(TRANSFORM_SSE2)
+	case SIMD_SSE2: IntegrateSSE2(pDst, pSrc, uFloats, fFrametime); break;
+#endif
+	default: IntegrateScalar(pDst, pSrc, 0, uFloats, fFrametime); break;
+	}
+}
+
+
+void TransformKernels::AdvanceAngles(float* pAngles, const float* pSpeeds, uint32_t uCount, float fFrametime)
+{
+	switch (s_eLevel)
+	{
+#if defined(TRANSFORM_AVX2)
+	case SIMD_AVX2: AdvanceAnglesAVX2(pAngles, pSpeeds, uCount, fFrametime); break;
+#endif
+#if defined(TRANSFORM_SSE2)
+	case SIMD_SSE2: AdvanceAnglesSSE2(pAngles, pSpeeds, uCount, fFrametime); break;
+#endif
+	default: AdvanceAnglesScalar(pAngles, pSpeeds, 0, uCount, fFrametime); break;
+	}
+}
+
+
+void TransformKernels::CombineMatrices(const uint32_t* pParents, const glm::mat4* pLocals, glm::mat4* pWorlds, uint32_t uCount)
+{
+	switch (s_eLevel)
+	{
+#if defined(TRANSFORM_AVX2)
+	case SIMD_AVX2: CombineAVX2(pParents, pLocals, pWorlds, uCount); break;
+#endif
+#if defined(TRANSFORM_SSE2)
+	case SIMD_SSE2: CombineSSE2(pParents, pLocals, pWorlds, uCount); break;
+#endif
+	default: CombineScalar(pParents, pLocals, pWorlds, uCount); break;
+	}
+}
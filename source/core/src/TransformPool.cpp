@@ -0,0 +1,122 @@
+/**
+ * ============================================================================
+ *  Name        : TransformPool.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : structure-of-arrays storage for scenegraph node transforms
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#include "../include/TransformPool.h"
+#include "../include/TransformKernels.h"
+#include "../include/JobSystem.h"
+
+
+TransformPool::TransformPool()
+{
+	m_pJobs = nullptr;
+}
+
+
+TransformPool::~TransformPool()
+{
+}
+
+
+void TransformPool::Reserve(uint32_t uCount)
+{
+	m_arrParents.reserve(uCount);
+	m_arrPositions.reserve(uCount);
+	m_arrVelocities.reserve(uCount);
+	m_arrRotationAxes.reserve(uCount);
+	m_arrRotationAngles.reserve(uCount);
+	m_arrRotationSpeeds.reserve(uCount);
+	m_arrRadii.reserve(uCount);
+	m_arrLocalMatrices.reserve(uCount);
+	m_arrWorldMatrices.reserve(uCount);
+}
+
+
+TransformHandle TransformPool::Allocate(TransformHandle hParent)
+{
+	const TransformHandle h = GetCount();
+
+	m_arrParents.push_back(hParent);
+	m_arrPositions.push_back(glm::vec3(0.0f, 0.0f, 0.0f));
+	m_arrVelocities.push_back(glm::vec3(0.0f, 0.0f, 0.0f));
+	m_arrRotationAxes.push_back(glm::vec3(0.0f, 0.0f, -1.0f));
+	m_arrRotationAngles.push_back(0.0f);
+	m_arrRotationSpeeds.push_back(0.0f);
+	m_arrRadii.push_back(1.0f);
+	m_arrLocalMatrices.push_back(glm::mat4(1.0f));
+	m_arrWorldMatrices.push_back(glm::mat4(1.0f));
+
+	return h;
+}
+
+
+void TransformPool::Clear()
+{
+	m_arrParents.clear();
+	m_arrPositions.clear();
+	m_arrVelocities.clear();
+	m_arrRotationAxes.clear();
+	m_arrRotationAngles.clear();
+	m_arrRotationSpeeds.clear();
+	m_arrRadii.clear();
+	m_arrLocalMatrices.clear();
+	m_arrWorldMatrices.clear();
+}
+
+
+void TransformPool::Integrate(float fFrametime)
+{
+	// transforms integrate independently, split them into ranges across threads
+	if (m_pJobs)
+	{
+		constexpr uint32_t uGrainSize = 4096;
+		m_pJobs->ParallelFor(GetCount(), uGrainSize, [this, fFrametime](uint32_t uBegin, uint32_t uEnd)
+		{
+			IntegrateRange(uBegin, uEnd, fFrametime);
+		});
+		return;
+	}
+
+	IntegrateRange(0, GetCount(), fFrametime);
+}
+
+
+void TransformPool::IntegrateRange(uint32_t uBegin, uint32_t uEnd, float fFrametime)
+{
+	const uint32_t uCount = uEnd - uBegin;
+
+	// update positions per velocity
+	TransformKernels::IntegratePositions(m_arrPositions.data() + uBegin, m_arrVelocities.data() + uBegin, uCount, fFrametime);
+
+	// rebuild rotations of the spinning transforms from their current angle,
+	// same rules as IGraphNode::Update, and set positions back to the local matrices
+	const glm::vec3* pPositions = m_arrPositions.data();
+	const float* pSpeeds = m_arrRotationSpeeds.data();
+	const float* pAngles = m_arrRotationAngles.data();
+	for (uint32_t i=uBegin; i<uEnd; i++)
+	{
+		glm::mat4& mLocal = m_arrLocalMatrices[i];
+		if (fabsf(pSpeeds[i]) > 0.00001f)
+		{
+			mLocal = glm::rotate(glm::mat4(1.0f), pAngles[i], glm::normalize(m_arrRotationAxes[i]));
+		}
+		mLocal[3] = glm::vec4(pPositions[i], 1.0f);
+	}
+
+	// then advance and wrap all the angles
+	TransformKernels::AdvanceAngles(m_arrRotationAngles.data() + uBegin, pSpeeds + uBegin, uCount, fFrametime);
+}
+
+
+void TransformPool::UpdateWorldMatrices()
+{
+	// parents are stored before their children, so parent world matrix is
+	// always up to date when a child reads it
+	TransformKernels::CombineMatrices(m_arrParents.data(), m_arrLocalMatrices.data(), m_arrWorldMatrices.data(), GetCount());
+}
@@ -0,0 +1,262 @@
+/**
+ * ============================================================================
+ *  Name        : VertexFormat.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : compact quantized vertex layouts
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#include "../include/VertexFormat.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+static MESHATTRIBUTE MakeAttribute(const char* pszName, MESHTYPE eType, uint32_t uComponents, bool bNormalized, uint32_t uOffset)
+{
+	MESHATTRIBUTE attribute;
+	memset(&attribute, 0, sizeof(attribute));
+	strncpy(attribute.szName, pszName, sizeof(attribute.szName) - 1);
+	attribute.uType = eType;
+	attribute.uComponents = uComponents;
+	attribute.uNormalized = bNormalized ? 1 : 0;
+	attribute.uOffset = uOffset;
+	return attribute;
+}
+
+
+static int16_t ToInt16(float fValue)
+{
+	return (int16_t)std::lround(std::min(std::max(fValue, -1.0f), 1.0f) * 32767.0f);
+}
+
+
+static uint32_t ToInt10(float fValue)
+{
+	return (uint32_t)std::lround(std::min(std::max(fValue, -1.0f), 1.0f) * 511.0f) & 0x3ff;
+}
+
+
+uint32_t VertexFormat::GetStride(const VERTEXLAYOUT& layout)
+{
+	std::vector<MESHATTRIBUTE> arrAttributes;
+	GetAttributes(layout, arrAttributes);
+
+	const MESHATTRIBUTE& last = arrAttributes.back();
+	return last.uOffset + MeshFile::GetAttributeSize(last);
+}
+
+
+void VertexFormat::GetAttributes(const VERTEXLAYOUT& layout, std::vector<MESHATTRIBUTE>& arrAttributes)
+{
+	arrAttributes.clear();
+
+	// half and int16 positions are padded to 8 bytes to keep the rest 4 byte aligned
+	uint32_t uOffset = 0;
+	switch (layout.ePosition)
+	{
+	case POSITION_FLOAT:
+		arrAttributes.push_back(MakeAttribute("position", MESHTYPE_FLOAT, 3, false, uOffset));
+		uOffset += 12;
+		break;
+	case POSITION_HALF:
+		arrAttributes.push_back(MakeAttribute("position", MESHTYPE_HALF, 3, false, uOffset));
+		uOffset += 8;
+		break;
+	case POSITION_INT16:
+		arrAttributes.push_back(MakeAttribute("position", MESHTYPE_INT16, 3, true, uOffset));
+		uOffset += 8;
+		break;
+	}
+
+	switch (layout.eNormal)
+	{
+	case NORMAL_FLOAT:
+		arrAttributes.push_back(MakeAttribute("normal", MESHTYPE_FLOAT, 3, false, uOffset));
+		uOffset += 12;
+		break;
+	case NORMAL_PACKED:
+		arrAttributes.push_back(MakeAttribute("normal", MESHTYPE_INT_2_10_10_10, 4, true, uOffset));
+		uOffset += 4;
+		break;
+	case NORMAL_OCTAHEDRAL:
+		arrAttributes.push_back(MakeAttribute("normal", MESHTYPE_INT16, 2, true, uOffset));
+		uOffset += 4;
+		break;
+	}
+
+	switch (layout.eUv)
+	{
+	case UV_FLOAT:
+		arrAttributes.push_back(MakeAttribute("uv", MESHTYPE_FLOAT, 2, false, uOffset));
+		break;
+	case UV_HALF:
+		arrAttributes.push_back(MakeAttribute("uv", MESHTYPE_HALF, 2, false, uOffset));
+		break;
+	}
+}
+
+
+void VertexFormat::Encode(const float* pVertices, size_t uVertexCount, const VERTEXLAYOUT& layout,
+	const float* pBoundsMin, const float* pBoundsMax, unsigned char* pOutput)
+{
+	std::vector<MESHATTRIBUTE> arrAttributes;
+	GetAttributes(layout, arrAttributes);
+	const uint32_t uStride = GetStride(layout);
+
+	float arrCenter[3] = { 0.0f, 0.0f, 0.0f };
+	float arrScale[3] = { 1.0f, 1.0f, 1.0f };
+	if (layout.ePosition == POSITION_INT16)
+	{
+		GetInt16Scale(pBoundsMin, pBoundsMax, arrCenter, arrScale);
+	}
+
+	memset(pOutput, 0, uVertexCount * uStride);
+	for (size_t i=0; i<uVertexCount; i++)
+	{
+		const float* pVertex = pVertices + i * 8;
+		unsigned char* pPosition = pOutput + i * uStride + arrAttributes[0].uOffset;
+		unsigned char* pNormal = pOutput + i * uStride + arrAttributes[1].uOffset;
+		unsigned char* pUv = pOutput + i * uStride + arrAttributes[2].uOffset;
+
+		uint16_t arrShorts[3];
+		switch (layout.ePosition)
+		{
+		case POSITION_FLOAT:
+			memcpy(pPosition, pVertex, sizeof(float) * 3);
+			break;
+		case POSITION_HALF:
+			for (uint32_t c=0; c<3; c++)
+			{
+				arrShorts[c] = FloatToHalf(pVertex[c]);
+			}
+			memcpy(pPosition, arrShorts, sizeof(arrShorts));
+			break;
+		case POSITION_INT16:
+			for (uint32_t c=0; c<3; c++)
+			{
+				arrShorts[c] = (uint16_t)ToInt16((pVertex[c] - arrCenter[c]) / arrScale[c]);
+			}
+			memcpy(pPosition, arrShorts, sizeof(arrShorts));
+			break;
+		}
+
+		const float* pN = pVertex + 3;
+		switch (layout.eNormal)
+		{
+		case NORMAL_FLOAT:
+			memcpy(pNormal, pN, sizeof(float) * 3);
+			break;
+		case NORMAL_PACKED:
+			{
+				const uint32_t uPacked = ToInt10(pN[0]) | (ToInt10(pN[1]) << 10) | (ToInt10(pN[2]) << 20);
+				memcpy(pNormal, &uPacked, sizeof(uPacked));
+			}
+			break;
+		case NORMAL_OCTAHEDRAL:
+			{
+				// project to the octahedron and fold the lower half over the diagonals
+				const float fLength = std::fabs(pN[0]) + std::fabs(pN[1]) + std::fabs(pN[2]);
+				float x = (fLength > 0.0f) ? pN[0] / fLength : 0.0f;
+				float y = (fLength > 0.0f) ? pN[1] / fLength : 0.0f;
+				if (pN[2] < 0.0f)
+				{
+					const float fx = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+					const float fy = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+					x = fx;
+					y = fy;
+				}
+				arrShorts[0] = (uint16_t)ToInt16(x);
+				arrShorts[1] = (uint16_t)ToInt16(y);
+				memcpy(pNormal, arrShorts, sizeof(uint16_t) * 2);
+			}
+			break;
+		}
+
+		switch (layout.eUv)
+		{
+		case UV_FLOAT:
+			memcpy(pUv, pVertex + 6, sizeof(float) * 2);
+			break;
+		case UV_HALF:
+			arrShorts[0] = FloatToHalf(pVertex[6]);
+			arrShorts[1] = FloatToHalf(pVertex[7]);
+			memcpy(pUv, arrShorts, sizeof(uint16_t) * 2);
+			break;
+		}
+	}
+}
+
+
+uint16_t VertexFormat::FloatToHalf(float fValue)
+{
+	uint32_t uBits;
+	memcpy(&uBits, &fValue, sizeof(uBits));
+
+	const uint32_t uSign = (uBits >> 16) & 0x8000;
+	const uint32_t uAbs = uBits & 0x7fffffff;
+	if (uAbs >= 0x7f800000)
+	{
+		// inf and nan
+		return (uint16_t)(uSign | 0x7c00 | ((uAbs > 0x7f800000) ? 0x200 : 0));
+	}
+	if (uAbs >= 0x477ff000)
+	{
+		// rounds above the largest half, 65504
+		return (uint16_t)(uSign | 0x7c00);
+	}
+	if (uAbs < 0x38800000)
+	{
+		// denormal half, let the float adder round the mantissa
+		float fAbs;
+		memcpy(&fAbs, &uAbs, sizeof(fAbs));
+		return (uint16_t)(uSign | (uint32_t)std::nearbyint(fAbs * 16777216.0f));
+	}
+
+	// rebias the exponent and round the mantissa to nearest even
+	const uint32_t uRounded = uAbs + 0xfff + ((uAbs >> 13) & 1);
+	return (uint16_t)(uSign | ((uRounded - 0x38000000) >> 13));
+}
+
+
+float VertexFormat::HalfToFloat(uint16_t uValue)
+{
+	const uint32_t uSign = (uint32_t)(uValue & 0x8000) << 16;
+	const uint32_t uExponent = (uValue >> 10) & 0x1f;
+	const uint32_t uMantissa = uValue & 0x3ff;
+
+	float fResult;
+	if (uExponent == 0)
+	{
+		fResult = std::ldexp((float)uMantissa, -24);
+		return uSign ? -fResult : fResult;
+	}
+
+	uint32_t uBits;
+	if (uExponent == 0x1f)
+	{
+		uBits = uSign | 0x7f800000 | (uMantissa << 13);
+	}
+	else
+	{
+		uBits = uSign | ((uExponent + 112) << 23) | (uMantissa << 13);
+	}
+	memcpy(&fResult, &uBits, sizeof(fResult));
+	return fResult;
+}
+
+
+void VertexFormat::GetInt16Scale(const float* pBoundsMin, const float* pBoundsMax, float* arrCenter, float* arrScale)
+{
+	for (uint32_t c=0; c<3; c++)
+	{
+		arrCenter[c] = (pBoundsMin[c] + pBoundsMax[c]) * 0.5f;
+		arrScale[c] = (pBoundsMax[c] - pBoundsMin[c]) * 0.5f;
+		if (arrScale[c] <= 0.0f)
+		{
+			arrScale[c] = 1.0f;
+		}
+	}
+}
@@ -69,8 +69,8 @@ void CTheApp::OnDestroy()
 {
 	// app is about to close, clear all resources
 
-	glDeleteTextures(1, &m_uTexture);
-	glDeleteProgram(m_uProgram);
+	GetOpenGLRenderer()->DeleteTexture(m_uTexture);
+	GetOpenGLRenderer()->DeleteProgram(m_uProgram);
 	glDeleteShader(m_uFragmentShader);
 	glDeleteShader(m_uVertexShader);
 
@@ -113,7 +113,7 @@ void CTheApp::OnDraw(IRenderer* pRenderer)
 	pRenderer->Clear(0.2f, 0.2f, 0.2f, 1.0f);
 
 	// setup the rendering of our quad
-	glUseProgram(m_uProgram);
+	GetOpenGLRenderer()->UseProgram(m_uProgram);
 
 	// find the locations of position and uv attributes in shader program
 	GLint position = glGetAttribLocation(m_uProgram, "position");
@@ -128,8 +128,7 @@ void CTheApp::OnDraw(IRenderer* pRenderer)
 	glVertexAttribPointer(uv, 2, GL_FLOAT, GL_FALSE, VERTEX::GetStride(), (float*)m_Quad + 3);
 
 	// set the texture for the quad (slot 0)
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_uTexture);
+	GetOpenGLRenderer()->BindTexture(0, m_uTexture);
 
 	// the textures are bind as uniforms into the shared program
 	GLint location = glGetUniformLocation(m_uProgram, "texture01");
@@ -141,8 +140,8 @@ void CTheApp::OnDraw(IRenderer* pRenderer)
 	glUniformMatrix4fv(mvp, 1, GL_FALSE, &modelViewProjectionMatrix[0][0]);
 
 	// set the alpha blending for the texture
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	GetOpenGLRenderer()->SetBlend(true);
+	GetOpenGLRenderer()->SetBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
 	// draw the quad
 	glDrawArrays(GL_TRIANGLES, 0, 6);
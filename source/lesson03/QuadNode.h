@@ -1,14 +1,18 @@
 #pragma once
 #include "../core/include/IGraphNode.h"
+#include "../core/include/InstanceBatch.h"
 
 class CQuadNode : public IGraphNode
 {
 public:
-	CQuadNode();
+	CQuadNode(const Geometry* pGeometry);
 	~CQuadNode();
 
-	static void Setup(GLuint uProgram, GLuint uTexture, float* pVertexData, int32_t iVertexStride);
+	void Draw(IRenderer* pRenderer, GLuint uProgram) override;
+	void GatherInstances(InstanceBatch& batch) override;
+	const Geometry* GetGeometry() const override { return m_pGeometry; }
 
-	void Render(IRenderer* pRenderer, GLuint uProgram) override;
+private:
+	const Geometry*		m_pGeometry;
 };
 
@@ -20,6 +20,9 @@ CTheApp::CTheApp()
 	m_uTexture = 0;
 
 	m_pSceneRoot = nullptr;
+	m_uQuadCount = SMALL_QUAD_COUNT;
+	m_fStatsTime = 0.0f;
+	m_uStatsFrames = 0;
 
 	// seed the random number generator
 	RandSeed();
@@ -43,15 +46,8 @@ bool CTheApp::OnCreate()
 		return false;
 	}
 
-	// declare the vertices for one quad
-	const float hw = 0.55f;
-	m_Quad[0] = VERTEX(-hw, hw, 0.0f,		0.0f, 0.0f);
-	m_Quad[1] = VERTEX(hw, hw, 0.0f,		1.0f, 0.0f);
-	m_Quad[2] = VERTEX(hw, -hw, 0.0f,		1.0f, 1.0f);
-
-	m_Quad[3] = VERTEX(-hw, hw, 0.0f,		0.0f, 0.0f);
-	m_Quad[4] = VERTEX(hw, -hw, 0.0f,		1.0f, 1.0f);
-	m_Quad[5] = VERTEX(-hw, -hw, 0.0f,		0.0f, 1.0f);
+	// generate the quad shared by all nodes
+	m_Quad.GenQuad(glm::vec2(1.1f, 1.1f), glm::vec3(0.0f, 0.0f, 0.0f));
 
 	// setup our view and projection matrices
 	GetRenderer()->SetViewMatrix(glm::lookAt(
@@ -60,23 +56,37 @@ bool CTheApp::OnCreate()
 		glm::vec3(0.0f, 1.0f, 0.0f)));
 	GetRenderer()->SetProjectionMatrix(glm::perspective(1.51f, GetAspect(), 0.1f, 500.0f));
 
+	CreateScene(m_uQuadCount);
+
+	return true;
+}
+
+
+void CTheApp::CreateScene(uint32_t uCount)
+{
+	if (m_pSceneRoot)
+	{
+		delete m_pSceneRoot;
+		m_pSceneRoot = nullptr;
+	}
+
 	// build the scenegraph
-	m_pSceneRoot = new CQuadNode();
+	m_pSceneRoot = new CQuadNode(&m_Quad);
 
 	// set some velocity and rotation to entire scene
 	m_pSceneRoot->SetVelocity(glm::vec3(0.0f, 0.0f, 1.0f));
 	m_pSceneRoot->SetRotationSpeed(0.1f);
 
-	// create some child nodes to the scene root
-	const int32_t count = 1500;
-	for (int32_t i=0; i<count; i++)
+	// create some child nodes to the scene root, spread over the same depth at any count
+	const float fDepthStep = 15.0f / uCount;
+	for (uint32_t i=0; i<uCount; i++)
 	{
-		CQuadNode* pNode = new CQuadNode();
+		CQuadNode* pNode = new CQuadNode(&m_Quad);
 
 		// set a random position for the nodes
 		pNode->SetPos(glm::linearRand(-10.0f, 10.0f),
 			glm::linearRand(-10.0f, 10.0f),
-			(i * 0.01f));
+			(i * fDepthStep));
 
 		// make some of the nodes rotate
 		if (glm::linearRand(0, 3) == 1)
@@ -88,8 +98,7 @@ bool CTheApp::OnCreate()
 		// note that ownership of the node is transfered and node is deleted by its owner
 		m_pSceneRoot->AddChild(pNode);
 	}
-
-	return true;
+	m_uQuadCount = uCount;
 }
 
 
@@ -102,8 +111,10 @@ void CTheApp::OnDestroy()
 		m_pSceneRoot = nullptr;
 	}
 
-	glDeleteTextures(1, &m_uTexture);
-	glDeleteProgram(m_uProgram);
+	m_Quad.Clear();
+
+	GetOpenGLRenderer()->DeleteTexture(m_uTexture);
+	GetOpenGLRenderer()->DeleteProgram(m_uProgram);
 	glDeleteShader(m_uFragmentShader);
 	glDeleteShader(m_uVertexShader);
 
@@ -136,6 +147,9 @@ void CTheApp::OnUpdate(float fFrametime)
 			m_pSceneRoot->SetPos(pos);
 			m_pSceneRoot->GetVelocity() = -m_pSceneRoot->GetVelocity();
 		}
+
+		// resolve the world matrices of the moved nodes once for drawing
+		m_pSceneRoot->UpdateWorldMatrices();
 	}
 }
 
@@ -145,15 +159,44 @@ void CTheApp::OnDraw(IRenderer* pRenderer)
 	// clear color, depth and stencil buffers
 	pRenderer->Clear(0.2f, 0.2f, 0.2f, 1.0f);
 
-	CQuadNode::Setup(m_uProgram, m_uTexture, (float*)m_Quad, VERTEX::GetStride());
+	// setup the rendering of our quads
+	GetOpenGLRenderer()->UseProgram(m_uProgram);
+
+	static const UniformId texture01Id = COpenGLRenderer::GetUniformId("texture01");
+	static const UniformId viewProjectionMatrixId = COpenGLRenderer::GetUniformId("viewProjectionMatrix");
+
+	// set the texture for the quads (slot 0)
+	GetOpenGLRenderer()->BindTexture(0, m_uTexture);
+	GetOpenGLRenderer()->SetUniform(m_uProgram, texture01Id, 0);
+
+	// the model matrix comes from the instance data, the rest is shared
+	glm::mat4 viewProjection = pRenderer->GetProjectionMatrix() * pRenderer->GetViewMatrix();
+	GetOpenGLRenderer()->SetUniform(m_uProgram, viewProjectionMatrixId, viewProjection);
 
 	// set the alpha blending for the texture
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	GetOpenGLRenderer()->SetBlend(true);
+	GetOpenGLRenderer()->SetBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
 	if (m_pSceneRoot)
 	{
-		m_pSceneRoot->Render(pRenderer, m_uProgram);
+		// draw the whole scene with a single instanced draw call
+		m_Batch.Clear();
+		m_pSceneRoot->GatherInstances(m_Batch);
+		m_Batch.Draw(GetOpenGLRenderer(), m_uProgram);
+	}
+
+	m_Quad.DisableAttribs(m_uProgram);
+
+	// report the batching and the average frame time once per second
+	m_fStatsTime += GetFrameTime();
+	++m_uStatsFrames;
+	if (m_fStatsTime > 1.0f)
+	{
+		IApplication::Debug("Instances: " + std::to_string(m_Batch.GetInstanceCount()) +
+			", draw calls: " + std::to_string(m_Batch.GetDrawCallCount()) +
+			", frame time: " + std::to_string(m_fStatsTime * 1000.0f / m_uStatsFrames) + " ms\n");
+		m_fStatsTime = 0.0f;
+		m_uStatsFrames = 0;
 	}
 }
 
@@ -192,6 +235,19 @@ bool CTheApp::OnKeyDown(uint32_t uKeyCode)
 		Close();
 		return true;
 	}
+	if (uKeyCode == KEY_SPACE)
+	{
+		// toggle between the lesson scene and the instancing stress test
+		if (m_uQuadCount == SMALL_QUAD_COUNT)
+		{
+			CreateScene(LARGE_QUAD_COUNT);
+		}
+		else
+		{
+			CreateScene(SMALL_QUAD_COUNT);
+		}
+		return true;
+	}
 
 	return false;
 }
@@ -14,30 +14,6 @@
 #include "QuadNode.h"
 
 
-struct VERTEX
-{
-	VERTEX()
-	{
-		x = 0.0f; y = 0.0f; z = 0.0f;
-		tu = 0.0f; tv = 0.0f;
-	}
-	VERTEX(float _x, float _y, float _z, float _tu, float _tv)
-	{
-		x = _x; y = _y; z = _z;
-		tu = _tu; tv = _tv;
-	}
-
-	/**
-	* GetStride
-	* @return number of bytes allocated by one vertex
-	*/
-	static int32_t GetStride() { return 20; }
-
-	float	x, y, z;
-	float	tu, tv;
-};
-
-
 class CTheApp : public IApplication
 {
 public:
@@ -122,11 +98,26 @@ private:
 	 */
 	COpenGLRenderer* GetOpenGLRenderer() { return static_cast<COpenGLRenderer*>(GetRenderer()); }
 
+	/**
+	 * CreateScene
+	 * replace the scenegraph with a root and uCount quads below it
+	 * @param uCount number of quads
+	 */
+	void CreateScene(uint32_t uCount);
+
 private:
 	// app data
 
-	// vertices for one (unindexed) quad
-	VERTEX			m_Quad[6];
+	// geometry shared by all quads
+	Geometry		m_Quad;
+
+	// quads collected for instanced drawing, space toggles the quad count
+	static const uint32_t SMALL_QUAD_COUNT = 1500;
+	static const uint32_t LARGE_QUAD_COUNT = 100000;
+	InstanceBatch	m_Batch;
+	uint32_t		m_uQuadCount;
+	float			m_fStatsTime;
+	uint32_t		m_uStatsFrames;
 
 	GLuint			m_uVertexShader;
 	GLuint			m_uFragmentShader;
@@ -1,11 +1,12 @@
 attribute vec3 position;
 attribute vec2 uv;
-uniform mat4 mvpMatrix;
+attribute mat4 instanceMatrix;
+uniform mat4 viewProjectionMatrix;
 varying vec2 outUv;
 
 void main(void)
 {
 	outUv = uv;
-	gl_Position = mvpMatrix * vec4(position, 1.0);
+	gl_Position = viewProjectionMatrix * instanceMatrix * vec4(position, 1.0);
 }
 
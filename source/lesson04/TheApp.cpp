@@ -75,8 +75,8 @@ bool CTheApp::OnCreate()
 void CTheApp::OnDestroy()
 {
 	// app is about to close, clear all resources
-	glDeleteTextures(1, &m_uTexture);
-	glDeleteProgram(m_uProgram);
+	GetOpenGLRenderer()->DeleteTexture(m_uTexture);
+	GetOpenGLRenderer()->DeleteProgram(m_uProgram);
 	glDeleteShader(m_uFragmentShader);
 	glDeleteShader(m_uVertexShader);
 
@@ -104,11 +104,10 @@ void CTheApp::OnDraw(IRenderer* pRenderer)
 	pRenderer->Clear(0.2f, 0.2f, 0.2f, 1.0f);
 
 	// render the sphere
-	glUseProgram(m_uProgram);
+	GetOpenGLRenderer()->UseProgram(m_uProgram);
 
 	// setup the texture for rendering
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_uTexture);
+	GetOpenGLRenderer()->BindTexture(0, m_uTexture);
 	GLint location = glGetUniformLocation(m_uProgram, "texture01");
 	glUniform1i(location, 0);
 
@@ -131,7 +130,7 @@ void CTheApp::OnDraw(IRenderer* pRenderer)
 	glUniform3f(lightDirection, dir.x, dir.y, dir.z);
 
 	// set material uniforms to program
-	m_Material.SetToProgram(m_uProgram);
+	m_Material.SetToProgram(GetOpenGLRenderer(), m_uProgram);
 
 	// draw the sphere
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
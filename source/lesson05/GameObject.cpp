@@ -28,82 +28,42 @@ void CGameObject::SetRandomRotationAxis()
 	axis.x = glm::linearRand(-1.0f, 1.0f);
 	axis.x = glm::linearRand(-1.0f, 1.0f);
 	axis.x = glm::linearRand(-1.0f, 1.0f);
-	m_vRotationAxis = glm::normalize(axis);
+	SetRotationAxis(glm::normalize(axis));
 }
 
 
-void CGameObject::Update(float fFrametime)
+void CGameObject::Draw(IRenderer* pRenderer, GLuint uProgram)
 {
-	IGraphNode::Update(fFrametime);
+	static const UniformId modelMatrixId = COpenGLRenderer::GetUniformId("modelMatrix");
+	static const UniformId modelViewProjectionMatrixId = COpenGLRenderer::GetUniformId("modelViewProjectionMatrix");
+	static const UniformId normalMatrixId = COpenGLRenderer::GetUniformId("normalMatrix");
+	COpenGLRenderer* pOpenGLRenderer = static_cast<COpenGLRenderer*>(pRenderer);
 
-	glm::vec3 pos = GetPos();
+	// transform lives in the pool of the app, world matrix is computed there
+	const glm::mat4& mWorld = GetWorldMatrix();
 
-	// add gravity to velocity
-	m_vVelocity.y -= fFrametime * 5.0f;
+	// int16 positions of a quantized geometry are scaled back to model space first
+	const glm::mat4 mModel(mWorld * m_pGeometry->GetPositionTransform());
 
-	// check limits
-	constexpr float limit = 10.0f;
-	if (pos.y < -limit)
-	{
-		pos.y = -limit;
-		m_vVelocity.y = -m_vVelocity.y;
-	}
-	if (pos.y > limit)
-	{
-		pos.y = limit;
-		m_vVelocity.y = -m_vVelocity.y;
-	}
-	if (pos.x < -limit)
-	{
-		pos.x = -limit;
-		m_vVelocity.x = -m_vVelocity.x;
-	}
-	if (pos.x > limit)
-	{
-		pos.x = limit;
-		m_vVelocity.x = -m_vVelocity.x;
-	}
-	if (pos.z < -limit)
-	{
-		pos.z = -limit;
-		m_vVelocity.z = -m_vVelocity.z;
-	}
-	if (pos.z > limit)
-	{
-		pos.z = limit;
-		m_vVelocity.z = -m_vVelocity.z;
-	}
+	// set model matrix to shader uniform
+	pOpenGLRenderer->SetUniform(uProgram, modelMatrixId, mModel);
 
-	SetPos(pos);
-}
+	// set model-view-projection matrix to shader uniform
+	glm::mat4 modelViewProjectionMatrix(pRenderer->GetProjectionMatrix() * pRenderer->GetViewMatrix() * mModel);
+	pOpenGLRenderer->SetUniform(uProgram, modelViewProjectionMatrixId, modelViewProjectionMatrix);
 
+	// set the normal matrix, normals are not affected by the position transform
+	glm::mat3 normalMatrix(glm::transpose(glm::inverse(mWorld)));
+	pOpenGLRenderer->SetUniform(uProgram, normalMatrixId, normalMatrix);
 
-void CGameObject::Render(IRenderer* pRenderer, GLuint uProgram)
-{
-	if (m_pGeometry)
+	// meshes loaded from a file pick their detail level by the distance to the camera
+	if (m_pGeometry->GetLodCount() > 1)
 	{
-		// set model matrix to shader uniform
-		GLint location = glGetUniformLocation(uProgram, "modelMatrix");
-		glUniformMatrix4fv(location, 1, GL_FALSE, &m_mModel[0][0]);
-
-		// set model-view-projection matrix to shader uniform
-		glm::mat4 modelViewProjectionMatrix(pRenderer->GetProjectionMatrix() * pRenderer->GetViewMatrix() * m_mModel);
-		location = glGetUniformLocation(uProgram, "modelViewProjectionMatrix");
-		glUniformMatrix4fv(location, 1, GL_FALSE, &modelViewProjectionMatrix[0][0]);
-
-		// set the normal matrix
-		glm::mat3 normalMatrix(glm::transpose(glm::inverse(m_mModel)));
-		location = glGetUniformLocation(uProgram, "normalMatrix");
-		glUniformMatrix3fv(location, 1, GL_FALSE, &normalMatrix[0][0]);
-
-		m_pGeometry->Draw(pRenderer);
+		const glm::vec3 campos(glm::inverse(pRenderer->GetViewMatrix())[3]);
+		m_pGeometry->SetLod(m_pGeometry->GetLodForDistance(glm::distance(campos, glm::vec3(mWorld[3]))));
 	}
 
-	int32_t i;
-	for (i=0; i<m_arrChildren.size(); i++)
-	{
-		m_arrChildren[i]->Render(pRenderer, uProgram);
-	}
+	m_pGeometry->Draw(pRenderer);
 }
 
 
@@ -24,12 +24,10 @@ public:
 	 * virtual drawing method of the game object
 	 * @param pRenderer pointer to renderer
 	 */
-	void Render(IRenderer* pRenderer, GLuint uProgram) override;
-
-	void Update(float fFrametime) override;
+	void Draw(IRenderer* pRenderer, GLuint uProgram) override;
 
 	inline void SetGeometry(Geometry* pGeometry) { m_pGeometry = pGeometry; }
-	inline Geometry* GetGeometry() { return m_pGeometry; }
+	inline Geometry* GetGeometry() const override { return m_pGeometry; }
 
 	void SetRandomRotationAxis();
 
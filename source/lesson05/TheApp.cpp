@@ -10,6 +10,8 @@
 
 #include "TheApp.h"
 #include "GameObject.h"
+#include "../core/include/TransformKernels.h"
+#include "../core/include/Timer.h"
 
 
 CTheApp::CTheApp()
@@ -20,7 +22,9 @@ CTheApp::CTheApp()
 	m_uProgram = 0;
 	m_uTexture = 0;
 
+	m_pGeometry = nullptr;
 	m_pSceneRoot = nullptr;
+	m_fStatsTime = 0.0f;
 
 	// seed the random number generator
 	RandSeed();
@@ -35,15 +39,6 @@ CTheApp::~CTheApp()
 bool CTheApp::OnCreate()
 {
 	// OnCreate is called by the application when window and graphics initialization is complete
-	m_uVertexShader = GetOpenGLRenderer()->CreateVertexShaderFromFile("phongshader.vs");
-	m_uFragmentShader = GetOpenGLRenderer()->CreateFragmentShaderFromFile("phongshader.fs");
-	m_uProgram = GetOpenGLRenderer()->CreateProgram(m_uVertexShader, m_uFragmentShader);
-	m_uTexture = GetOpenGLRenderer()->CreateTexture("earth.jpg");
-	if (!m_uVertexShader || !m_uFragmentShader || !m_uProgram || !m_uTexture)
-	{
-		return false;
-	}
-
 	// setup our view and projection matrices
 	glm::mat4 view = glm::lookAt(
 		glm::vec3(0.0f, 0.0f, 32.0f),
@@ -71,15 +66,65 @@ bool CTheApp::OnCreate()
 		24,
 		24);
 
+	// int16 positions, octahedral normals and half float uvs, 16 byte vertices.
+	// Sphere stays in floats if the driver lacks the types.
+	VERTEXLAYOUT layout;
+	layout.ePosition = POSITION_INT16;
+	layout.eNormal = NORMAL_OCTAHEDRAL;
+	m_Sphere.Quantize(layout);
+
+	// vertices live in the vertex buffer, no need for the cpu copy
+	m_Sphere.ReleaseVertexData();
+	m_pGeometry = &m_Sphere;
+	float objectRadius = radius;
+
+	// the objects use the mesh from the command line when there is one,
+	// time the load to see the cost of mapping and uploading the file
+	if (!m_strMeshFile.empty())
+	{
+		Timer timer;
+		timer.Create();
+		timer.BeginTimer();
+		const bool bLoaded = m_Mesh.Load(m_strMeshFile);
+		timer.EndTimer();
+		if (!bLoaded)
+		{
+			return false;
+		}
+		IApplication::Debug("Geometry::Load " + m_strMeshFile + ": " + std::to_string(timer.GetElapsedSeconds() * 1000.0f) + " ms, " +
+			std::to_string(m_Mesh.GetVertexCount()) + " vertices, " + std::to_string(m_Mesh.GetLodCount()) + " lods\n");
+
+		m_pGeometry = &m_Mesh;
+		objectRadius = m_Mesh.GetBoundingSphere().fRadius;
+	}
+
+	// the vertex shader decodes the normals only when the geometry has them octahedral
+	const std::string strDefines = m_pGeometry->HasOctahedralNormal() ? "#define OCTAHEDRAL_NORMAL\n" : "";
+	m_uVertexShader = GetOpenGLRenderer()->CreateVertexShaderFromFile("phongshader.vs", strDefines);
+	m_uFragmentShader = GetOpenGLRenderer()->CreateFragmentShaderFromFile("phongshader.fs");
+	m_uProgram = GetOpenGLRenderer()->CreateProgram(m_uVertexShader, m_uFragmentShader);
+	m_uTexture = GetOpenGLRenderer()->CreateTexture("earth.jpg");
+	if (!m_uVertexShader || !m_uFragmentShader || !m_uProgram || !m_uTexture)
+	{
+		return false;
+	}
+
 	// build scenegraph
 	m_pSceneRoot = new CGameObject();
 
+	constexpr int32_t objectCount = 25;
+	m_Transforms.Reserve(objectCount);
+
+	m_Jobs.Create();
+	m_Transforms.SetJobSystem(&m_Jobs);
+	m_Broadphase.SetJobSystem(&m_Jobs);
+
 	int32_t i;
-	for (i = 0; i < 25; i++)
+	for (i = 0; i < objectCount; i++)
 	{
 		CGameObject* pObject = new CGameObject;
-		pObject->SetGeometry(&m_Sphere);
-		pObject->SetRadius(radius);
+		pObject->SetGeometry(m_pGeometry);
+		pObject->SetRadius(objectRadius);
 		pObject->SetPos(glm::vec3(glm::linearRand(-10.0f, 10.0f),
 			glm::linearRand(-10.0f, 10.0f),
 			glm::linearRand(-10.0f, 10.0f)));
@@ -93,7 +138,16 @@ bool CTheApp::OnCreate()
 			glm::linearRand(-10.0f, 10.0f)));
 
 		m_pSceneRoot->AddChild(pObject);
+
+		// move the transform into the pool, root stays outside as it never moves
+		pObject->AttachTransform(m_Transforms);
 	}
+	m_Transforms.UpdateWorldMatrices();
+
+	// spheres move a fraction of a unit per frame, a half unit margin lets
+	// them stay in place in the tree for several frames
+	m_Bounds.SetMargin(0.5f);
+	m_pSceneRoot->RegisterBounds(m_Bounds);
 
 	return true;
 }
@@ -107,9 +161,13 @@ void CTheApp::OnDestroy()
 		delete m_pSceneRoot;
 		m_pSceneRoot = nullptr;
 	}
+	m_Transforms.Clear();
+	m_Bounds.Clear();
+	m_pGeometry = nullptr;
+	m_Jobs.Destroy();
 
-	glDeleteTextures(1, &m_uTexture);
-	glDeleteProgram(m_uProgram);
+	GetOpenGLRenderer()->DeleteTexture(m_uTexture);
+	GetOpenGLRenderer()->DeleteProgram(m_uProgram);
 	glDeleteShader(m_uFragmentShader);
 	glDeleteShader(m_uVertexShader);
 
@@ -122,157 +180,325 @@ void CTheApp::OnDestroy()
 
 void CTheApp::OnUpdate(float fFrametime)
 {
+	// all sphere transforms live in the pool, update them in linear sweeps
+	// instead of walking the scenegraph
+	m_Transforms.Integrate(fFrametime);
+	ApplyGravity(fFrametime);
+	CheckSphereToSphereCollisions();
+	m_Transforms.UpdateWorldMatrices();
+
 	if (m_pSceneRoot)
 	{
-		m_pSceneRoot->Update(fFrametime);
-		CheckSphereToSphereCollisions();
+		m_pSceneRoot->UpdateBounds();
 	}
 }
 
 
-void CTheApp::CheckSphereToSphereCollisions()
+void CTheApp::ApplyGravity(float fFrametime)
 {
-	std::vector<IGraphNode*>& arrChildren = m_pSceneRoot->GetChildren();
+	// objects are independent here, split them across the worker threads
+	constexpr uint32_t grainSize = 4096;
+	m_Jobs.ParallelFor(m_Transforms.GetCount(), grainSize, [this, fFrametime](uint32_t begin, uint32_t end)
+	{
+		ApplyGravity(begin, end, fFrametime);
+	});
+}
 
-	int32_t i;
-	for (i = 0; i < arrChildren.size(); i++)
+
+void CTheApp::ApplyGravity(uint32_t begin, uint32_t end, float fFrametime)
+{
+	glm::vec3* pPositions = m_Transforms.GetPositions();
+	glm::vec3* pVelocities = m_Transforms.GetVelocities();
+
+	constexpr float limit = 10.0f;
+
+	uint32_t i;
+	for (i = begin; i < end; i++)
 	{
-		CGameObject* pObject1 = static_cast<CGameObject*>(arrChildren.at(i));
+		glm::vec3& pos = pPositions[i];
+		glm::vec3& velocity = pVelocities[i];
+
+		// add gravity to velocity
+		velocity.y -= fFrametime * 5.0f;
 
-		int32_t j;
-		for (j = 0; j < arrChildren.size(); j++)
+		// check limits
+		int32_t axis;
+		for (axis = 0; axis < 3; axis++)
 		{
-			CGameObject* pObject2 = static_cast<CGameObject*>(arrChildren.at(j));
-			if (pObject1 != pObject2)
+			if (pos[axis] < -limit)
 			{
-				// calculate vector from object1 to object2
-				glm::vec3 pos1 = pObject1->GetPos();
-				glm::vec3 pos2 = pObject2->GetPos();
-				glm::vec3 d(pos2 - pos1);
+				pos[axis] = -limit;
+				velocity[axis] = -velocity[axis];
+			}
+			if (pos[axis] > limit)
+			{
+				pos[axis] = limit;
+				velocity[axis] = -velocity[axis];
+			}
+		}
+	}
+}
 
-				const float len = glm::length(d);
-				const float r = pObject1->GetRadius() + pObject2->GetRadius();
-				if (len < r)
-				{
-					// objects intersect
 
-					// calculate how much objects intersect
-					const float inside = (r - len) * 1.001f;
+void CTheApp::CheckSphereToSphereCollisions()
+{
+	glm::vec3* pPositions = m_Transforms.GetPositions();
+	glm::vec3* pVelocities = m_Transforms.GetVelocities();
+	float* pRotationSpeeds = m_Transforms.GetRotationSpeeds();
+	const float* pRadii = m_Transforms.GetRadii();
+	const uint32_t count = m_Transforms.GetCount();
+
+	// only pairs that the broadphase found overlapping, each of them once
+	m_Broadphase.Build(pPositions, pRadii, count);
+	const std::vector<SpatialHash::PAIR>& arrPairs = m_Broadphase.GetPairs();
+
+	size_t p;
+	for (p = 0; p < arrPairs.size(); p++)
+	{
+		const uint32_t i = arrPairs[p].uFirst;
+		const uint32_t j = arrPairs[p].uSecond;
+
+		// calculate vector from object1 to object2
+		glm::vec3& pos1 = pPositions[i];
+		glm::vec3& pos2 = pPositions[j];
+		glm::vec3 d(pos2 - pos1);
 
-					// normalize the d to use it as direction to move away from intersection
-					d = glm::normalize(d);
+		const float len = glm::length(d);
+		const float r = pRadii[i] + pRadii[j];
+		if (len < r)
+		{
+			// objects intersect
 
-					// move object positions away from intersection by half of the
-					// intersection distance
-					pos1 += d * -inside * 0.5f;
-					pos2 += d * inside * 0.5f;
+			// calculate how much objects intersect
+			const float inside = (r - len) * 1.001f;
 
-					pObject1->SetPos(pos1);
-					pObject2->SetPos(pos2);
+			// normalize the d to use it as direction to move away from intersection
+			d = glm::normalize(d);
 
+			// move object positions away from intersection by half of the
+			// intersection distance
+			pos1 += d * -inside * 0.5f;
+			pos2 += d * inside * 0.5f;
 
-					// rest of the collision response from gamasutra article:
-					// http://www.gamasutra.com/view/feature/131424/pool_hall_lessons_fast_accurate.php
 
-					float mass1 = 1.0f;
-					float mass2 = 1.0f;
+			// rest of the collision response from gamasutra article:
+			// http://www.gamasutra.com/view/feature/131424/pool_hall_lessons_fast_accurate.php
 
-					// Find the length of the component of each of the movement
-					// vectors along n. 
-					glm::vec3 v1 = pObject1->GetVelocity();
-					glm::vec3 v2 = pObject2->GetVelocity();
-					float a1 = glm::dot(v1, d);
-					float a2 = glm::dot(v2, d);
+			float mass1 = 1.0f;
+			float mass2 = 1.0f;
 
-					// Using the optimized version, 
-					// optimizedP =  2(a1 - a2)
-					//              -----------
-					//                m1 + m2
-					float optimizedP = (2.0f * (a1 - a2)) / (mass1 + mass2);
+			// Find the length of the component of each of the movement
+			// vectors along n. 
+			glm::vec3& v1 = pVelocities[i];
+			glm::vec3& v2 = pVelocities[j];
+			float a1 = glm::dot(v1, d);
+			float a2 = glm::dot(v2, d);
 
-					// Calculate v1', the new movement vector of circle1
-					v1 = v1 - optimizedP * mass2 * d;
+			// Using the optimized version, 
+			// optimizedP =  2(a1 - a2)
+			//              -----------
+			//                m1 + m2
+			float optimizedP = (2.0f * (a1 - a2)) / (mass1 + mass2);
 
-					// Calculate v2', the new movement vector of circle2
-					v2 = v2 + optimizedP * mass1 * d;
+			// Calculate v1', the new movement vector of circle1
+			v1 = v1 - optimizedP * mass2 * d;
 
-					pObject1->SetVelocity(v1);
-					pObject2->SetVelocity(v2);
+			// Calculate v2', the new movement vector of circle2
+			v2 = v2 + optimizedP * mass1 * d;
 
-					pObject1->SetRotationSpeed(glm::linearRand(-10.0f, 10.0f));
-					pObject2->SetRotationSpeed(glm::linearRand(-10.0f, 10.0f));
-				}
-			}
+			pRotationSpeeds[i] = glm::linearRand(-10.0f, 10.0f);
+			pRotationSpeeds[j] = glm::linearRand(-10.0f, 10.0f);
 		}
 	}
 }
 
 
+void CTheApp::RunBenchmark()
+{
+	constexpr int32_t objectCount = 100000;
+	constexpr int32_t frameCount = 20;
+	constexpr float frametime = 1.0f / 60.0f;
+
+	// same random objects into a scenegraph and into a transform pool
+	IGraphNode* pRoot = new CGameObject;
+	TransformPool pool;
+	pool.Reserve(objectCount);
+
+	int32_t i;
+	for (i = 0; i < objectCount; i++)
+	{
+		CGameObject* pObject = new CGameObject;
+		pObject->SetPos(glm::linearRand(glm::vec3(-10.0f), glm::vec3(10.0f)));
+		pObject->SetRandomRotationAxis();
+		pObject->SetRotationSpeed(glm::linearRand(-10.0f, 10.0f));
+		pObject->SetVelocity(glm::linearRand(glm::vec3(-10.0f), glm::vec3(10.0f)));
+		pRoot->AddChild(pObject);
+
+		const TransformHandle h = pool.Allocate(TransformPool::INVALID_HANDLE);
+		pool.SetLocalMatrix(h, pObject->GetMatrix());
+		pool.GetVelocity(h) = pObject->GetVelocity();
+		pool.GetRotationAxis(h) = pObject->GetRotationAxis();
+		pool.GetRotationSpeed(h) = pObject->GetRotationSpeed();
+	}
+
+	Timer timer;
+	timer.Create();
+
+	// per-node update walking the scenegraph
+	timer.BeginTimer();
+	for (i = 0; i < frameCount; i++)
+	{
+		pRoot->Update(frametime);
+		pRoot->UpdateWorldMatrices();
+	}
+	timer.EndTimer();
+	IApplication::Debug("Per-node update: " + std::to_string(timer.GetElapsedSeconds() * 1000.0f / frameCount) + " ms/frame\n");
+
+	// pool kernels with each instruction set the cpu supports
+	const SIMDLEVEL eLevel = TransformKernels::GetLevel();
+	int32_t level;
+	for (level = SIMD_SCALAR; level <= TransformKernels::GetBestLevel(); level++)
+	{
+		TransformKernels::SetLevel((SIMDLEVEL)level);
+
+		timer.BeginTimer();
+		for (i = 0; i < frameCount; i++)
+		{
+			pool.Integrate(frametime);
+			pool.UpdateWorldMatrices();
+		}
+		timer.EndTimer();
+		IApplication::Debug(std::string("Pool update ") + TransformKernels::GetLevelName((SIMDLEVEL)level) + ": " +
+			std::to_string(timer.GetElapsedSeconds() * 1000.0f / frameCount) + " ms/frame\n");
+	}
+	TransformKernels::SetLevel(eLevel);
+
+	// both again, split across the worker threads
+	pRoot->SetJobSystem(&m_Jobs);
+	timer.BeginTimer();
+	for (i = 0; i < frameCount; i++)
+	{
+		pRoot->Update(frametime);
+		pRoot->UpdateWorldMatrices();
+	}
+	timer.EndTimer();
+	IApplication::Debug("Per-node update, " + std::to_string(m_Jobs.GetWorkerCount() + 1) + " threads: " +
+		std::to_string(timer.GetElapsedSeconds() * 1000.0f / frameCount) + " ms/frame\n");
+
+	pool.SetJobSystem(&m_Jobs);
+	timer.BeginTimer();
+	for (i = 0; i < frameCount; i++)
+	{
+		pool.Integrate(frametime);
+		pool.UpdateWorldMatrices();
+	}
+	timer.EndTimer();
+	IApplication::Debug(std::string("Pool update ") + TransformKernels::GetLevelName(eLevel) + ", " + std::to_string(m_Jobs.GetWorkerCount() + 1) + " threads: " +
+		std::to_string(timer.GetElapsedSeconds() * 1000.0f / frameCount) + " ms/frame\n");
+
+	delete pRoot;
+
+	// broadphase for 50k spheres spread out about as densely as the lesson scene
+	constexpr uint32_t sphereCount = 50000;
+	std::vector<glm::vec3> arrPositions(sphereCount);
+	std::vector<float> arrRadii(sphereCount, 0.5f);
+	uint32_t s;
+	for (s = 0; s < sphereCount; s++)
+	{
+		arrPositions[s] = glm::linearRand(glm::vec3(-50.0f), glm::vec3(50.0f));
+	}
+
+	SpatialHash broadphase;
+	int32_t pass;
+	for (pass = 0; pass < 2; pass++)
+	{
+		// second pass splits the pair search across the worker threads
+		broadphase.SetJobSystem((pass == 0) ? nullptr : &m_Jobs);
+		const uint32_t threads = (pass == 0) ? 1 : m_Jobs.GetWorkerCount() + 1;
+
+		timer.BeginTimer();
+		for (i = 0; i < frameCount; i++)
+		{
+			broadphase.Build(arrPositions.data(), arrRadii.data(), sphereCount);
+		}
+		timer.EndTimer();
+		IApplication::Debug("Broadphase " + std::to_string(sphereCount) + " spheres, " + std::to_string(threads) + " threads: " +
+			std::to_string(timer.GetElapsedSeconds() * 1000.0f / frameCount) + " ms/frame, " +
+			std::to_string(broadphase.GetPairs().size()) + " pairs\n");
+	}
+
+	// same spheres in the AABB tree, overlapping fat boxes are only candidate pairs
+	AABBTree tree;
+	tree.SetMargin(0.1f);
+	for (s = 0; s < sphereCount; s++)
+	{
+		tree.CreateProxy(AABB(arrPositions[s] - arrRadii[s], arrPositions[s] + arrRadii[s]), nullptr);
+	}
+
+	std::vector<AABBTree::PAIR> arrPairs;
+	timer.BeginTimer();
+	for (i = 0; i < frameCount; i++)
+	{
+		tree.QueryPairs(arrPairs);
+	}
+	timer.EndTimer();
+	IApplication::Debug("AABB tree " + std::to_string(sphereCount) + " spheres, height " + std::to_string(tree.GetHeight()) + ": " +
+		std::to_string(timer.GetElapsedSeconds() * 1000.0f / frameCount) + " ms/frame, " +
+		std::to_string(arrPairs.size()) + " candidate pairs\n");
+}
+
+
 void CTheApp::OnDraw(IRenderer* pRenderer)
 {
 	// clear depth and stencil buffers
 	pRenderer->Clear(0.2f, 0.2f, 0.2f, 1.0f);
 
+	Geometry::ResetCallsSaved();
+
 	// render the sphere
-	glUseProgram(m_uProgram);
-
-	// get the vertex attribute locations
-	GLint position = glGetAttribLocation(m_uProgram, "position");
-	GLint normal = glGetAttribLocation(m_uProgram, "normal");
-	GLint uv = glGetAttribLocation(m_uProgram, "uv");
-
-	// set the vertex position
-	glEnableVertexAttribArray(position);
-	glVertexAttribPointer(
-		position,
-		3,
-		GL_FLOAT,
-		GL_FALSE,
-		VERTEX::GetStride(),
-		m_Sphere.GetData());
-
-	// vertex normal
-	glEnableVertexAttribArray(normal);
-	glVertexAttribPointer(
-		normal,
-		3,
-		GL_FLOAT,
-		GL_FALSE,
-		VERTEX::GetStride(),
-		(char*)((float*)m_Sphere.GetData() + 3));
-
-	// vertex uv
-	glEnableVertexAttribArray(uv);
-	glVertexAttribPointer(
-		uv,
-		2,
-		GL_FLOAT,
-		GL_FALSE,
-		VERTEX::GetStride(),
-		(char*)((float*)m_Sphere.GetData() + 6));
+	GetOpenGLRenderer()->UseProgram(m_uProgram);
+
+	// set the vertex attributes from the vertex buffer of the sphere or the mesh
+	m_pGeometry->SetAttribs(m_uProgram);
+
+	static const UniformId texture01Id = COpenGLRenderer::GetUniformId("texture01");
+	static const UniformId lightPositionId = COpenGLRenderer::GetUniformId("lightPosition");
+	static const UniformId cameraPositionId = COpenGLRenderer::GetUniformId("cameraPosition");
 
 	// setup the texture for rendering
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_uTexture);
-	GLint location = glGetUniformLocation(m_uProgram, "texture01");
-	glUniform1i(location, 0);
+	GetOpenGLRenderer()->BindTexture(0, m_uTexture);
+	GetOpenGLRenderer()->SetUniform(m_uProgram, texture01Id, 0);
 
 	// setup the light position
 	glm::vec3 lightPos(0.0f, 0.0f, 15.0f);
-	location = glGetUniformLocation(m_uProgram, "lightPosition");
-	glUniform3f(location, lightPos.x, lightPos.y, lightPos.z);
+	GetOpenGLRenderer()->SetUniform(m_uProgram, lightPositionId, lightPos);
 
 	// setup the camera position
 	glm::vec3 campos(-pRenderer->GetViewMatrix()[3]);
-	location = glGetUniformLocation(m_uProgram, "cameraPosition");
-	glUniform3f(location, campos.x, campos.y, campos.z);
+	GetOpenGLRenderer()->SetUniform(m_uProgram, cameraPositionId, campos);
 
 	// set material uniforms to program
-	m_Material.SetToProgram(m_uProgram);
+	m_Material.SetToProgram(GetOpenGLRenderer(), m_uProgram);
 
-	if (m_pSceneRoot)
+	// render only the spheres the tree finds inside the view frustum,
+	// they have no children so each of them draws just itself
+	const FRUSTUM frustum(pRenderer->GetProjectionMatrix() * pRenderer->GetViewMatrix());
+	m_Bounds.QueryFrustum(frustum, m_arrVisible);
+
+	size_t i;
+	for (i = 0; i < m_arrVisible.size(); i++)
 	{
-		m_pSceneRoot->Render(pRenderer, m_uProgram);
+		IGraphNode* pNode = static_cast<IGraphNode*>(m_Bounds.GetUserData(m_arrVisible[i]));
+		pNode->Render(pRenderer, m_uProgram);
+	}
+
+	// report the driver calls saved by the geometry vertex arrays once per second
+	m_fStatsTime += GetFrameTime();
+	if (m_fStatsTime > 1.0f)
+	{
+		m_fStatsTime = 0.0f;
+		IApplication::Debug("Driver calls saved per frame: " + std::to_string(Geometry::GetCallsSaved()) +
+			", visible objects: " + std::to_string(m_arrVisible.size()) + "/" + std::to_string(m_Bounds.GetProxyCount()) + "\n");
 	}
 }
 
@@ -312,6 +538,11 @@ bool CTheApp::OnKeyDown(uint32_t uKeyCode)
 		Close();
 		return true;
 	}
+	if (uKeyCode == KEY_SPACE)
+	{
+		RunBenchmark();
+		return true;
+	}
 
 	return false;
 }
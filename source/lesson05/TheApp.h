@@ -15,6 +15,10 @@
 #include "../core/include/Geometry.h"
 #include "../core/include/Material.h"
 #include "../core/include/IGraphNode.h"
+#include "../core/include/TransformPool.h"
+#include "../core/include/JobSystem.h"
+#include "../core/include/SpatialHash.h"
+#include "../core/include/AABBTree.h"
 
 
 // forward declare game object
@@ -53,6 +57,14 @@ public:
 	 */
 	void OnDraw(IRenderer* pRenderer) override;
 
+	/**
+	 * SetMeshFile
+	 * draw a mesh file written by meshconv instead of the generated sphere,
+	 * call before Create
+	 * @param strFilename mesh file, empty for the sphere
+	 */
+	inline void SetMeshFile(const std::string& strFilename) { m_strMeshFile = strFilename; }
+
 protected:
 	/**
 	 * OnScreenSizeChanged
@@ -105,8 +117,26 @@ private:
 	COpenGLRenderer* GetOpenGLRenderer() { return static_cast<COpenGLRenderer*>(GetRenderer()); }
 
 private:
+	/**
+	 * ApplyGravity
+	 * add gravity to the velocities and bounce objects back inside the box,
+	 * one linear sweep over the transform pool
+	 * @param fFrametime frame delta time
+	 */
+	void ApplyGravity(float fFrametime);
+	void ApplyGravity(uint32_t begin, uint32_t end, float fFrametime);
+
 	void CheckSphereToSphereCollisions();
 
+	/**
+	 * RunBenchmark
+	 * time the per-node scenegraph update against the transform pool
+	 * kernels for a large number of objects, on one and on all threads,
+	 * and the spatial hash and AABB tree for a large number of spheres.
+	 * Print the results.
+	 */
+	void RunBenchmark();
+
 	GLuint						m_uVertexShader;
 	GLuint						m_uFragmentShader;
 	GLuint						m_uProgram;
@@ -116,6 +146,27 @@ private:
 	Geometry					m_Sphere;
 	Material					m_Material;
 
+	// mesh loaded from m_strMeshFile, drawn instead of the sphere when set
+	std::string					m_strMeshFile;
+	Geometry					m_Mesh;
+	Geometry*					m_pGeometry;
+
 	IGraphNode*					m_pSceneRoot;
+
+	// transforms of the spheres, stored in contiguous arrays
+	TransformPool				m_Transforms;
+
+	// runs the transform sweeps on all cores
+	JobSystem					m_Jobs;
+
+	// finds the overlapping sphere pairs each frame
+	SpatialHash					m_Broadphase;
+
+	// world bounds of the spheres, culled against the view frustum
+	AABBTree					m_Bounds;
+	std::vector<int32_t>		m_arrVisible;
+
+	// time since previous statistics report
+	float						m_fStatsTime;
 };
 
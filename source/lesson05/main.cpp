@@ -20,6 +20,18 @@ int main(int argc, char** argv)
 {
 	// create the app instance
 	CTheApp* pApp = new CTheApp;
+
+	// optional mesh file written by meshconv replaces the generated sphere
+#if defined (_WINDOWS)
+	pApp->SetMeshFile(pCmdLine);
+#endif
+#if defined (_LINUX)
+	if (argc > 1)
+	{
+		pApp->SetMeshFile(argv[1]);
+	}
+#endif
+
 	if (!pApp->Create(1280, 720, "SuperGame"))
 	{
 		// something went wrong in initialization, exit
@@ -1,5 +1,9 @@
 attribute vec3 position;
+#ifdef OCTAHEDRAL_NORMAL
+attribute vec2 normal;
+#else
 attribute vec3 normal;
+#endif
 attribute vec2 uv;
 
 uniform mat4		modelViewProjectionMatrix;
@@ -10,12 +14,28 @@ varying vec2 outUv;
 varying vec3 eyespacePosition;
 varying vec3 eyespaceNormal;
 
+#ifdef OCTAHEDRAL_NORMAL
+// unfold the octahedron encoding of VertexFormat NORMAL_OCTAHEDRAL
+vec3 DecodeNormal(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (n.z < 0.0)
+	{
+		n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return normalize(n);
+}
+#endif
+
 void main(void)
 {
 	vec4 vertexPosition = vec4(position, 1.0);
 	outUv = uv;
 	eyespacePosition = (modelMatrix * vertexPosition).xyz;
+#ifdef OCTAHEDRAL_NORMAL
+	eyespaceNormal = normalMatrix * DecodeNormal(normal);
+#else
 	eyespaceNormal = normalMatrix * normal;
+#endif
 	gl_Position = modelViewProjectionMatrix * vertexPosition;
 }
-
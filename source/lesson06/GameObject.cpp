@@ -16,6 +16,7 @@ CGameObject::CGameObject()
 {
 	m_pGeometry = nullptr;
 	m_pMaterial = nullptr;
+	m_pTextures = nullptr;
 
 	m_fRotationAngle = glm::linearRand(0.0f, 6.0f);
 	SetRotationSpeed(glm::linearRand(-10.0f, 10.0f));
@@ -77,46 +78,53 @@ void CGameObject::Update(float fFrametime)
 		m_vVelocity.z = -m_vVelocity.z;
 	}
 
-	m_mModel[3][0] = pos.x;
-	m_mModel[3][1] = pos.y;
-	m_mModel[3][2] = pos.z;
+	SetPos(pos);
 }
 
 
-void CGameObject::Render(IRenderer* pRenderer, GLuint uProgram)
+void CGameObject::Draw(IRenderer* pRenderer, GLuint uProgram)
 {
-	if (m_pGeometry)
-	{
-		m_pGeometry->SetAttribs(uProgram);
+	static const UniformId modelMatrixId = COpenGLRenderer::GetUniformId("modelMatrix");
+	static const UniformId modelViewProjectionMatrixId = COpenGLRenderer::GetUniformId("modelViewProjectionMatrix");
+	static const UniformId normalMatrixId = COpenGLRenderer::GetUniformId("normalMatrix");
+	COpenGLRenderer* pOpenGLRenderer = static_cast<COpenGLRenderer*>(pRenderer);
 
-		// set model matrix to shader uniform
-		GLint location = glGetUniformLocation(uProgram, "modelMatrix");
-		glUniformMatrix4fv(location, 1, GL_FALSE, &m_mModel[0][0]);
+	m_pGeometry->SetAttribs(uProgram);
 
-		// set model-view-projection matrix to shader uniform
-		glm::mat4 modelViewProjectionMatrix(pRenderer->GetProjectionMatrix() * pRenderer->GetViewMatrix() * m_mModel);
-		location = glGetUniformLocation(uProgram, "modelViewProjectionMatrix");
-		glUniformMatrix4fv(location, 1, GL_FALSE, &modelViewProjectionMatrix[0][0]);
+	// set model matrix to shader uniform
+	pOpenGLRenderer->SetUniform(uProgram, modelMatrixId, m_mModel);
 
-		// set the normal matrix
-		glm::mat3 normalMatrix(glm::transpose(glm::inverse(m_mModel)));
-		location = glGetUniformLocation(uProgram, "normalMatrix");
-		glUniformMatrix3fv(location, 1, GL_FALSE, &normalMatrix[0][0]);
+	// set model-view-projection matrix to shader uniform
+	glm::mat4 modelViewProjectionMatrix(pRenderer->GetProjectionMatrix() * pRenderer->GetViewMatrix() * m_mModel);
+	pOpenGLRenderer->SetUniform(uProgram, modelViewProjectionMatrixId, modelViewProjectionMatrix);
 
-		// set the material
-		if (m_pMaterial)
-		{
-			m_pMaterial->SetToProgram(uProgram);
-		}
+	// set the normal matrix
+	glm::mat3 normalMatrix(glm::transpose(glm::inverse(m_mModel)));
+	pOpenGLRenderer->SetUniform(uProgram, normalMatrixId, normalMatrix);
 
-		m_pGeometry->Draw(pRenderer);
+	// set the material
+	if (m_pMaterial)
+	{
+		m_pMaterial->SetToProgram(pOpenGLRenderer, uProgram);
 	}
 
-	int32_t i;
-	for (i=0; i<m_arrChildren.size(); i++)
+	m_pGeometry->Draw(pRenderer);
+}
+
+
+void CGameObject::Enqueue(RenderQueue& queue, GLuint uProgram)
+{
+	// objects out of view do not get a draw packet
+	if (!IsSubtreeVisible())
 	{
-		m_arrChildren[i]->Render(pRenderer, uProgram);
+		return;
 	}
-}
 
+	if (m_pGeometry && IsVisible())
+	{
+		queue.Add(uProgram, m_pTextures, m_pMaterial, m_pGeometry, GetWorldMatrix());
+	}
+
+	IGraphNode::Enqueue(queue, uProgram);
+}
 
@@ -13,6 +13,7 @@
 #include "../core/include/Geometry.h"
 #include "../core/include/IGraphNode.h"
 #include "../core/include/Material.h"
+#include "../core/include/RenderQueue.h"
 
 
 class CGameObject : public IGraphNode
@@ -22,26 +23,38 @@ public:
 	~CGameObject();
 
 	/**
-	 * Render
+	 * Draw
 	 * virtual drawing method of the game object
 	 * @param pRenderer pointer to renderer
 	 */
-	void Render(IRenderer* pRenderer, GLuint uProgram) override;
+	void Draw(IRenderer* pRenderer, GLuint uProgram) override;
+
+	/**
+	 * Enqueue
+	 * add the game object into the render queue
+	 * @param queue queue to add the draw packet into
+	 * @param uProgram handle to shader program
+	 */
+	void Enqueue(RenderQueue& queue, GLuint uProgram) override;
 
 	void Update(float fFrametime) override;
 
 	inline float GetGravity() const { return m_fGravity; }
 	inline void SetGravity(float fGravity) { m_fGravity = fGravity; }
 
-	Geometry* GetGeometry() const { return m_pGeometry; }
+	Geometry* GetGeometry() const override { return m_pGeometry; }
 	void SetGeometry(Geometry* pGeometry) { m_pGeometry = pGeometry; }
 
 	Material* GetMaterial() { return m_pMaterial; }
 	void SetMaterial(Material* pMaterial) { m_pMaterial = pMaterial; }
 
+	const TEXTURESET* GetTextures() const { return m_pTextures; }
+	void SetTextures(const TEXTURESET* pTextures) { m_pTextures = pTextures; }
+
 protected:
 	Geometry*					m_pGeometry;
 	Material*					m_pMaterial;
+	const TEXTURESET*			m_pTextures;
 
 	float						m_fGravity;
 };
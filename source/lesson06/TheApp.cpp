@@ -10,6 +10,8 @@
 
 #include "TheApp.h"
 #include "GameObject.h"
+#include "../core/include/PixelKernels.h"
+#include "../core/include/stb_image.h"
 
 
 CTheApp::CTheApp()
@@ -24,6 +26,7 @@ CTheApp::CTheApp()
 	m_uTextures[3] = 0;
 
 	m_fUvOffset = 0.0f;
+	m_fStatsTime = 0.0f;
 
 	m_pSceneRoot = nullptr;
 
@@ -43,18 +46,36 @@ bool CTheApp::OnCreate()
 	m_uVertexShader = GetOpenGLRenderer()->CreateVertexShaderFromFile("multitexturing.vs");
 	m_uFragmentShader = GetOpenGLRenderer()->CreateFragmentShaderFromFile("multitexturing.fs");
 	m_uProgram = GetOpenGLRenderer()->CreateProgram(m_uVertexShader, m_uFragmentShader);
-	m_uTextures[0] = GetOpenGLRenderer()->CreateTexture("earth.jpg");
-	m_uTextures[1] = GetOpenGLRenderer()->CreateTexture("hex.jpg");
-	m_uTextures[2] = GetOpenGLRenderer()->CreateTexture("clouds.jpg");
-	m_uTextures[3] = GetOpenGLRenderer()->CreateTexture("earth_specular.jpg");
 	if (!m_uVertexShader || !m_uFragmentShader || !m_uProgram)
 	{
 		return false;
 	}
-	if (!m_uTextures[0] || !m_uTextures[1] || !m_uTextures[2] || !m_uTextures[3])
-	{
-		return false;
-	}
+
+	// textures show a placeholder until the workers have decoded them
+	m_Jobs.Create();
+	m_TextureLoader.Create(GetOpenGLRenderer(), &m_Jobs);
+
+	// uv offset scrolls the textures, they repeat
+	TEXTUREPARAMS params;
+	params.eMipmaps = MIPMAPS_BOX;
+	params.eFilter = FILTER_TRILINEAR;
+	params.fAnisotropy = 4.0f;
+	params.eWrap = GL_REPEAT;
+	m_uTextures[0] = m_TextureLoader.Load("earth.jpg", params);
+	m_uTextures[1] = m_TextureLoader.Load("hex.jpg", params);
+	m_uTextures[2] = m_TextureLoader.Load("clouds.jpg", params);
+	m_uTextures[3] = m_TextureLoader.Load("earth_specular.jpg", params);
+
+	// cube is wrapped with hex pattern, sphere with clouds
+	m_TextureSets[0].arrTextures[0] = m_uTextures[0];
+	m_TextureSets[0].arrTextures[1] = m_uTextures[1];
+	m_TextureSets[0].arrTextures[2] = m_uTextures[3];
+	m_TextureSets[0].uCount = 3;
+
+	m_TextureSets[1].arrTextures[0] = m_uTextures[0];
+	m_TextureSets[1].arrTextures[1] = m_uTextures[2];
+	m_TextureSets[1].arrTextures[2] = m_uTextures[3];
+	m_TextureSets[1].uCount = 3;
 
 	// setup our view and projection matrices
 	glm::mat4 view = glm::lookAt(
@@ -79,12 +100,14 @@ bool CTheApp::OnCreate()
 	CGameObject* pCube = new CGameObject;
 	pCube->SetPos(-2.5f, 0.0f, 0.0f);
 	pCube->SetGeometry(&m_Cube);
+	pCube->SetTextures(&m_TextureSets[0]);
 	m_pSceneRoot->AddChild(pCube);
 
 	// spawn a sphere
 	CGameObject* pSphere = new CGameObject;
 	pSphere->SetPos(2.5f, 0.0f, 0.0f);
 	pSphere->SetGeometry(&m_Sphere);
+	pSphere->SetTextures(&m_TextureSets[1]);
 	m_pSceneRoot->AddChild(pSphere);
 
 
@@ -97,6 +120,9 @@ bool CTheApp::OnCreate()
 		pGameObject->SetMaterial(&m_Material);
 	}
 
+	// children of the root do not touch each other, update them in parallel
+	m_pSceneRoot->SetJobSystem(&m_Jobs);
+
 	return true;
 }
 
@@ -109,9 +135,14 @@ void CTheApp::OnDestroy()
 		delete m_pSceneRoot;
 		m_pSceneRoot = nullptr;
 	}
+	m_TextureLoader.Release();
+	m_Jobs.Destroy();
 
-	glDeleteTextures(4, m_uTextures);
-	glDeleteProgram(m_uProgram);
+	for (int32_t i = 0; i < 4; i++)
+	{
+		GetOpenGLRenderer()->DeleteTexture(m_uTextures[i]);
+	}
+	GetOpenGLRenderer()->DeleteProgram(m_uProgram);
 	glDeleteShader(m_uFragmentShader);
 	glDeleteShader(m_uVertexShader);
 
@@ -126,6 +157,7 @@ void CTheApp::OnUpdate(float fFrametime)
 	if (m_pSceneRoot)
 	{
 		m_pSceneRoot->Update(fFrametime);
+		m_pSceneRoot->UpdateWorldMatrices();
 	}
 
 	// animate our texture uv2 offset
@@ -139,89 +171,158 @@ void CTheApp::OnUpdate(float fFrametime)
 
 void CTheApp::OnDraw(IRenderer* pRenderer)
 {
+	// upload at most 2 MB of decoded texture data per frame
+	if (m_TextureLoader.GetPendingCount())
+	{
+		m_TextureLoader.Update(2 * 1024 * 1024);
+	}
+
 	// clear depth and stencil buffers
 	pRenderer->Clear(0.2f, 0.2f, 0.2f, 1.0f);
 
-	// render the sphere
-	glUseProgram(m_uProgram);
+	static const UniformId lightPositionId = COpenGLRenderer::GetUniformId("lightPosition");
+	static const UniformId cameraPositionId = COpenGLRenderer::GetUniformId("cameraPosition");
+	static const UniformId uvOffsetId = COpenGLRenderer::GetUniformId("uvOffset");
+
+	// render the scene
+	GetOpenGLRenderer()->UseProgram(m_uProgram);
 
 	// setup the light position
 	const glm::vec3& lightPosition = pRenderer->GetLightPos();
-	GLint location = glGetUniformLocation(m_uProgram, "lightPosition");
-	glUniform3f(location, lightPosition.x, lightPosition.y, lightPosition.z);
+	GetOpenGLRenderer()->SetUniform(m_uProgram, lightPositionId, lightPosition);
 
 	// setup the camera position
 	glm::vec3 campos(-pRenderer->GetViewMatrix()[3]);
-	location = glGetUniformLocation(m_uProgram, "cameraPosition");
-	glUniform3f(location, campos.x, campos.y, campos.z);
+	GetOpenGLRenderer()->SetUniform(m_uProgram, cameraPositionId, campos);
 
 	// set the uv2 offset uniform
-	location = glGetUniformLocation(m_uProgram, "uvOffset");
-	glUniform1f(location, m_fUvOffset);
+	GetOpenGLRenderer()->SetUniform(m_uProgram, uvOffsetId, m_fUvOffset);
 
-	glDisable(GL_BLEND);
+	GetOpenGLRenderer()->SetBlend(false);
 
 	if (m_pSceneRoot)
 	{
-		int32_t i;
-		std::vector<IGraphNode*>& arrChildren = m_pSceneRoot->GetChildren();
-		for (i = 0; i < arrChildren.size(); i++)
+		// collect the objects in view, sort them by state and draw
+		IGraphNode::BeginCulling(pRenderer->GetProjectionMatrix() * pRenderer->GetViewMatrix());
+		m_RenderQueue.Clear();
+		m_pSceneRoot->Enqueue(m_RenderQueue, m_uProgram);
+		IGraphNode::EndCulling();
+		m_RenderQueue.Sort();
+		m_RenderQueue.Submit(GetOpenGLRenderer());
+
+		/**
+		 * Your turn to code:
+		 * - Add 3rd texture to program, make it a grayscale version of earth texture
+		 * - Apply the 3rd texture in a shader as specular map
+		 * - Specular map determines which parts of the object are shine and which are not
+		 *
+		 */
+	}
+
+	// report the state changes once per second
+	m_fStatsTime += GetFrameTime();
+	if (m_fStatsTime > 1.0f)
+	{
+		m_fStatsTime = 0.0f;
+		IApplication::Debug("State changes unsorted: " + std::to_string(m_RenderQueue.GetUnsortedStateChanges()) +
+			", sorted: " + std::to_string(m_RenderQueue.GetSortedStateChanges()) + "\n");
+
+		const IGraphNode::CULLSTATS& stats = IGraphNode::GetCullStats();
+		IApplication::Debug("Nodes visited: " + std::to_string(stats.uVisited) +
+			", culled: " + std::to_string(stats.uCulled) +
+			", drawn: " + std::to_string(stats.uDrawn) + "\n");
+	}
+}
+
+
+void CTheApp::RunBenchmark()
+{
+	constexpr int32_t runCount = 10;
+
+	struct IMAGE
+	{
+		std::string					strName;
+		std::vector<unsigned char>	arrPixels;
+	};
+	std::vector<IMAGE> arrImages;
+
+	// the lesson images are opaque, the scalar loop skips those pixels
+	const char* arrFiles[] = { "earth.jpg", "hex.jpg", "clouds.jpg", "earth_specular.jpg" };
+	int32_t i;
+	for (i = 0; i < 4; i++)
+	{
+		int width = 0;
+		int height = 0;
+		int bpp = 0;
+		unsigned char* pPixels = stbi_load(arrFiles[i], &width, &height, &bpp, STBI_rgb_alpha);
+		if (pPixels)
 		{
-			// setup the texture for rendering
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, m_uTextures[0]);
-			location = glGetUniformLocation(m_uProgram, "texture01");
-			glUniform1i(location, 0);
-			SetTexturingParams();
-
-			if (i == 0)
+			IMAGE image;
+			image.strName = std::string(arrFiles[i]) + " " + std::to_string(width) + "x" + std::to_string(height);
+			image.arrPixels.assign(pPixels, pPixels + (size_t)width * height * 4);
+			arrImages.push_back(image);
+			stbi_image_free(pPixels);
+		}
+	}
+
+	// worst case for the scalar loop, every pixel needs the multiply
+	IMAGE image;
+	image.strName = "random alpha 4096x4096";
+	image.arrPixels.resize((size_t)4096 * 4096 * 4);
+	for (size_t p = 0; p < image.arrPixels.size(); p++)
+	{
+		image.arrPixels[p] = (unsigned char)glm::linearRand(0, 255);
+	}
+	arrImages.push_back(image);
+
+	Timer timer;
+	timer.Create();
+
+	const SIMDLEVEL eLevel = PixelKernels::GetLevel();
+	std::vector<unsigned char> arrReference;
+	std::vector<unsigned char> arrResult;
+	uint32_t img;
+	for (img = 0; img < arrImages.size(); img++)
+	{
+		const std::vector<unsigned char>& arrSource = arrImages[img].arrPixels;
+		const size_t uPixelCount = arrSource.size() / 4;
+
+		// each instruction set on one thread, then the best one on all threads
+		int32_t pass;
+		for (pass = SIMD_SCALAR; pass <= eLevel + 1; pass++)
+		{
+			const bool bThreaded = pass > eLevel;
+			PixelKernels::SetLevel(bThreaded ? eLevel : (SIMDLEVEL)pass);
+
+			float fSeconds = 0.0f;
+			for (i = 0; i < runCount; i++)
 			{
-				glActiveTexture(GL_TEXTURE1);
-				glBindTexture(GL_TEXTURE_2D, m_uTextures[1]);
-				location = glGetUniformLocation(m_uProgram, "texture02");
-				glUniform1i(location, 1);
-				SetTexturingParams();
+				arrResult = arrSource;
+				timer.BeginTimer();
+				PixelKernels::PremultiplyAlpha(arrResult.data(), uPixelCount, bThreaded ? &m_Jobs : nullptr);
+				timer.EndTimer();
+				fSeconds += timer.GetElapsedSeconds();
 			}
-			else
+
+			if (pass == SIMD_SCALAR)
 			{
-				glActiveTexture(GL_TEXTURE1);
-				glBindTexture(GL_TEXTURE_2D, m_uTextures[2]);
-				location = glGetUniformLocation(m_uProgram, "texture02");
-				glUniform1i(location, 1);
-				SetTexturingParams();
+				arrReference = arrResult;
 			}
 
-			glActiveTexture(GL_TEXTURE2);
-			glBindTexture(GL_TEXTURE_2D, m_uTextures[3]);
-			location = glGetUniformLocation(m_uProgram, "texture03");
-			glUniform1i(location, 2);
-			SetTexturingParams();
-
-			arrChildren.at(i)->Render(pRenderer, m_uProgram);
-
-			/**
-			 * Your turn to code:
-			 * - Add 3rd texture to program, make it a grayscale version of earth texture
-			 * - Apply the 3rd texture in a shader as specular map
-			 * - Specular map determines which parts of the object are shine and which are not
-			 *
-			 */
+			std::string strLevel = PixelKernels::GetLevelName();
+			if (bThreaded)
+			{
+				strLevel += ", " + std::to_string(m_Jobs.GetWorkerCount() + 1) + " threads";
+			}
+			IApplication::Debug("Premultiply " + arrImages[img].strName + " " + strLevel + ": " +
+				std::to_string(fSeconds * 1000.0f / runCount) + " ms" +
+				((arrResult == arrReference) ? "\n" : ", MISMATCH\n"));
 		}
+		PixelKernels::SetLevel(eLevel);
 	}
 }
 
 
-void CTheApp::SetTexturingParams()
-{
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-}
-
-
 void CTheApp::OnScreenSizeChanged(uint32_t uWidthPixels, uint32_t uHeightPixels)
 {
 	glm::mat4 projection = glm::perspective(0.61f, GetAspect(), 1.0f, 500.0f);
@@ -257,6 +358,11 @@ bool CTheApp::OnKeyDown(uint32_t uKeyCode)
 		Close();
 		return true;
 	}
+	if (uKeyCode == KEY_SPACE)
+	{
+		RunBenchmark();
+		return true;
+	}
 
 	return false;
 }
@@ -15,6 +15,9 @@
 #include "../core/include/Geometry.h"
 #include "../core/include/IGraphNode.h"
 #include "../core/include/Material.h"
+#include "../core/include/RenderQueue.h"
+#include "../core/include/JobSystem.h"
+#include "../core/include/TextureLoader.h"
 
 
 class CTheApp : public IApplication
@@ -102,20 +105,35 @@ private:
 	COpenGLRenderer* GetOpenGLRenderer() { return static_cast<COpenGLRenderer*>(GetRenderer()); }
 
 private:
-	void SetTexturingParams();
+	/**
+	 * RunBenchmark
+	 * time the premultiplied alpha conversion with each instruction set the
+	 * cpu supports and on all threads, for the lesson images and a large image
+	 * with random alpha. Print the results.
+	 */
+	void RunBenchmark();
 
 	GLuint						m_uVertexShader;
 	GLuint						m_uFragmentShader;
 	GLuint						m_uProgram;
 
 	GLuint						m_uTextures[4];
+	TextureLoader				m_TextureLoader;
+
+	// cube and sphere texture combinations
+	TEXTURESET					m_TextureSets[2];
 
 	Geometry					m_Cube;
 	Geometry					m_Sphere;
 	Material					m_Material;
 
 	IGraphNode*					m_pSceneRoot;
+	RenderQueue					m_RenderQueue;
+
+	// updates the scenegraph subtrees in parallel and decodes the textures
+	JobSystem					m_Jobs;
 
 	float						m_fUvOffset;
+	float						m_fStatsTime;
 };
 
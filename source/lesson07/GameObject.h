@@ -22,14 +22,22 @@ public:
 	~CGameObject();
 
 	/**
-	 * Render
+	 * Draw
 	 * virtual drawing method of the game object
 	 * @param pRenderer pointer to renderer
 	 */
-	void Render(IRenderer* pRenderer, GLuint uProgram) override;
-	virtual void DrawShadowOnly(IRenderer* pRenderer, GLuint uProgram);
+	void Draw(IRenderer* pRenderer, GLuint uProgram) override;
 
-	Geometry* GetGeometry() const { return m_pGeometry; }
+	/**
+	 * DrawShadowOnly
+	 * draw the object into a shadow map cascade
+	 * @param pRenderer pointer to renderer
+	 * @param uProgram shadow only program
+	 * @param mLightViewProjection view projection matrix of the cascade
+	 */
+	virtual void DrawShadowOnly(IRenderer* pRenderer, GLuint uProgram, const glm::mat4& mLightViewProjection);
+
+	Geometry* GetGeometry() const override { return m_pGeometry; }
 	void SetGeometry(Geometry* pGeometry) { m_pGeometry = pGeometry; }
 
 	Material* GetMaterial() { return m_pMaterial; }
@@ -41,8 +49,6 @@ public:
 	inline void SetShadowReceiver(bool bSet) { m_bShadowReceiver = bSet; }
 
 protected:
-	glm::mat4 GetDepthMatrix(const glm::vec3& vLightPosition) const;
-
 	Geometry*					m_pGeometry;
 	Material*					m_pMaterial;
 
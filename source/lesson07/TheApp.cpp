@@ -14,11 +14,36 @@
 
 CTheApp::CTheApp() : m_iShadowMapSize(2048)
 {
+	// shadow map is an atlas of 2x2 cascade tiles
+	m_iCascadeTileSize = m_iShadowMapSize / 2;
+	m_Cascades.SetMaxDistance(30.0f);
+
 	m_uShadowMap = 0;
 	m_uFrameBuffer = 0;
 
 	m_iOriginalFrameBuffer = -1;
+	m_bShadowMapValid = false;
+	for (uint32_t i = 0; i < ShadowCascades::MAX_CASCADES; i++)
+	{
+		m_arrShadowViewProjections[i] = glm::mat4(1.0f);
+	}
 	m_fLightAngle = 0.0f;
+	m_bAnimateLight = true;
+
+	m_uSpotShadowMap = 0;
+	m_uSpotFrameBuffer = 0;
+	m_fSpotAngle = 0.0f;
+
+	// 2x2 tiles, one spot light shadow rendered per frame
+	m_SpotLights.SetAtlas(1024, 512);
+	m_SpotLights.SetUpdateBudget(1);
+
+	m_uShadowRenders = 0;
+	m_uShadowSkips = 0;
+	m_ShadowCullStats = IGraphNode::CULLSTATS();
+	m_uSpotShadowRenders = 0;
+	m_uSpotShadowDeferred = 0;
+	m_fStatsTime = 0.0f;
 
 	m_pSceneRoot = nullptr;
 
@@ -35,16 +60,34 @@ CTheApp::~CTheApp()
 bool CTheApp::OnCreate()
 {
 	// OnCreate is called by the application when window and graphics initialization is complete
-	if (!CreatePrograms())
+
+	// materials of the lit program come from one uniform buffer, without
+	// uniform buffer support they are set as uniforms. The shader is compiled
+	// for the path chosen here.
+	const bool bMaterialBlock = m_MaterialBuffer.Create(GetOpenGLRenderer(), 4);
+	if (!CreatePrograms(bMaterialBlock))
 	{
 		return false;
 	}
+	if (bMaterialBlock && !m_MaterialBuffer.AttachProgram(m_arrPrograms.at(0)))
+	{
+		IApplication::Debug("CTheApp::OnCreate - MaterialBlock not found in shadowmapping.fs\n");
+		return false;
+	}
+
+	// store original frame buffer handle
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &m_iOriginalFrameBuffer);
 
-	if (!CreateShadowMap(m_iShadowMapSize, m_iShadowMapSize))
+	if (!CreateShadowMap(m_iShadowMapSize, m_uShadowMap, m_uFrameBuffer) ||
+		!CreateShadowMap((int)m_SpotLights.GetAtlasSize(), m_uSpotShadowMap, m_uSpotFrameBuffer))
 	{
 		return false;
 	}
 
+	// contents are undefined until the first shadow passes
+	m_bShadowMapValid = false;
+	m_SpotLights.Invalidate();
+
 	// setup our view and projection matrices
 	glm::mat4 view = glm::lookAt(
 		glm::vec3(4.0f, 5.0f, 14.0f),
@@ -64,6 +107,12 @@ bool CTheApp::OnCreate()
 	m_Geometries[2].GenSphere(glm::vec3(1.0f, 1.0f, 1.0f), glm::vec3(0.0f, 0.0f, 0.0f), 32, 32);
 	m_Geometries[3].GenSphere(glm::vec3(0.1f, 0.1f, 0.1f), glm::vec3(0.0f, 0.0f, 0.0f), 16, 16);
 
+	// geometries draw from their vertex buffers, release the cpu copies
+	for (int32_t i = 0; i < 4; i++)
+	{
+		m_Geometries[i].ReleaseVertexData();
+	}
+
 	// init materials
 	m_Materials[0].m_cDiffuse = glm::vec4(0.3f, 1.0f, 1.0f, 1.0f);
 	m_Materials[0].m_cAmbient = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
@@ -118,14 +167,37 @@ bool CTheApp::OnCreate()
 		pGameObject->SetMaterial(&m_Materials[i]);
 	}
 
+	if (bMaterialBlock)
+	{
+		for (int32_t i = 0; i < 4; i++)
+		{
+			m_MaterialBuffer.AddMaterial(&m_Materials[i]);
+		}
+	}
+
+	// colored spot lights around the sphere, positioned in OnUpdate
+	const glm::vec3 spotColors[MAX_SPOT_LIGHTS] = {
+		glm::vec3(0.6f, 0.2f, 0.2f),
+		glm::vec3(0.2f, 0.6f, 0.2f),
+		glm::vec3(0.2f, 0.2f, 0.6f) };
+	for (uint32_t i = 0; i < MAX_SPOT_LIGHTS; i++)
+	{
+		LightManager::LIGHT light;
+		light.vColor = spotColors[i];
+		light.fConeAngle = 0.9f;
+		light.fRange = 15.0f;
+		m_SpotLights.AddLight(light);
+	}
+
 	return true;
 }
 
 
-bool CTheApp::CreatePrograms()
+bool CTheApp::CreatePrograms(bool bMaterialBlock)
 {
 	GLuint vertexShader = GetOpenGLRenderer()->CreateVertexShaderFromFile("shadowmapping.vs");
-	GLuint fragmentShader = GetOpenGLRenderer()->CreateFragmentShaderFromFile("shadowmapping.fs");
+	GLuint fragmentShader = GetOpenGLRenderer()->CreateFragmentShaderFromFile("shadowmapping.fs",
+		bMaterialBlock ? "#define USE_MATERIAL_BLOCK\n" : "");
 	GLuint program = GetOpenGLRenderer()->CreateProgram(vertexShader, fragmentShader);
 	if (!vertexShader || !fragmentShader || !program)
 	{
@@ -154,20 +226,16 @@ bool CTheApp::CreatePrograms()
 }
 
 
-bool CTheApp::CreateShadowMap(int iWidth, int iHeight)
+bool CTheApp::CreateShadowMap(int iSize, GLuint& uTexture, GLuint& uFrameBuffer)
 {
-	// store original frame buffer handle
-	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &m_iOriginalFrameBuffer);
-
-	glGenTextures(1, &m_uShadowMap);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_uShadowMap);
+	glGenTextures(1, &uTexture);
+	GetOpenGLRenderer()->BindTexture(0, uTexture);
 
 	glTexImage2D(GL_TEXTURE_2D,
 		0,
 		GL_DEPTH_COMPONENT,
-		iWidth,
-		iHeight,
+		iSize,
+		iSize,
 		0,
 		GL_DEPTH_COMPONENT,
 		GL_UNSIGNED_INT,
@@ -178,10 +246,9 @@ bool CTheApp::CreateShadowMap(int iWidth, int iHeight)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	
 	
-	glGenFramebuffers(1, &m_uFrameBuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, m_uFrameBuffer);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_uShadowMap, 0);
-
+	glGenFramebuffers(1, &uFrameBuffer);
+	GetOpenGLRenderer()->BindFramebuffer(uFrameBuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, uTexture, 0);
 	return true;
 }
 
@@ -195,10 +262,12 @@ void CTheApp::OnDestroy()
 		m_pSceneRoot = nullptr;
 	}
 
+	m_MaterialBuffer.Release(GetOpenGLRenderer());
+
 	int32_t i;
 	for (i = 0; i < m_arrPrograms.size(); i++)
 	{
-		glDeleteProgram(m_arrPrograms[i]);
+		GetOpenGLRenderer()->DeleteProgram(m_arrPrograms[i]);
 	}
 	m_arrPrograms.clear();
 
@@ -210,7 +279,7 @@ void CTheApp::OnDestroy()
 
 	if (m_uShadowMap)
 	{
-		glDeleteTextures(1, &m_uShadowMap);
+		GetOpenGLRenderer()->DeleteTexture(m_uShadowMap);
 		m_uShadowMap = 0;
 	}
 	if (m_uFrameBuffer)
@@ -218,6 +287,16 @@ void CTheApp::OnDestroy()
 		glDeleteFramebuffers(1, &m_uFrameBuffer);
 		m_uFrameBuffer = 0;
 	}
+	if (m_uSpotShadowMap)
+	{
+		GetOpenGLRenderer()->DeleteTexture(m_uSpotShadowMap);
+		m_uSpotShadowMap = 0;
+	}
+	if (m_uSpotFrameBuffer)
+	{
+		glDeleteFramebuffers(1, &m_uSpotFrameBuffer);
+		m_uSpotFrameBuffer = 0;
+	}
 }
 
 
@@ -228,7 +307,10 @@ void CTheApp::OnUpdate(float fFrametime)
 		m_pSceneRoot->Update(fFrametime);
 
 		constexpr float pi2 = glm::pi<float>() * 2.0f;
-		m_fLightAngle += fFrametime;
+		if (m_bAnimateLight)
+		{
+			m_fLightAngle += fFrametime;
+		}
 		if (m_fLightAngle > pi2)
 		{
 			m_fLightAngle -= pi2;
@@ -242,6 +324,28 @@ void CTheApp::OnUpdate(float fFrametime)
 		GetRenderer()->SetLightPos(lightPos);
 
 		m_pSceneRoot->GetChildren().at(3)->SetPos(lightPos);
+
+		// spot lights circle slowly above the sphere and look at it
+		if (m_bAnimateLight)
+		{
+			m_fSpotAngle += fFrametime * 0.3f;
+		}
+		if (m_fSpotAngle > pi2)
+		{
+			m_fSpotAngle -= pi2;
+		}
+
+		for (uint32_t i = 0; i < m_SpotLights.GetLightCount(); i++)
+		{
+			LightManager::LIGHT light = m_SpotLights.GetLight(i);
+			const float angle = m_fSpotAngle + pi2 * (float)i / (float)m_SpotLights.GetLightCount();
+			light.vPosition = glm::vec3(cosf(angle) * 4.0f, 4.0f, sinf(angle) * 4.0f);
+			light.vDirection = glm::vec3(0.0f, -1.0f, 0.0f) - light.vPosition;
+			m_SpotLights.SetLight(i, light);
+		}
+
+		// world matrices and bounding spheres for the culling
+		m_pSceneRoot->UpdateWorldMatrices();
 	}
 }
 
@@ -249,43 +353,199 @@ void CTheApp::OnUpdate(float fFrametime)
 void CTheApp::OnDraw(IRenderer* pRenderer)
 {
 	// clear depth and stencil buffers
-	glDisable(GL_BLEND);
+	GetOpenGLRenderer()->SetBlend(false);
 
 	DrawShadowPass(pRenderer);
 
+	DrawSpotShadowPass(pRenderer);
+
 	DrawNormalPass(pRenderer);
+
+	// report the shadow pass savings once per second
+	m_fStatsTime += GetFrameTime();
+	if (m_fStatsTime > 1.0f)
+	{
+		m_fStatsTime = 0.0f;
+		IApplication::Debug("Shadow map renders: " + std::to_string(m_uShadowRenders) +
+			", skipped: " + std::to_string(m_uShadowSkips) +
+			", casters drawn: " + std::to_string(m_ShadowCullStats.uDrawn) +
+			", culled: " + std::to_string(m_ShadowCullStats.uCulled) +
+			", spot shadow renders: " + std::to_string(m_uSpotShadowRenders) +
+			", deferred: " + std::to_string(m_uSpotShadowDeferred) +
+			", material uploads: " + std::to_string(m_MaterialBuffer.GetUploadCount()) + "\n");
+		m_uShadowRenders = 0;
+		m_uShadowSkips = 0;
+		m_uSpotShadowRenders = 0;
+		m_uSpotShadowDeferred = 0;
+	}
 }
 
 
 void CTheApp::DrawShadowPass(IRenderer* pRenderer)
 {
+	if (!m_pSceneRoot)
+	{
+		return;
+	}
+
+	// fit the cascades to the camera once per frame, the light shines from
+	// its position towards the origin
+	const glm::vec3 lightDirection(-pRenderer->GetLightPos());
+	m_Cascades.Update(pRenderer->GetViewMatrix(), pRenderer->GetProjectionMatrix(), lightDirection, m_iCascadeTileSize);
+
+	// shadow map from the previous frame is still valid when nothing moved
+	if (!HasShadowChanged())
+	{
+		m_uShadowSkips++;
+		return;
+	}
+	m_uShadowRenders++;
+
 	SetShadowMapAsRenderTarget();
 
 	GLuint program = m_arrPrograms.at(1);
-	glUseProgram(program);
+	GetOpenGLRenderer()->UseProgram(program);
 
-	if (m_pSceneRoot)
+	m_ShadowCullStats = IGraphNode::CULLSTATS();
+	for (uint32_t c = 0; c < m_Cascades.GetCascadeCount(); c++)
+	{
+		const glm::ivec2 tile(ShadowCascades::GetTileViewport(c, m_iCascadeTileSize));
+		glViewport(tile.x, tile.y, m_iCascadeTileSize, m_iCascadeTileSize);
+
+		DrawShadowCasters(pRenderer, program, m_Cascades.GetViewProjection(c));
+		const IGraphNode::CULLSTATS& stats = IGraphNode::GetCullStats();
+		m_ShadowCullStats.uVisited += stats.uVisited;
+		m_ShadowCullStats.uCulled += stats.uCulled;
+		m_ShadowCullStats.uDrawn += stats.uDrawn;
+	}
+}
+
+
+void CTheApp::DrawSpotShadowPass(IRenderer* pRenderer)
+{
+	if (!m_pSceneRoot)
+	{
+		return;
+	}
+
+	// only the spot light shadows chosen within the budget are rendered,
+	// the rest keep their tiles from earlier frames
+	const glm::vec3 campos(glm::inverse(pRenderer->GetViewMatrix())[3]);
+	const std::vector<uint32_t>& arrUpdates = m_SpotLights.Update(campos);
+	m_uSpotShadowRenders += (uint32_t)arrUpdates.size();
+	m_uSpotShadowDeferred += m_SpotLights.GetDeferredCount();
+	if (arrUpdates.empty())
 	{
-		std::vector<IGraphNode*>& arrNodes = m_pSceneRoot->GetChildren();
-		for (int i = 0; i < arrNodes.size(); i++)
+		return;
+	}
+
+	GetOpenGLRenderer()->BindFramebuffer(m_uSpotFrameBuffer);
+	GetOpenGLRenderer()->SetColorMask(false, false, false, false);
+
+	GLuint program = m_arrPrograms.at(1);
+	GetOpenGLRenderer()->UseProgram(program);
+
+	// clear only the tiles that are rendered again
+	const int32_t tileSize = (int32_t)m_SpotLights.GetTileSize();
+	glEnable(GL_SCISSOR_TEST);
+	for (size_t i = 0; i < arrUpdates.size(); i++)
+	{
+		const uint32_t light = arrUpdates[i];
+		const glm::ivec2 tile(m_SpotLights.GetTileViewport(light));
+		glViewport(tile.x, tile.y, tileSize, tileSize);
+		glScissor(tile.x, tile.y, tileSize, tileSize);
+		glClear(GL_DEPTH_BUFFER_BIT);
+
+		DrawShadowCasters(pRenderer, program, m_SpotLights.GetViewProjection(light));
+	}
+	glDisable(GL_SCISSOR_TEST);
+}
+
+
+void CTheApp::DrawShadowCasters(IRenderer* pRenderer, GLuint uProgram, const glm::mat4& mLightViewProjection)
+{
+	// draw only the casters inside the light volume
+	IGraphNode::BeginCulling(mLightViewProjection);
+
+	std::vector<IGraphNode*>& arrNodes = m_pSceneRoot->GetChildren();
+	for (int i = 0; i < arrNodes.size(); i++)
+	{
+		CGameObject* pObject = static_cast<CGameObject*>(arrNodes.at(i));
+		if (pObject->IsShadowCaster())
 		{
-			CGameObject* pObject = static_cast<CGameObject*>(arrNodes.at(i));
-			if (pObject->IsShadowCaster())
-			{
-				pObject->DrawShadowOnly(pRenderer, program);
-			}
+			pObject->DrawShadowOnly(pRenderer, uProgram, mLightViewProjection);
 		}
 	}
+
+	IGraphNode::EndCulling();
+}
+
+
+bool CTheApp::HasShadowChanged()
+{
+	bool bChanged = !m_bShadowMapValid;
+	m_bShadowMapValid = true;
+
+	// cascades follow the camera and the light
+	for (uint32_t c = 0; c < m_Cascades.GetCascadeCount(); c++)
+	{
+		const glm::mat4& viewProjection = m_Cascades.GetViewProjection(c);
+		if (m_arrShadowViewProjections[c] != viewProjection)
+		{
+			m_arrShadowViewProjections[c] = viewProjection;
+			bChanged = true;
+		}
+	}
+
+	// casters in scene order, any change in their transforms or count is a change
+	size_t uCasters = 0;
+	std::vector<IGraphNode*>& arrNodes = m_pSceneRoot->GetChildren();
+	for (int i = 0; i < arrNodes.size(); i++)
+	{
+		CGameObject* pObject = static_cast<CGameObject*>(arrNodes.at(i));
+		if (!pObject->IsShadowCaster())
+		{
+			continue;
+		}
+
+		// spot light shadows are invalidated where the caster was and where it is now
+		const glm::mat4& world = pObject->GetWorldMatrix();
+		const SPHERE sphere(pObject->GetGeometry() ? pObject->GetGeometry()->GetBoundingSphere() : SPHERE());
+		if (uCasters == m_arrShadowCasterMatrices.size())
+		{
+			m_arrShadowCasterMatrices.push_back(world);
+			m_SpotLights.InvalidateSphere(sphere.Transform(world));
+			bChanged = true;
+		}
+		else if (m_arrShadowCasterMatrices[uCasters] != world)
+		{
+			m_SpotLights.InvalidateSphere(sphere.Transform(m_arrShadowCasterMatrices[uCasters]));
+			m_SpotLights.InvalidateSphere(sphere.Transform(world));
+			m_arrShadowCasterMatrices[uCasters] = world;
+			bChanged = true;
+		}
+		uCasters++;
+	}
+
+	if (uCasters != m_arrShadowCasterMatrices.size())
+	{
+		m_arrShadowCasterMatrices.resize(uCasters);
+		m_SpotLights.Invalidate();
+		bChanged = true;
+	}
+	return bChanged;
 }
 
 
 void CTheApp::SetShadowMapAsRenderTarget()
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, m_uFrameBuffer);
+	GetOpenGLRenderer()->BindFramebuffer(m_uFrameBuffer);
+
+	// clear the whole atlas, the cascades set their own tile viewports
 	glViewport(0, 0, m_iShadowMapSize, m_iShadowMapSize);
 
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	GetOpenGLRenderer()->SetColorMask(false, false, false, false);
 	glPolygonOffset(1.1f, 4.0f);
 	glDisable(GL_POLYGON_OFFSET_FILL);
 }
@@ -293,39 +553,101 @@ void CTheApp::SetShadowMapAsRenderTarget()
 
 void CTheApp::DrawNormalPass(IRenderer* pRenderer)
 {
+	static const UniformId cameraPositionId = COpenGLRenderer::GetUniformId("cameraPosition");
+	static const UniformId lightPositionId = COpenGLRenderer::GetUniformId("lightPosition");
+	static const UniformId shadowMapId = COpenGLRenderer::GetUniformId("shadowMap");
+	static const UniformId cascadeSplitsId = COpenGLRenderer::GetUniformId("cascadeSplits");
+	static const UniformId shadowMatrixIds[ShadowCascades::MAX_CASCADES] = {
+		COpenGLRenderer::GetUniformId("shadowMatrix0"),
+		COpenGLRenderer::GetUniformId("shadowMatrix1"),
+		COpenGLRenderer::GetUniformId("shadowMatrix2"),
+		COpenGLRenderer::GetUniformId("shadowMatrix3") };
+	static const UniformId spotShadowMapId = COpenGLRenderer::GetUniformId("spotShadowMap");
+	static const UniformId spotPositionIds[MAX_SPOT_LIGHTS] = {
+		COpenGLRenderer::GetUniformId("spotPosition0"),
+		COpenGLRenderer::GetUniformId("spotPosition1"),
+		COpenGLRenderer::GetUniformId("spotPosition2") };
+	static const UniformId spotDirectionIds[MAX_SPOT_LIGHTS] = {
+		COpenGLRenderer::GetUniformId("spotDirection0"),
+		COpenGLRenderer::GetUniformId("spotDirection1"),
+		COpenGLRenderer::GetUniformId("spotDirection2") };
+	static const UniformId spotColorIds[MAX_SPOT_LIGHTS] = {
+		COpenGLRenderer::GetUniformId("spotColor0"),
+		COpenGLRenderer::GetUniformId("spotColor1"),
+		COpenGLRenderer::GetUniformId("spotColor2") };
+	static const UniformId spotShadowMatrixIds[MAX_SPOT_LIGHTS] = {
+		COpenGLRenderer::GetUniformId("spotShadowMatrix0"),
+		COpenGLRenderer::GetUniformId("spotShadowMatrix1"),
+		COpenGLRenderer::GetUniformId("spotShadowMatrix2") };
+	static const UniformId spotShadowTileIds[MAX_SPOT_LIGHTS] = {
+		COpenGLRenderer::GetUniformId("spotShadowTile0"),
+		COpenGLRenderer::GetUniformId("spotShadowTile1"),
+		COpenGLRenderer::GetUniformId("spotShadowTile2") };
+
 	SetFramebufferAsRenderTarget();
 	GLuint program = m_arrPrograms.at(0);
-	glUseProgram(program);
+	GetOpenGLRenderer()->UseProgram(program);
 
 	// setup the camera position
 	const glm::vec3 campos(-pRenderer->GetViewMatrix()[3]);
-	GLint location = glGetUniformLocation(program, "cameraPosition");
-	glUniform3f(location, campos.x, campos.y, campos.z);
+	GetOpenGLRenderer()->SetUniform(program, cameraPositionId, campos);
 
 	// setup the light position
 	const glm::vec3& lightPosition(pRenderer->GetLightPos());
-	location = glGetUniformLocation(program, "lightPosition");
-	glUniform3f(location, lightPosition.x, lightPosition.y, lightPosition.z);
+	GetOpenGLRenderer()->SetUniform(program, lightPositionId, lightPosition);
 
 	// set the shadow map into program
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_uShadowMap);
-	location = glGetUniformLocation(program, "shadowMap");
-	glUniform1i(location, 0);
+	GetOpenGLRenderer()->BindTexture(0, m_uShadowMap);
+	GetOpenGLRenderer()->SetUniform(program, shadowMapId, 0);
+
+	// cascades are the same for all objects, the shader picks one by view depth
+	for (uint32_t c = 0; c < ShadowCascades::MAX_CASCADES; c++)
+	{
+		GetOpenGLRenderer()->SetUniform(program, shadowMatrixIds[c], m_Cascades.GetShadowMatrix(c));
+	}
+	GetOpenGLRenderer()->SetUniform(program, cascadeSplitsId, m_Cascades.GetSplitDistances());
+
+	// spot lights, range and cone are packed into the w components and the
+	// shadow flag into the alpha of the color
+	GetOpenGLRenderer()->BindTexture(1, m_uSpotShadowMap);
+	GetOpenGLRenderer()->SetUniform(program, spotShadowMapId, 1);
+	for (uint32_t i = 0; i < MAX_SPOT_LIGHTS; i++)
+	{
+		glm::vec4 position(0.0f, 0.0f, 0.0f, 1.0f);
+		glm::vec4 direction(0.0f, -1.0f, 0.0f, 1.0f);
+		glm::vec4 color(0.0f);
+		if (i < m_SpotLights.GetLightCount())
+		{
+			const LightManager::LIGHT& light = m_SpotLights.GetLight(i);
+			position = glm::vec4(light.vPosition, light.fRange);
+			direction = glm::vec4(glm::normalize(light.vDirection), cosf(light.fConeAngle * 0.5f));
+			color = glm::vec4(light.vColor, m_SpotLights.HasShadow(i) ? 1.0f : 0.0f);
+			GetOpenGLRenderer()->SetUniform(program, spotShadowMatrixIds[i], m_SpotLights.GetShadowMatrix(i));
+			if (m_SpotLights.HasShadow(i))
+			{
+				GetOpenGLRenderer()->SetUniform(program, spotShadowTileIds[i], m_SpotLights.GetTileRect(i));
+			}
+		}
+		GetOpenGLRenderer()->SetUniform(program, spotPositionIds[i], position);
+		GetOpenGLRenderer()->SetUniform(program, spotDirectionIds[i], direction);
+		GetOpenGLRenderer()->SetUniform(program, spotColorIds[i], color);
+	}
 
 	if (m_pSceneRoot)
 	{
+		IGraphNode::BeginCulling(pRenderer->GetProjectionMatrix() * pRenderer->GetViewMatrix());
 		m_pSceneRoot->Render(pRenderer, program);
+		IGraphNode::EndCulling();
 	}
 }
 
 
 void CTheApp::SetFramebufferAsRenderTarget()
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, m_iOriginalFrameBuffer);
+	GetOpenGLRenderer()->BindFramebuffer((GLuint)m_iOriginalFrameBuffer);
 	glViewport(0, 0, GetWidth(), GetHeight());
 
-	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	GetOpenGLRenderer()->SetColorMask(true, true, true, true);
 
 	glClearColor(0.5f, 0.5f, 1.0f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -334,17 +656,6 @@ void CTheApp::SetFramebufferAsRenderTarget()
 }
 
 
-void CTheApp::SetTexturingParams()
-{
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-}
-
-
 void CTheApp::OnScreenSizeChanged(uint32_t uWidthPixels, uint32_t uHeightPixels)
 {
 	glm::mat4 projection = glm::perspective(0.61f, GetAspect(), 1.0f, 500.0f);
@@ -380,6 +691,17 @@ bool CTheApp::OnKeyDown(uint32_t uKeyCode)
 		Close();
 		return true;
 	}
+	if (uKeyCode == KEY_SPACE)
+	{
+		// a still light lets the shadow pass reuse the shadow map
+		m_bAnimateLight = !m_bAnimateLight;
+
+		// dim the light indicator while the light stands still, only its
+		// material block is uploaded again
+		m_Materials[3].m_cAmbient = m_bAnimateLight ? glm::vec4(1.0f, 1.0f, 1.0f, 1.0f) : glm::vec4(0.4f, 0.4f, 0.4f, 1.0f);
+		m_Materials[3].SetDirty();
+		return true;
+	}
 
 	return false;
 }
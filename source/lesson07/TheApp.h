@@ -15,6 +15,9 @@
 #include "../core/include/IGraphNode.h"
 #include "../core/include/Geometry.h"
 #include "../core/include/Material.h"
+#include "../core/include/MaterialBuffer.h"
+#include "../core/include/ShadowCascades.h"
+#include "../core/include/LightManager.h"
 
 
 class CTheApp : public IApplication
@@ -102,28 +105,69 @@ private:
 	COpenGLRenderer* GetOpenGLRenderer() { return static_cast<COpenGLRenderer*>(GetRenderer()); }
 
 private:
-	bool CreatePrograms();
-	bool CreateShadowMap(int iWidth, int iHeight);
+	/**
+	 * CreatePrograms
+	 * create the lit and the shadow only programs
+	 * @param bMaterialBlock true to read the materials of the lit program from MaterialBlock
+	 * @return true if successful
+	 */
+	bool CreatePrograms(bool bMaterialBlock);
+	bool CreateShadowMap(int iSize, GLuint& uTexture, GLuint& uFrameBuffer);
 
 	void SetShadowMapAsRenderTarget();
 	void SetFramebufferAsRenderTarget();
-	void SetTexturingParams();
 
 	void DrawShadowPass(IRenderer* pRenderer);
+	void DrawSpotShadowPass(IRenderer* pRenderer);
+	void DrawShadowCasters(IRenderer* pRenderer, GLuint uProgram, const glm::mat4& mLightViewProjection);
 	void DrawNormalPass(IRenderer* pRenderer);
 
+	/**
+	 * HasShadowChanged
+	 * compare the cascades and the shadow casters to the ones the shadow map
+	 * was last rendered with, and remember the current ones
+	 * @return true if the shadow map needs to be rendered again
+	 */
+	bool HasShadowChanged();
+
 	std::vector<GLuint>			m_arrShaders;
 	std::vector<GLuint>			m_arrPrograms;
 
 	Geometry					m_Geometries[4];
 	Material					m_Materials[4];
+	MaterialBuffer				m_MaterialBuffer;
 
 	GLint						m_iOriginalFrameBuffer;
 	GLuint						m_uShadowMap;
 	GLuint						m_uFrameBuffer;
 	const int32_t				m_iShadowMapSize;
 
+	// cascades share the shadow map, one tile each
+	ShadowCascades				m_Cascades;
+	int32_t						m_iCascadeTileSize;
+
+	// cascade and caster transforms the shadow map was rendered with
+	bool						m_bShadowMapValid;
+	glm::mat4					m_arrShadowViewProjections[ShadowCascades::MAX_CASCADES];
+	std::vector<glm::mat4>		m_arrShadowCasterMatrices;
+
 	float						m_fLightAngle;
+	bool						m_bAnimateLight;
+
+	// spot lights share their own shadow map atlas
+	static const uint32_t		MAX_SPOT_LIGHTS = 3;
+	LightManager				m_SpotLights;
+	GLuint						m_uSpotShadowMap;
+	GLuint						m_uSpotFrameBuffer;
+	float						m_fSpotAngle;
+
+	// shadow pass statistics since previous report
+	uint32_t					m_uShadowRenders;
+	uint32_t					m_uShadowSkips;
+	IGraphNode::CULLSTATS		m_ShadowCullStats;
+	uint32_t					m_uSpotShadowRenders;
+	uint32_t					m_uSpotShadowDeferred;
+	float						m_fStatsTime;
 
 	IGraphNode*					m_pSceneRoot;
 };
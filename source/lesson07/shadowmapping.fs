@@ -1,16 +1,82 @@
-uniform sampler2D shadowMap;
-uniform vec3 lightPosition;
-uniform vec3 cameraPosition;
+// materials come from a uniform buffer when the app defines USE_MATERIAL_BLOCK
+#ifdef USE_MATERIAL_BLOCK
+#extension GL_ARB_uniform_buffer_object : enable
+layout(std140) uniform MaterialBlock
+{
+	vec4 materialAmbient;
+	vec4 materialDiffuse;
+	vec4 materialSpecular;
+	vec4 materialEmissive;
+	float specularPower;
+};
+#else
 uniform vec4 materialAmbient;
 uniform vec4 materialDiffuse;
 uniform vec4 materialSpecular;
 uniform float specularPower;
+#endif
+
+uniform sampler2D shadowMap;
+uniform vec3 lightPosition;
+uniform vec3 cameraPosition;
 uniform float shadowReceiver;
+uniform mat4 shadowMatrix0;
+uniform mat4 shadowMatrix1;
+uniform mat4 shadowMatrix2;
+uniform mat4 shadowMatrix3;
+uniform vec4 cascadeSplits;
+
+// spot lights, position.w is the range, direction.w the cosine of the half
+// cone angle and color.a is 1 when the light has a shadow in the atlas.
+// Shadow tile is the min and max texture coordinates of the tile of the light.
+uniform sampler2D spotShadowMap;
+uniform vec4 spotPosition0;
+uniform vec4 spotPosition1;
+uniform vec4 spotPosition2;
+uniform vec4 spotDirection0;
+uniform vec4 spotDirection1;
+uniform vec4 spotDirection2;
+uniform vec4 spotColor0;
+uniform vec4 spotColor1;
+uniform vec4 spotColor2;
+uniform mat4 spotShadowMatrix0;
+uniform mat4 spotShadowMatrix1;
+uniform mat4 spotShadowMatrix2;
+uniform vec4 spotShadowTile0;
+uniform vec4 spotShadowTile1;
+uniform vec4 spotShadowTile2;
 
 varying vec2 outUv;
 varying vec3 eyespacePosition;
 varying vec3 eyespaceNormal;
-varying vec4 shadowTexCoords;
+varying float viewDepth;
+
+vec3 SpotLight(vec4 position, vec4 direction, vec4 color, mat4 shadowMatrix, vec4 shadowTile, vec3 normal)
+{
+	vec3 surfaceToLight = position.xyz - eyespacePosition;
+	float lightDistance = length(surfaceToLight);
+	surfaceToLight /= lightDistance;
+
+	float cone = smoothstep(direction.w, direction.w + 0.05, dot(-surfaceToLight, direction.xyz));
+	float intensity = cone * max(0.0, 1.0 - lightDistance / position.w) * max(0.0, dot(normal, surfaceToLight));
+	if (intensity > 0.0 && color.a > 0.5 && shadowReceiver > 0.5)
+	{
+		vec4 shadowTexCoords = shadowMatrix * vec4(eyespacePosition, 1.0);
+		vec3 texCoords = shadowTexCoords.xyz / shadowTexCoords.w;
+
+		// a deferred shadow was rendered with an older matrix, fragments it
+		// maps outside the tile of the light are left unshadowed
+		if (all(greaterThanEqual(texCoords.xy, shadowTile.xy)) && all(lessThanEqual(texCoords.xy, shadowTile.zw)))
+		{
+			float depth = texture2D(spotShadowMap, texCoords.xy).r;
+			if (texCoords.z - 0.0005 > depth)
+			{
+				intensity = 0.0;
+			}
+		}
+	}
+	return color.rgb * materialDiffuse.rgb * intensity;
+}
 
 void main(void)
 {
@@ -20,12 +86,40 @@ void main(void)
 
 	if (shadowReceiver > 0.5)
 	{
-		vec3 texCoords = shadowTexCoords.xyz / shadowTexCoords.w;
-		light = texture2D(shadowMap, texCoords.xy).r;
+		// pick the first cascade that reaches the fragment, beyond the last one
+		// nothing is shadowed
+		vec4 shadowTexCoords = vec4(0.0);
+		vec4 worldPosition = vec4(eyespacePosition, 1.0);
+		if (viewDepth < cascadeSplits.x)
+		{
+			shadowTexCoords = shadowMatrix0 * worldPosition;
+		}
+		else if (viewDepth < cascadeSplits.y)
+		{
+			shadowTexCoords = shadowMatrix1 * worldPosition;
+		}
+		else if (viewDepth < cascadeSplits.z)
+		{
+			shadowTexCoords = shadowMatrix2 * worldPosition;
+		}
+		else if (viewDepth < cascadeSplits.w)
+		{
+			shadowTexCoords = shadowMatrix3 * worldPosition;
+		}
+
+		if (shadowTexCoords.w > 0.0)
+		{
+			vec3 texCoords = shadowTexCoords.xyz / shadowTexCoords.w;
+			float depth = texture2D(shadowMap, texCoords.xy).r;
+			light = (texCoords.z - 0.002 > depth) ? 0.0 : 1.0;
+		}
 	}
 	
     float d = dot(normal, surfaceToLight) * light;
     vec4 diffuse = materialAmbient + materialDiffuse * d;
+    diffuse.rgb += SpotLight(spotPosition0, spotDirection0, spotColor0, spotShadowMatrix0, spotShadowTile0, normal);
+    diffuse.rgb += SpotLight(spotPosition1, spotDirection1, spotColor1, spotShadowMatrix1, spotShadowTile1, normal);
+    diffuse.rgb += SpotLight(spotPosition2, spotDirection2, spotColor2, spotShadowMatrix2, spotShadowTile2, normal);
     diffuse.a = materialDiffuse.a;
     if (specularPower > 0.9)
     {
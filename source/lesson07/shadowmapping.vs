@@ -5,21 +5,21 @@ attribute vec2 uv;
 uniform mat4		modelViewProjectionMatrix;
 uniform mat4		modelMatrix;
 uniform mat3		normalMatrix;
-uniform mat4		shadowMapMatrix;
 
 varying vec2 outUv;
 varying vec3 eyespacePosition;
 varying vec3 eyespaceNormal;
-varying vec4 shadowTexCoords;
+varying float viewDepth;
 
 void main(void)
 {
 	vec4 vertexPosition = vec4(position, 1.0);
 	outUv = uv;
-	shadowTexCoords = shadowMapMatrix * vertexPosition;
 
 	eyespacePosition = (modelMatrix * vertexPosition).xyz;
 	eyespaceNormal = normalMatrix * normal;
 	gl_Position = modelViewProjectionMatrix * vertexPosition;
-}
 
+	// w of a perspective projection is the distance along the view direction
+	viewDepth = gl_Position.w;
+}
@@ -0,0 +1,409 @@
+/**
+ * ============================================================================
+ *  Name        : main.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : meshconv, offline Wavefront OBJ to binary mesh converter
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#include "../core/include/MeshFile.h"
+#include "../core/include/MeshOptimizer.h"
+#include "../core/include/VertexFormat.h"
+#include "../core/glm-master/glm/glm.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+
+// same layout as VERTEX in Geometry.h
+struct OBJVERTEX
+{
+	float	x, y, z;
+	float	nx, ny, nz;
+	float	tu, tv;
+};
+
+// position, uv and normal indices of a face corner
+struct OBJCORNER
+{
+	int32_t	p, t, n;
+
+	bool operator==(const OBJCORNER& other) const { return p == other.p && t == other.t && n == other.n; }
+};
+
+struct OBJCORNERHASH
+{
+	size_t operator()(const OBJCORNER& c) const
+	{
+		return ((size_t)c.p * 73856093) ^ ((size_t)c.t * 19349663) ^ ((size_t)c.n * 83492791);
+	}
+};
+
+struct OBJMESH
+{
+	std::vector<float>		arrPositions;
+	std::vector<float>		arrUvs;
+	std::vector<float>		arrNormals;
+	std::vector<OBJVERTEX>	arrVertices;
+	std::vector<uint32_t>	arrIndices;
+	std::vector<bool>		arrMissingNormals;
+};
+
+
+static void PrintUsage()
+{
+	printf("usage: meshconv [-noopt] [-weld epsilon] [-compact] input.obj output.mesh\n");
+	printf("  -noopt   keep the vertex and triangle order of the obj file\n");
+	printf("  -weld    merge vertices whose components are within epsilon,\n");
+	printf("           by default only identical vertices are merged\n");
+	printf("  -compact store 16 byte vertices: int16 positions normalized to the\n");
+	printf("           bounds, 10:10:10:2 normals and half float uvs\n");
+}
+
+
+static void PrintStats(const char* pStage, const OBJMESH& mesh, double fTime)
+{
+	const MESHSTATS stats = MeshOptimizer::Analyze(mesh.arrIndices.data(), mesh.arrIndices.size(),
+		&mesh.arrVertices[0].x, mesh.arrVertices.size(), sizeof(OBJVERTEX) / sizeof(float));
+	printf("  %-9s %8zu vertices  ACMR %.3f  ATVR %.3f  overdraw %.3f  %8.2f ms\n",
+		pStage, mesh.arrVertices.size(), stats.fACMR, stats.fATVR, stats.fOverdraw, fTime);
+}
+
+
+static double GetMilliseconds(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+
+// obj indices are 1 based, negative indices count back from the end
+static int32_t ResolveIndex(long index, size_t uCount)
+{
+	if (index > 0)
+	{
+		return ((size_t)index <= uCount) ? (int32_t)(index - 1) : -1;
+	}
+	if (index < 0)
+	{
+		return ((size_t)-index <= uCount) ? (int32_t)(uCount + index) : -1;
+	}
+	return -1;
+}
+
+
+static bool ParseCorner(const char*& pLine, const OBJMESH& mesh, OBJCORNER& corner)
+{
+	char* pEnd = nullptr;
+	corner.p = ResolveIndex(strtol(pLine, &pEnd, 10), mesh.arrPositions.size() / 3);
+	if (pEnd == pLine || corner.p < 0)
+	{
+		return false;
+	}
+	pLine = pEnd;
+	corner.t = -1;
+	corner.n = -1;
+
+	if (*pLine == '/')
+	{
+		++pLine;
+		if (*pLine != '/')
+		{
+			corner.t = ResolveIndex(strtol(pLine, &pEnd, 10), mesh.arrUvs.size() / 2);
+			pLine = pEnd;
+		}
+		if (*pLine == '/')
+		{
+			++pLine;
+			corner.n = ResolveIndex(strtol(pLine, &pEnd, 10), mesh.arrNormals.size() / 3);
+			pLine = pEnd;
+		}
+	}
+	return true;
+}
+
+
+static bool LoadObj(const char* pFilename, OBJMESH& mesh)
+{
+	std::ifstream file(pFilename, std::ios::binary | std::ios::ate);
+	if (!file)
+	{
+		return false;
+	}
+	std::string strText((size_t)file.tellg(), '\0');
+	file.seekg(0);
+	file.read(&strText[0], (std::streamsize)strText.size());
+
+	std::unordered_map<OBJCORNER, uint32_t, OBJCORNERHASH> mapVertices;
+	std::vector<uint32_t> arrPolygon;
+
+	const char* pLine = strText.c_str();
+	while (*pLine)
+	{
+		const char* pNext = strchr(pLine, '\n');
+		pNext = pNext ? pNext + 1 : pLine + strlen(pLine);
+
+		char* pEnd = nullptr;
+		if (pLine[0] == 'v' && pLine[1] == ' ')
+		{
+			pLine += 2;
+			for (int32_t i = 0; i < 3; i++)
+			{
+				mesh.arrPositions.push_back(strtof(pLine, &pEnd));
+				pLine = pEnd;
+			}
+		}
+		else if (pLine[0] == 'v' && pLine[1] == 't' && pLine[2] == ' ')
+		{
+			pLine += 3;
+			const float u = strtof(pLine, &pEnd);
+			const float v = strtof(pEnd, &pEnd);
+
+			// obj has the origin at the bottom, textures here are top down
+			mesh.arrUvs.push_back(u);
+			mesh.arrUvs.push_back(1.0f - v);
+		}
+		else if (pLine[0] == 'v' && pLine[1] == 'n' && pLine[2] == ' ')
+		{
+			pLine += 3;
+			for (int32_t i = 0; i < 3; i++)
+			{
+				mesh.arrNormals.push_back(strtof(pLine, &pEnd));
+				pLine = pEnd;
+			}
+		}
+		else if (pLine[0] == 'f' && pLine[1] == ' ')
+		{
+			pLine += 2;
+			arrPolygon.clear();
+			while (true)
+			{
+				while (*pLine == ' ' || *pLine == '\t')
+				{
+					++pLine;
+				}
+				if (*pLine == '\r' || *pLine == '\n' || *pLine == 0)
+				{
+					break;
+				}
+
+				OBJCORNER corner;
+				if (!ParseCorner(pLine, mesh, corner))
+				{
+					printf("meshconv: invalid face in %s\n", pFilename);
+					return false;
+				}
+
+				auto it = mapVertices.find(corner);
+				if (it == mapVertices.end())
+				{
+					OBJVERTEX vertex;
+					memcpy(&vertex.x, &mesh.arrPositions[corner.p * 3], sizeof(float) * 3);
+					if (corner.n >= 0)
+					{
+						memcpy(&vertex.nx, &mesh.arrNormals[corner.n * 3], sizeof(float) * 3);
+					}
+					else
+					{
+						vertex.nx = vertex.ny = vertex.nz = 0.0f;
+					}
+					vertex.tu = (corner.t >= 0) ? mesh.arrUvs[corner.t * 2 + 0] : 0.0f;
+					vertex.tv = (corner.t >= 0) ? mesh.arrUvs[corner.t * 2 + 1] : 0.0f;
+
+					it = mapVertices.emplace(corner, (uint32_t)mesh.arrVertices.size()).first;
+					mesh.arrVertices.push_back(vertex);
+					mesh.arrMissingNormals.push_back(corner.n < 0);
+				}
+				arrPolygon.push_back(it->second);
+			}
+
+			// triangle fan, obj is counter clockwise and the framework
+			// renders clockwise front faces
+			for (size_t i = 2; i < arrPolygon.size(); i++)
+			{
+				mesh.arrIndices.push_back(arrPolygon[0]);
+				mesh.arrIndices.push_back(arrPolygon[i]);
+				mesh.arrIndices.push_back(arrPolygon[i - 1]);
+			}
+		}
+		pLine = pNext;
+	}
+	return !mesh.arrVertices.empty() && !mesh.arrIndices.empty();
+}
+
+
+// positions are compared by value, files that repeat the positions of
+// each triangle are smoothed the same way as shared positions
+struct OBJPOSITIONHASH
+{
+	size_t operator()(const glm::vec3& p) const
+	{
+		uint32_t arrBits[3];
+		memcpy(arrBits, &p.x, sizeof(arrBits));
+		return ((size_t)arrBits[0] * 73856093) ^ ((size_t)arrBits[1] * 19349663) ^ ((size_t)arrBits[2] * 83492791);
+	}
+};
+
+
+// area weighted normals for vertices without a normal in the file
+static void GenerateNormals(OBJMESH& mesh)
+{
+	std::unordered_map<glm::vec3, glm::vec3, OBJPOSITIONHASH> mapNormals;
+	for (size_t i = 0; i < mesh.arrIndices.size(); i += 3)
+	{
+		const OBJVERTEX& v0 = mesh.arrVertices[mesh.arrIndices[i + 0]];
+		const OBJVERTEX& v1 = mesh.arrVertices[mesh.arrIndices[i + 1]];
+		const OBJVERTEX& v2 = mesh.arrVertices[mesh.arrIndices[i + 2]];
+		const glm::vec3 p0(v0.x, v0.y, v0.z);
+		const glm::vec3 p1(v1.x, v1.y, v1.z);
+		const glm::vec3 p2(v2.x, v2.y, v2.z);
+
+		// clockwise winding, normal is (p2 - p0) x (p1 - p0)
+		const glm::vec3 normal = glm::cross(p2 - p0, p1 - p0);
+		for (size_t j = 0; j < 3; j++)
+		{
+			if (mesh.arrMissingNormals[mesh.arrIndices[i + j]])
+			{
+				const OBJVERTEX& v = mesh.arrVertices[mesh.arrIndices[i + j]];
+				mapNormals[glm::vec3(v.x, v.y, v.z)] += normal;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < mesh.arrVertices.size(); i++)
+	{
+		if (mesh.arrMissingNormals[i])
+		{
+			OBJVERTEX& vertex = mesh.arrVertices[i];
+			const glm::vec3 normal = mapNormals[glm::vec3(vertex.x, vertex.y, vertex.z)];
+			const float fLength = glm::length(normal);
+			const glm::vec3 unit = (fLength > 0.0f) ? normal / fLength : glm::vec3(0.0f);
+			vertex.nx = unit.x;
+			vertex.ny = unit.y;
+			vertex.nz = unit.z;
+		}
+	}
+}
+
+
+int main(int argc, char* argv[])
+{
+	bool bOptimize = true;
+	bool bCompact = false;
+	float fWeldEpsilon = 0.0f;
+	const char* pInput = nullptr;
+	const char* pOutput = nullptr;
+
+	for (int32_t i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-noopt"))					bOptimize = false;
+		else if (!strcmp(argv[i], "-weld") && i + 1 < argc)	fWeldEpsilon = strtof(argv[++i], nullptr);
+		else if (!strcmp(argv[i], "-compact"))			bCompact = true;
+		else if (!pInput)								pInput = argv[i];
+		else if (!pOutput)								pOutput = argv[i];
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	if (!pInput || !pOutput)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	OBJMESH mesh;
+	if (!LoadObj(pInput, mesh))
+	{
+		printf("meshconv: failed to load %s\n", pInput);
+		return 1;
+	}
+	GenerateNormals(mesh);
+	const double fParseTime = GetMilliseconds(start);
+
+	if (bOptimize)
+	{
+		// the stages of MeshOptimizer::Optimize one at a time, with the metrics after each
+		float* pVertices = &mesh.arrVertices[0].x;
+		const uint32_t uVertexSize = sizeof(OBJVERTEX) / sizeof(float);
+		uint32_t* pIndices = mesh.arrIndices.data();
+		const size_t uIndexCount = mesh.arrIndices.size();
+		PrintStats("input", mesh, fParseTime);
+
+		start = std::chrono::high_resolution_clock::now();
+		mesh.arrVertices.resize(MeshOptimizer::WeldVertices(pVertices, mesh.arrVertices.size(), uVertexSize, pIndices, uIndexCount, fWeldEpsilon));
+		PrintStats("weld", mesh, GetMilliseconds(start));
+
+		start = std::chrono::high_resolution_clock::now();
+		MeshOptimizer::OptimizeVertexCache(pIndices, uIndexCount, mesh.arrVertices.size());
+		PrintStats("cache", mesh, GetMilliseconds(start));
+
+		start = std::chrono::high_resolution_clock::now();
+		MeshOptimizer::OptimizeOverdraw(pIndices, uIndexCount, pVertices, mesh.arrVertices.size(), uVertexSize);
+		PrintStats("overdraw", mesh, GetMilliseconds(start));
+
+		start = std::chrono::high_resolution_clock::now();
+		mesh.arrVertices.resize(MeshOptimizer::OptimizeVertexFetch(pVertices, mesh.arrVertices.size(), uVertexSize, pIndices, uIndexCount));
+		PrintStats("fetch", mesh, GetMilliseconds(start));
+	}
+
+	VERTEXLAYOUT layout;
+	layout.ePosition = bCompact ? POSITION_INT16 : POSITION_FLOAT;
+	layout.eNormal = bCompact ? NORMAL_PACKED : NORMAL_FLOAT;
+	layout.eUv = bCompact ? UV_HALF : UV_FLOAT;
+
+	// int16 positions are stored relative to the bounds of the mesh
+	float arrBounds[6] = { INFINITY, INFINITY, INFINITY, -INFINITY, -INFINITY, -INFINITY };
+	for (const OBJVERTEX& vertex : mesh.arrVertices)
+	{
+		const float* pPosition = &vertex.x;
+		for (int32_t c = 0; c < 3; c++)
+		{
+			arrBounds[c] = std::min(arrBounds[c], pPosition[c]);
+			arrBounds[c + 3] = std::max(arrBounds[c + 3], pPosition[c]);
+		}
+	}
+
+	std::vector<MESHATTRIBUTE> arrAttributes;
+	VertexFormat::GetAttributes(layout, arrAttributes);
+	const uint32_t uStride = VertexFormat::GetStride(layout);
+	std::vector<unsigned char> arrVertexData(mesh.arrVertices.size() * uStride);
+	VertexFormat::Encode((const float*)mesh.arrVertices.data(), mesh.arrVertices.size(), layout, arrBounds, arrBounds + 3, arrVertexData.data());
+
+	if (!MeshFile::Save(pOutput, arrAttributes, uStride,
+		arrVertexData.data(), (uint32_t)mesh.arrVertices.size(),
+		mesh.arrIndices, std::vector<MESHLOD>(), arrBounds))
+	{
+		printf("meshconv: failed to write %s\n", pOutput);
+		return 1;
+	}
+
+	// open the result the way Geometry::Load does
+	start = std::chrono::high_resolution_clock::now();
+	MeshFile file;
+	if (!file.Open(pOutput))
+	{
+		printf("meshconv: failed to open %s\n", pOutput);
+		return 1;
+	}
+	const double fOpenTime = GetMilliseconds(start);
+
+	const MESHHEADER& header = file.GetHeader();
+	printf("%s: %u vertices of %u bytes, %u triangles, %u bit indices\n",
+		pInput, header.uVertexCount, header.uVertexStride, header.uIndexCount / 3, header.uIndexSize * 8);
+	printf("  bounds (%.3f %.3f %.3f) - (%.3f %.3f %.3f), radius %.3f\n",
+		header.arrBoundsMin[0], header.arrBoundsMin[1], header.arrBoundsMin[2],
+		header.arrBoundsMax[0], header.arrBoundsMax[1], header.arrBoundsMax[2], header.arrSphere[3]);
+	printf("  obj parsed in %.2f ms, mesh file mapped in %.3f ms\n", fParseTime, fOpenTime);
+	return 0;
+}
@@ -0,0 +1,168 @@
+/**
+ * ============================================================================
+ *  Name        : main.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : texconv, offline PNG/JPEG to block compressed DDS converter
+ *  Version     : 1.00
+ *	Author		: Jani Immonen, <realdashdev@gmail.com>
+ * ============================================================================
+**/
+
+#include "../core/include/TextureCompression.h"
+#include "../core/include/PixelKernels.h"
+#include "../core/include/JobSystem.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../core/include/stb_image.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+
+static void PrintUsage()
+{
+	printf("usage: texconv [-bc1|-bc3] [-box|-kaiser|-nomips] input output.dds\n");
+	printf("  -bc1     opaque RGB, 4 bits per pixel\n");
+	printf("  -bc3     RGBA, 8 bits per pixel\n");
+	printf("           default is bc1 for opaque images and bc3 otherwise\n");
+	printf("  -box     mip levels with a box filter\n");
+	printf("  -kaiser  mip levels with a kaiser filter (default)\n");
+	printf("  -nomips  level 0 only\n");
+}
+
+
+static size_t GetFileSize(const char* pFilename)
+{
+	std::ifstream file(pFilename, std::ios::binary | std::ios::ate);
+	return file ? (size_t)file.tellg() : 0;
+}
+
+
+// peak signal to noise ratio of the decoded level 0 against the source
+static void PrintQuality(const unsigned char* pSource, const unsigned char* pDecoded, size_t uPixelCount)
+{
+	double arrError[4] = { 0.0, 0.0, 0.0, 0.0 };
+	for (size_t i = 0; i < uPixelCount * 4; i++)
+	{
+		const double d = (double)pSource[i] - (double)pDecoded[i];
+		arrError[i & 3] += d * d;
+	}
+
+	const char* arrNames[4] = { "R", "G", "B", "A" };
+	double fColorError = 0.0;
+	for (uint32_t c=0; c<4; c++)
+	{
+		const double fMse = arrError[c] / (double)uPixelCount;
+		if (c < 3)
+		{
+			fColorError += fMse / 3.0;
+		}
+		printf("  PSNR %s: %.2f dB\n", arrNames[c], (fMse > 0.0) ? 10.0 * std::log10(255.0 * 255.0 / fMse) : 99.99);
+	}
+	printf("  PSNR RGB: %.2f dB\n", (fColorError > 0.0) ? 10.0 * std::log10(255.0 * 255.0 / fColorError) : 99.99);
+}
+
+
+int main(int argc, char* argv[])
+{
+	int32_t iFormat = -1;
+	int32_t iMipmaps = MIPFILTER_KAISER;
+	const char* pInput = nullptr;
+	const char* pOutput = nullptr;
+
+	for (int32_t i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-bc1"))			iFormat = BLOCKFORMAT_BC1;
+		else if (!strcmp(argv[i], "-bc3"))		iFormat = BLOCKFORMAT_BC3;
+		else if (!strcmp(argv[i], "-box"))		iMipmaps = MIPFILTER_BOX;
+		else if (!strcmp(argv[i], "-kaiser"))	iMipmaps = MIPFILTER_KAISER;
+		else if (!strcmp(argv[i], "-nomips"))	iMipmaps = -1;
+		else if (!pInput)						pInput = argv[i];
+		else if (!pOutput)						pOutput = argv[i];
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	if (!pInput || !pOutput)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	int width = 0;
+	int height = 0;
+	int bpp = 0;
+	unsigned char* pPixels = stbi_load(pInput, &width, &height, &bpp, STBI_rgb_alpha);
+	if (!pPixels || !width || !height)
+	{
+		printf("texconv: failed to load %s\n", pInput);
+		return 1;
+	}
+
+	// same conversion as COpenGLRenderer::CreateTexture does at load time
+	const size_t uPixelCount = (size_t)width * height;
+	PixelKernels::PremultiplyAlpha(pPixels, uPixelCount);
+	std::vector<unsigned char> arrLevels(pPixels, pPixels + uPixelCount * 4);
+	stbi_image_free(pPixels);
+
+	if (iFormat < 0)
+	{
+		iFormat = BLOCKFORMAT_BC1;
+		for (size_t i = 3; i < arrLevels.size(); i += 4)
+		{
+			if (arrLevels[i] != 255)
+			{
+				iFormat = BLOCKFORMAT_BC3;
+				break;
+			}
+		}
+	}
+
+	if (iMipmaps >= 0)
+	{
+		PixelKernels::BuildMipChain(arrLevels, width, height, (MIPFILTER)iMipmaps);
+	}
+
+	JobSystem jobs;
+	jobs.Create();
+
+	TextureCompression::IMAGE image;
+	image.eFormat = (BLOCKFORMAT)iFormat;
+	image.iWidth = width;
+	image.iHeight = height;
+	image.uLevels = (iMipmaps >= 0) ? PixelKernels::GetMipLevelCount(width, height) : 1;
+
+	size_t uSourceOffset = 0;
+	int32_t w = width;
+	int32_t h = height;
+	for (uint32_t i=0; i<image.uLevels; i++)
+	{
+		const size_t uOffset = image.arrData.size();
+		image.arrData.resize(uOffset + TextureCompression::GetLevelSize(image.eFormat, w, h));
+		TextureCompression::Encode(&arrLevels[uSourceOffset], w, h, image.eFormat, &image.arrData[uOffset], &jobs);
+
+		uSourceOffset += (size_t)w * h * 4;
+		w = std::max(w / 2, 1);
+		h = std::max(h / 2, 1);
+	}
+	jobs.Destroy();
+
+	if (!TextureCompression::SaveDDS(pOutput, image))
+	{
+		printf("texconv: failed to write %s\n", pOutput);
+		return 1;
+	}
+
+	printf("%s: %dx%d, %s, %u levels\n", pInput, width, height, (image.eFormat == BLOCKFORMAT_BC1) ? "BC1" : "BC3", image.uLevels);
+	printf("  source file %zu bytes, RGBA8 in VRAM %zu bytes, compressed %zu bytes\n",
+		GetFileSize(pInput), uSourceOffset, image.arrData.size());
+
+	std::vector<unsigned char> arrDecoded(uPixelCount * 4);
+	TextureCompression::Decode(image.arrData.data(), width, height, image.eFormat, arrDecoded.data());
+	PrintQuality(arrLevels.data(), arrDecoded.data(), uPixelCount);
+	return 0;
+}